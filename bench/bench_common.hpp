@@ -0,0 +1,250 @@
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <utility>
+#include <cmath>
+#include <cstddef>
+#include <benchmark/benchmark.h>
+
+#include "chart_impl.hpp"
+
+namespace bench {
+
+/*! Heap usage of the whole process, maintained by the replacement of the global operator
+    new/delete in bench_main.cpp. It sees the arena blocks of the charts as well as every
+    allocation done outside of them.
+*/
+struct heap_counters
+{
+	std::atomic<std::size_t> allocations;
+	std::atomic<std::size_t> live_bytes;
+};
+heap_counters& heap();
+
+class heap_probe
+{
+	// Heap activity since construction (or 'reset')
+	public:
+		heap_probe() { this->reset();};
+
+		void reset()
+		{
+			_allocations = heap().allocations.load();
+			_live_bytes = heap().live_bytes.load();
+		};
+
+		std::size_t allocations() const { return heap().allocations.load() - _allocations;};
+		double bytes() const { return static_cast<double>(heap().live_bytes.load()) - static_cast<double>(_live_bytes);};
+
+	protected:
+		std::size_t _allocations, _live_bytes;
+};
+
+
+/*! Charts under test: compact elements with a weight as edge inner object, for every
+    behaviour and edge set policy.
+*/
+struct weight
+{
+	double value;
+};
+
+template <int Behaviour, class EdgeSet = core::graph::flat_edge_set<2> >
+struct bench_chart
+{
+	struct edge;
+	struct vertex : core::graph::detail::compact_vertex<edge, Behaviour, void, void, EdgeSet> {};
+	struct edge : core::graph::detail::compact_edge<vertex, edge, Behaviour, void, weight>
+	{
+		edge(std::shared_ptr<weight> w) : core::graph::detail::compact_edge<vertex, edge, Behaviour, void, weight>(w) {};
+	};
+	typedef core::graph::chart<vertex, edge, Behaviour> type;
+};
+
+inline const char* behaviour_name(int behaviour)
+{
+	return behaviour == core::graph::UNDIRECTED ? "undirected" : behaviour == core::graph::BIDIRECTIONAL ? "bidirectional" : "directed";
+}
+
+
+/*! Graph shapes, as edge lists over [0, n_vertices):
+      - RANDOM: uniform endpoints, average degree 8;
+      - POWER_LAW: R-MAT (a=0.57, b=c=0.19), average degree 8, a few hubs;
+      - GRID: square lattice, edges to the right and down;
+      - CHAIN: a single path.
+*/
+enum _e_shape { RANDOM, POWER_LAW, GRID, CHAIN, N_SHAPES };
+
+struct shape
+{
+	std::size_t n_vertices;
+	std::vector<std::pair<std::size_t, std::size_t> > edges;
+	std::vector<double> weights; // uniform in [0, 10)
+};
+
+inline const char* shape_name(int s)
+{
+	static const char* names[N_SHAPES] = {"random", "power_law", "grid", "chain"};
+	return names[s];
+}
+
+inline shape make_shape(int s, std::size_t n_edges, unsigned seed = 42)
+{
+	std::mt19937_64 rng(seed);
+	shape result;
+	result.edges.reserve(n_edges);
+	switch (s)
+	{
+		case RANDOM:
+		{
+			result.n_vertices = std::max<std::size_t>(2, n_edges/8);
+			std::uniform_int_distribution<std::size_t> vertex(0, result.n_vertices - 1);
+			for (std::size_t e = 0; e < n_edges; ++e)
+			{
+				const std::size_t source = vertex(rng);
+				result.edges.push_back(std::make_pair(source, vertex(rng)));
+			}
+			break;
+		}
+		case POWER_LAW:
+		{
+			std::size_t scale = 1;
+			while ((std::size_t(1) << scale) < std::max<std::size_t>(2, n_edges/8))
+			{
+				++scale;
+			}
+			result.n_vertices = std::size_t(1) << scale;
+			std::uniform_real_distribution<double> quadrant(0.0, 1.0);
+			for (std::size_t e = 0; e < n_edges; ++e)
+			{
+				std::size_t source = 0, target = 0;
+				for (std::size_t bit = 0; bit < scale; ++bit)
+				{
+					const double q = quadrant(rng);
+					source = 2*source + (q >= 0.76 ? 1 : 0);
+					target = 2*target + ((q >= 0.57 && q < 0.76) || q >= 0.95 ? 1 : 0);
+				}
+				result.edges.push_back(std::make_pair(source, target));
+			}
+			break;
+		}
+		case GRID:
+		{
+			const std::size_t side = std::max<std::size_t>(2, static_cast<std::size_t>(std::sqrt(n_edges/2.0)) + 1);
+			result.n_vertices = side*side;
+			for (std::size_t v = 0; v < result.n_vertices && result.edges.size() < n_edges; ++v)
+			{
+				if ((v + 1) % side)
+				{
+					result.edges.push_back(std::make_pair(v, v + 1));
+				}
+				if (v + side < result.n_vertices && result.edges.size() < n_edges)
+				{
+					result.edges.push_back(std::make_pair(v, v + side));
+				}
+			}
+			break;
+		}
+		default: // CHAIN
+		{
+			result.n_vertices = n_edges + 1;
+			for (std::size_t v = 0; v < n_edges; ++v)
+			{
+				result.edges.push_back(std::make_pair(v, v + 1));
+			}
+			break;
+		}
+	}
+	std::uniform_real_distribution<double> w(0.0, 10.0);
+	result.weights.reserve(result.edges.size());
+	for (std::size_t e = 0; e < result.edges.size(); ++e)
+	{
+		result.weights.push_back(w(rng));
+	}
+	return result;
+}
+
+inline const shape& cached_shape(int s, std::size_t n_edges)
+{
+	// Shapes are shared by the benchmarks (and their repetitions), the last one is kept
+	static int last_shape = -1;
+	static std::size_t last_edges = 0;
+	static shape last;
+	if (s != last_shape || n_edges != last_edges)
+	{
+		last = shape();
+		last = make_shape(s, n_edges);
+		last_shape = s;
+		last_edges = n_edges;
+	}
+	return last;
+}
+
+template <class Chart>
+std::vector<typename Chart::vertex_id> add_vertices(Chart& chart, std::size_t n)
+{
+	std::vector<typename Chart::vertex_id> ids;
+	ids.reserve(n);
+	for (std::size_t v = 0; v < n; ++v)
+	{
+		ids.push_back(chart.add_vertex(std::make_shared<typename Chart::vertex_type>()).first);
+	}
+	return ids;
+}
+
+template <class Chart>
+std::vector<typename Chart::vertex_id> build(Chart& chart, const shape& g)
+{
+	const std::vector<typename Chart::vertex_id> ids = add_vertices(chart, g.n_vertices);
+	for (std::size_t e = 0; e < g.edges.size(); ++e)
+	{
+		chart.create_edge(std::make_shared<weight>(weight{g.weights[e]}), ids[g.edges[e].first], ids[g.edges[e].second]);
+	}
+	return ids;
+}
+
+
+/*! Arguments {shape, number of edges}: every shape from 1K to 10M edges. Use
+    --benchmark_filter to run a subset, the biggest charts take several GB.
+*/
+inline void shapes_and_sizes_up_to(benchmark::internal::Benchmark* b, long max_edges)
+{
+	b->ArgNames({"shape", "edges"});
+	for (int s = 0; s < N_SHAPES; ++s)
+	{
+		for (long n_edges = 1000; n_edges <= max_edges; n_edges *= 10)
+		{
+			b->Args({s, n_edges});
+		}
+	}
+	b->Unit(benchmark::kMillisecond);
+}
+
+inline void shapes_and_sizes(benchmark::internal::Benchmark* b)
+{
+	shapes_and_sizes_up_to(b, 10000000);
+}
+
+// Up to 100K edges, for the quadratic baselines
+inline void small_shapes_and_sizes(benchmark::internal::Benchmark* b)
+{
+	shapes_and_sizes_up_to(b, 100000);
+}
+
+inline void set_label(benchmark::State& state, int behaviour)
+{
+	state.SetLabel(std::string(behaviour_name(behaviour)) + "/" + shape_name(static_cast<int>(state.range(0))));
+}
+
+inline void set_per_item(benchmark::State& state, const char* name, double total, double items)
+{
+	// Average per item over all the iterations
+	state.counters[name] = benchmark::Counter(items > 0 ? total/items : 0.0);
+}
+
+}
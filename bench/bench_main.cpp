@@ -0,0 +1,68 @@
+
+#include <new>
+#include <cstdlib>
+
+#include "bench_common.hpp"
+
+/*! Global operator new/delete counting allocations and live bytes for 'bench::heap()'.
+    Every block is prefixed with its size (16 bytes, to keep the alignment of malloc).
+*/
+namespace {
+
+const std::size_t header_size = 16;
+
+bench::heap_counters counters = {{0}, {0}};
+
+void* counted_allocate(std::size_t size)
+{
+	void* block = std::malloc(size + header_size);
+	if (!block)
+	{
+		return 0;
+	}
+	*static_cast<std::size_t*>(block) = size;
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.live_bytes.fetch_add(size, std::memory_order_relaxed);
+	return static_cast<char*>(block) + header_size;
+}
+
+void counted_release(void* ptr)
+{
+	if (ptr)
+	{
+		void* block = static_cast<char*>(ptr) - header_size;
+		counters.live_bytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+		std::free(block);
+	}
+}
+
+void* counted_new(std::size_t size)
+{
+	void* ptr = counted_allocate(size);
+	if (!ptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+}
+
+namespace bench {
+
+heap_counters& heap() { return counters;}
+
+}
+
+void* operator new(std::size_t size) { return counted_new(size);}
+void* operator new[](std::size_t size) { return counted_new(size);}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_allocate(size);}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_allocate(size);}
+void operator delete(void* ptr) noexcept { counted_release(ptr);}
+void operator delete[](void* ptr) noexcept { counted_release(ptr);}
+void operator delete(void* ptr, std::size_t) noexcept { counted_release(ptr);}
+void operator delete[](void* ptr, std::size_t) noexcept { counted_release(ptr);}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_release(ptr);}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_release(ptr);}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,102 @@
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include "bench_common.hpp"
+#include "concurrent_chart.hpp"
+
+/*! Read throughput of a 'concurrent_chart' against the number of reader threads, alone and
+    with a writer publishing a new version continuously.
+*/
+namespace bench {
+
+typedef core::graph::concurrent_chart<bench_chart<core::graph::BIDIRECTIONAL>::type> shared_chart;
+
+shared_chart& get_shared_chart()
+{
+	// RANDOM, 100K edges, built on first use
+	static shared_chart* chart = 0;
+	static std::once_flag once;
+	std::call_once(once, []
+	{
+		chart = new shared_chart;
+		chart->update([](shared_chart::chart_type& c) { build(c, cached_shape(RANDOM, 100000));});
+	});
+	return *chart;
+}
+
+void read_snapshot(const shared_chart& chart, std::mt19937& rng, double& sum)
+{
+	// A read: take the latest version and walk the outgoing edges of 64 random vertices
+	const shared_chart::snapshot_ptr snapshot = chart.snapshot();
+	std::uniform_int_distribution<std::size_t> vertex(0, snapshot->num_vertices() - 1);
+	std::vector<std::size_t> edges;
+	for (int i = 0; i < 64; ++i)
+	{
+		edges.clear();
+		snapshot->get_edges_outgoing(vertex(rng), edges);
+		for (std::size_t e = 0; e < edges.size(); ++e)
+		{
+			sum += snapshot->get_edge_obj(edges[e]).value;
+		}
+	}
+}
+
+void bm_concurrent_reads(benchmark::State& state)
+{
+	shared_chart& chart = get_shared_chart();
+	std::mt19937 rng(static_cast<unsigned>(state.thread_index()));
+	double sum = 0;
+	for (auto _ : state)
+	{
+		read_snapshot(chart, rng, sum);
+	}
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_concurrent_reads)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+void bm_concurrent_reads_with_writer(benchmark::State& state)
+{
+	// The first thread also runs a writer adding and removing an edge in a loop
+	shared_chart& chart = get_shared_chart();
+	static std::atomic<bool> writing(false);
+	static std::thread writer;
+	static std::size_t first_version = 0;
+	if (state.thread_index() == 0)
+	{
+		first_version = chart.version();
+		writing.store(true);
+		writer = std::thread([&chart]
+		{
+			while (writing.load())
+			{
+				chart.update([](shared_chart::chart_type& c)
+				{
+					const auto edge = c.create_edge(std::make_shared<weight>(weight{1.0}), c.get_vertex_at(0), c.get_vertex_at(1)).first;
+					c.remove_edge(edge);
+				});
+			}
+		});
+	}
+
+	std::mt19937 rng(static_cast<unsigned>(state.thread_index()));
+	double sum = 0;
+	for (auto _ : state)
+	{
+		read_snapshot(chart, rng, sum);
+	}
+	benchmark::DoNotOptimize(sum);
+	state.SetItemsProcessed(state.iterations());
+
+	if (state.thread_index() == 0)
+	{
+		writing.store(false);
+		writer.join();
+		state.counters["versions"] = benchmark::Counter(static_cast<double>(chart.version() - first_version));
+	}
+}
+BENCHMARK(bm_concurrent_reads_with_writer)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+}
@@ -0,0 +1,197 @@
+
+#include <tuple>
+
+#include "bench_common.hpp"
+
+/*! Construction: one element at a time, in batches and with the parallel bulk loader.
+    Besides time, they report heap allocations per edge, live bytes per element (vertices
+    and edges, whatever allocated them) and the part of those carved from the chart arena.
+    'bm_create_edge_heap_baseline' does the same work on the global heap, to compare with.
+*/
+namespace bench {
+
+template <int Behaviour>
+void bm_add_vertex(benchmark::State& state)
+{
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const std::size_t n = static_cast<std::size_t>(state.range(0));
+	double allocations = 0;
+	for (auto _ : state)
+	{
+		std::unique_ptr<chart_type> chart(new chart_type);
+		heap_probe probe;
+		add_vertices(*chart, n);
+		allocations += probe.allocations();
+		state.PauseTiming();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	state.SetLabel(behaviour_name(Behaviour));
+	state.SetItemsProcessed(state.iterations()*n);
+	set_per_item(state, "allocs/vertex", allocations, static_cast<double>(state.iterations()*n));
+}
+BENCHMARK_TEMPLATE(bm_add_vertex, core::graph::DIRECTED)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add_vertex, core::graph::UNDIRECTED)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_add_vertex, core::graph::BIDIRECTIONAL)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+
+template <int Behaviour>
+void bm_create_edge(benchmark::State& state)
+{
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	double allocations = 0, bytes = 0, arena_bytes = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		heap_probe probe;
+		const std::vector<typename chart_type::vertex_id> ids = add_vertices(*chart, g.n_vertices);
+		const std::size_t vertex_allocations = probe.allocations();
+		state.ResumeTiming();
+
+		for (std::size_t e = 0; e < g.edges.size(); ++e)
+		{
+			chart->create_edge(std::make_shared<weight>(weight{g.weights[e]}), ids[g.edges[e].first], ids[g.edges[e].second]);
+		}
+
+		state.PauseTiming();
+		allocations += probe.allocations() - vertex_allocations;
+		bytes += probe.bytes() - static_cast<double>(ids.capacity()*sizeof(typename chart_type::vertex_id));
+		arena_bytes += static_cast<double>(chart->get_arena()->get_bytes_used());
+		chart.reset();
+		state.ResumeTiming();
+	}
+	set_label(state, Behaviour);
+	const double n_edges = static_cast<double>(state.iterations()*g.edges.size());
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	set_per_item(state, "allocs/edge", allocations, n_edges);
+	set_per_item(state, "bytes/element", bytes, n_edges + state.iterations()*g.n_vertices);
+	set_per_item(state, "arena_bytes/element", arena_bytes, n_edges + state.iterations()*g.n_vertices);
+}
+BENCHMARK_TEMPLATE(bm_create_edge, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_create_edge, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_create_edge, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_create_edge_heap_baseline(benchmark::State& state)
+{
+	/* Baseline of 'bm_create_edge' without the arena: the layout of the chart graph with
+	   boost::listS and the elements from std::make_shared, all on the global heap.
+	*/
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	typedef boost::property<boost::vertex_index_t, std::size_t, typename chart_type::vertex_type_ptr> vertex_property;
+	typedef boost::property<boost::edge_index_t, std::size_t, typename chart_type::edge_type_ptr> edge_property;
+	typedef boost::adjacency_list<boost::listS, boost::listS, typename chart_type::behaviour, vertex_property, edge_property, boost::no_property, boost::listS> graph_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	double allocations = 0, bytes = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<graph_type> graph(new graph_type);
+		heap_probe probe;
+		std::vector<typename graph_type::vertex_descriptor> ids;
+		ids.reserve(g.n_vertices);
+		for (std::size_t v = 0; v < g.n_vertices; ++v)
+		{
+			ids.push_back(boost::add_vertex(vertex_property(v, std::make_shared<typename chart_type::vertex_type>()), *graph));
+		}
+		const std::size_t vertex_allocations = probe.allocations();
+		state.ResumeTiming();
+
+		for (std::size_t e = 0; e < g.edges.size(); ++e)
+		{
+			boost::add_edge(ids[g.edges[e].first], ids[g.edges[e].second],
+			                edge_property(e, std::make_shared<typename chart_type::edge_type>(std::make_shared<weight>(weight{g.weights[e]}))), *graph);
+		}
+
+		state.PauseTiming();
+		allocations += probe.allocations() - vertex_allocations;
+		bytes += probe.bytes() - static_cast<double>(ids.capacity()*sizeof(typename graph_type::vertex_descriptor));
+		graph.reset();
+		state.ResumeTiming();
+	}
+	set_label(state, Behaviour);
+	const double n_edges = static_cast<double>(state.iterations()*g.edges.size());
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	set_per_item(state, "allocs/edge", allocations, n_edges);
+	set_per_item(state, "bytes/element", bytes, n_edges + state.iterations()*g.n_vertices);
+}
+BENCHMARK_TEMPLATE(bm_create_edge_heap_baseline, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_create_edge_heap_baseline, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_create_edge_heap_baseline, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_add_edges(benchmark::State& state)
+{
+	// Batch insertion, the edges are created inside the timed region as with 'create_edge'
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	typedef typename bench_chart<Behaviour>::edge edge_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	double allocations = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		const std::vector<typename chart_type::vertex_id> ids = add_vertices(*chart, g.n_vertices);
+		heap_probe probe;
+		state.ResumeTiming();
+
+		std::vector<typename chart_type::edge_entry> entries;
+		entries.reserve(g.edges.size());
+		for (std::size_t e = 0; e < g.edges.size(); ++e)
+		{
+			entries.push_back(typename chart_type::edge_entry(std::make_shared<edge_type>(std::make_shared<weight>(weight{g.weights[e]})), ids[g.edges[e].first], ids[g.edges[e].second]));
+		}
+		chart->add_edges(entries);
+
+		state.PauseTiming();
+		allocations += probe.allocations();
+		entries.clear();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	set_per_item(state, "allocs/edge", allocations, static_cast<double>(state.iterations()*g.edges.size()));
+}
+BENCHMARK_TEMPLATE(bm_add_edges, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_add_edges, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_add_edges, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_parallel_add_edges(benchmark::State& state)
+{
+	/* Same work as 'bm_add_edges' with 'threads' loader threads ('0' for all the cores), the
+	   edges are taken from the chart arena as 'create_edge' does so the loader threads
+	   allocate from their own slabs (see 'arena_thread_cache'). 'threads' = 1 against the
+	   others gives the scaling, 'bm_add_edges' on random shapes the serial baseline.
+	*/
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	typedef typename bench_chart<Behaviour>::edge edge_type;
+	typedef core::graph::detail::arena_allocator<edge_type> allocator_type;
+	const shape& g = cached_shape(RANDOM, static_cast<std::size_t>(state.range(0)));
+	const unsigned n_threads = static_cast<unsigned>(state.range(1));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		const std::vector<typename chart_type::vertex_id> ids = add_vertices(*chart, g.n_vertices);
+		const allocator_type allocator(chart->get_arena());
+		state.ResumeTiming();
+
+		chart->parallel_add_edges(g.edges.size(), [&](std::size_t e)
+		{
+			return typename chart_type::edge_entry(std::allocate_shared<edge_type>(allocator, std::make_shared<weight>(weight{g.weights[e]})), ids[g.edges[e].first], ids[g.edges[e].second]);
+		}, n_threads);
+
+		state.PauseTiming();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	state.SetLabel(std::string(behaviour_name(Behaviour)) + "/random");
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_parallel_add_edges, core::graph::DIRECTED)->ArgNames({"edges", "threads"})->ArgsProduct({{100000, 1000000, 10000000}, {1, 2, 4, 8, 16, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_parallel_add_edges, core::graph::UNDIRECTED)->ArgNames({"edges", "threads"})->ArgsProduct({{100000, 1000000, 10000000}, {1, 2, 4, 8, 16, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_parallel_add_edges, core::graph::BIDIRECTIONAL)->ArgNames({"edges", "threads"})->ArgsProduct({{100000, 1000000, 10000000}, {1, 2, 4, 8, 16, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
+}
@@ -0,0 +1,149 @@
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench_common.hpp"
+#include "chart_io.hpp"
+
+#ifdef BENCH_READ_GRAPHVIZ
+#include <boost/graph/graphviz.hpp>
+#endif
+
+/*! Text import/export: DOT and edge list writers, the chunked edge list reader against the
+    number of threads and, when libboost_graph is available (see CMakeLists.txt), the same
+    graph read as DOT by 'boost::read_graphviz'. Files live in memory (std::stringstream),
+    so the figures are for formatting and parsing, not the disk.
+*/
+namespace bench {
+
+struct weight_label
+{
+	template <class Edge>
+	void operator()(const Edge& edge, std::string& label) const
+	{
+		char buffer[32];
+		label.append(buffer, std::snprintf(buffer, sizeof(buffer), "%.3f", edge.get_obj().value));
+	};
+};
+
+template <class Chart>
+std::string edge_list_text(const Chart& chart)
+{
+	std::ostringstream out;
+	core::graph::write_edge_list(out, chart, weight_label());
+	return out.str();
+}
+
+template <int Behaviour>
+void bm_write_graphviz(benchmark::State& state)
+{
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	chart_type chart;
+	build(chart, g);
+	std::size_t bytes = 0;
+	for (auto _ : state)
+	{
+		std::ostringstream out;
+		core::graph::write_graphviz(out, chart, core::graph::no_label(), weight_label());
+		bytes += static_cast<std::size_t>(out.tellp());
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	state.SetBytesProcessed(bytes);
+}
+BENCHMARK_TEMPLATE(bm_write_graphviz, core::graph::DIRECTED)->Apply(small_shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_write_graphviz, core::graph::UNDIRECTED)->Apply(small_shapes_and_sizes);
+
+template <int Behaviour>
+void bm_write_edge_list(benchmark::State& state)
+{
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	chart_type chart;
+	build(chart, g);
+	std::size_t bytes = 0;
+	for (auto _ : state)
+	{
+		std::ostringstream out;
+		core::graph::write_edge_list(out, chart, weight_label());
+		bytes += static_cast<std::size_t>(out.tellp());
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	state.SetBytesProcessed(bytes);
+}
+BENCHMARK_TEMPLATE(bm_write_edge_list, core::graph::DIRECTED)->Apply(small_shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_write_edge_list, core::graph::UNDIRECTED)->Apply(small_shapes_and_sizes);
+
+void bm_read_edge_list(benchmark::State& state)
+{
+	// RANDOM shape with weights as labels, parsed by 'threads' threads into a DIRECTED chart
+	typedef bench_chart<core::graph::DIRECTED>::type chart_type;
+	const std::size_t n_edges = static_cast<std::size_t>(state.range(0));
+	const unsigned n_threads = static_cast<unsigned>(state.range(1));
+	std::string text;
+	{
+		chart_type chart;
+		build(chart, cached_shape(RANDOM, n_edges));
+		text = edge_list_text(chart);
+	}
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		std::istringstream in(text);
+		state.ResumeTiming();
+
+		core::graph::read_edge_list(in, *chart,
+			[](std::uint64_t) { return std::make_shared<chart_type::vertex_type>();},
+			[](const char* begin, const char*) { return std::make_shared<chart_type::edge_type>(std::make_shared<weight>(weight{std::strtod(begin, 0)}));},
+			n_threads, 1 << 20);
+
+		state.PauseTiming();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	state.SetLabel("directed/random");
+	state.SetItemsProcessed(state.iterations()*n_edges);
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(bm_read_edge_list)->ArgNames({"edges", "threads"})->ArgsProduct({{100000, 1000000}, {1, 2, 4, 8}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+#ifdef BENCH_READ_GRAPHVIZ
+void bm_boost_read_graphviz(benchmark::State& state)
+{
+	// Baseline for 'bm_read_edge_list': the same graph as DOT, into a boost graph holding the weights
+	typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, boost::no_property, boost::property<boost::edge_weight_t, double> > graph_type;
+	const std::size_t n_edges = static_cast<std::size_t>(state.range(0));
+	std::string text;
+	{
+		bench_chart<core::graph::DIRECTED>::type chart;
+		build(chart, cached_shape(RANDOM, n_edges));
+		std::ostringstream out;
+		core::graph::write_graphviz(out, chart, core::graph::no_label(), weight_label());
+		text = out.str();
+	}
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		graph_type graph;
+		boost::dynamic_properties properties(boost::ignore_other_properties);
+		properties.property("label", boost::get(boost::edge_weight, graph));
+		state.ResumeTiming();
+
+		if (!boost::read_graphviz(text, graph, properties))
+		{
+			state.SkipWithError("boost::read_graphviz failed");
+			break;
+		}
+		benchmark::DoNotOptimize(boost::num_edges(graph));
+	}
+	state.SetLabel("directed/random");
+	state.SetItemsProcessed(state.iterations()*n_edges);
+	state.SetBytesProcessed(state.iterations()*text.size());
+}
+BENCHMARK(bm_boost_read_graphviz)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+
+}
@@ -0,0 +1,256 @@
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <type_traits>
+
+#include "bench_common.hpp"
+
+/*! Mutation and teardown: removing edges, destroying a whole chart against removing its
+    elements one by one, a mixed workload over several vertex degrees for every edge set
+    policy and the memory taken by the chart back-reference of the edges.
+*/
+namespace bench {
+
+template <int Behaviour>
+void bm_remove_edge(benchmark::State& state)
+{
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		build(*chart, g);
+		std::vector<typename chart_type::edge_id> edges;
+		edges.reserve(chart->num_edges());
+		for (std::size_t e = 0; e < chart->num_edges(); ++e)
+		{
+			edges.push_back(chart->get_edge_at(e));
+		}
+		std::shuffle(edges.begin(), edges.end(), std::mt19937(7));
+		state.ResumeTiming();
+
+		for (typename std::vector<typename chart_type::edge_id>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+		{
+			chart->remove_edge(*it);
+		}
+
+		state.PauseTiming();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_remove_edge, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_remove_edge, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_remove_edge, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_teardown(benchmark::State& state)
+{
+	// ~chart_impl, through 'clear()'
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		build(*chart, g);
+		state.ResumeTiming();
+
+		chart.reset();
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*(g.n_vertices + g.edges.size()));
+}
+BENCHMARK_TEMPLATE(bm_teardown, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_teardown_one_by_one(benchmark::State& state)
+{
+	// Reference for 'bm_teardown': every vertex removed (with its edges) through the public API
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		const std::vector<typename chart_type::vertex_id> ids = build(*chart, g);
+		state.ResumeTiming();
+
+		for (typename std::vector<typename chart_type::vertex_id>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+		{
+			chart->remove_vertex(*it);
+		}
+		chart.reset();
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*(g.n_vertices + g.edges.size()));
+}
+BENCHMARK_TEMPLATE(bm_teardown_one_by_one, core::graph::DIRECTED)->Apply(small_shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown_one_by_one, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown_one_by_one, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_teardown_per_element(benchmark::State& state)
+{
+	// Baseline for 'bm_teardown': the loop ~chart_impl ran before 'clear()', every edge then every vertex
+	typedef typename bench_chart<Behaviour>::type chart_type;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		build(*chart, g);
+		state.ResumeTiming();
+
+		while (chart->num_edges())
+		{
+			chart->remove_edge(chart->get_edge_at(0));
+		}
+		while (chart->num_vertices())
+		{
+			chart->remove_vertex(chart->get_vertex_at(0));
+		}
+		chart.reset();
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*(g.n_vertices + g.edges.size()));
+}
+BENCHMARK_TEMPLATE(bm_teardown_per_element, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown_per_element, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_teardown_per_element, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour, class EdgeSet>
+void bm_degree_workload(benchmark::State& state)
+{
+	// Insert, traverse and remove the edges of 100K vertices of a given (uniform) degree
+	typedef typename bench_chart<Behaviour, EdgeSet>::type chart_type;
+	static const std::size_t n_vertices = 100000;
+	const std::size_t degree = static_cast<std::size_t>(state.range(0));
+	std::mt19937 rng(3);
+	std::uniform_int_distribution<std::size_t> vertex(0, n_vertices - 1);
+	std::vector<std::size_t> targets(n_vertices*degree);
+	for (std::size_t i = 0; i < targets.size(); ++i)
+	{
+		targets[i] = vertex(rng);
+	}
+
+	std::size_t visited = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		const std::vector<typename chart_type::vertex_id> ids = add_vertices(*chart, n_vertices);
+		state.ResumeTiming();
+
+		std::vector<typename chart_type::edge_id> edges;
+		edges.reserve(targets.size());
+		for (std::size_t i = 0; i < targets.size(); ++i)
+		{
+			edges.push_back(chart->create_edge(std::make_shared<weight>(weight{1.0}), ids[i/degree], ids[targets[i]]).first);
+		}
+		for (std::size_t v = 0; v < n_vertices; ++v)
+		{
+			for (auto e : chart->out_edges(ids[v]))
+			{
+				visited += (chart->get_edge(e) != 0);
+			}
+		}
+		for (std::size_t i = 0; i < edges.size(); ++i)
+		{
+			chart->remove_edge(edges[i]);
+		}
+
+		state.PauseTiming();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	benchmark::DoNotOptimize(visited);
+	state.SetLabel(behaviour_name(Behaviour));
+	state.SetItemsProcessed(state.iterations()*targets.size());
+}
+BENCHMARK_TEMPLATE(bm_degree_workload, core::graph::DIRECTED, core::graph::flat_edge_set<2>)->ArgName("degree")->Arg(2)->Arg(8)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_degree_workload, core::graph::DIRECTED, core::graph::ordered_edge_set)->ArgName("degree")->Arg(2)->Arg(8)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_degree_workload, core::graph::BIDIRECTIONAL, core::graph::flat_edge_set<2>)->ArgName("degree")->Arg(2)->Arg(8)->Arg(20)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_degree_workload, core::graph::BIDIRECTIONAL, core::graph::ordered_edge_set)->ArgName("degree")->Arg(2)->Arg(8)->Arg(20)->Unit(benchmark::kMillisecond);
+
+
+/*! Edges of 'bm_edge_footprint', by the way they know their chart: not at all, through the
+    chart pointer and dense index of 'edge_chart', or through the 'std::function' disconnect
+    callback they held before it (a lambda capturing the chart and an iterator of its index).
+*/
+enum _e_edge_layout { NO_CHART, CHART_POINTER, CHART_CALLBACK };
+
+template <bool>
+struct disconnect_callback {};
+
+template <>
+struct disconnect_callback<true>
+{
+	disconnect_callback()
+	{
+		void* chart = this;
+		std::map<void*, std::size_t>::iterator it;
+		callback = [chart, it]() { benchmark::DoNotOptimize(chart);};
+	};
+
+	std::function<void()> callback;
+};
+
+template <int Behaviour, int Layout>
+struct footprint_chart
+{
+	struct edge;
+	struct vertex : core::graph::detail::compact_vertex<edge, Behaviour> {};
+	typedef core::graph::chart<vertex, edge, Behaviour> type;
+	typedef typename std::conditional<Layout == CHART_POINTER, type, void>::type graph;
+	struct edge : core::graph::detail::compact_edge<vertex, edge, Behaviour, graph, weight>, disconnect_callback<Layout == CHART_CALLBACK>
+	{
+		edge(std::shared_ptr<weight> w) : core::graph::detail::compact_edge<vertex, edge, Behaviour, graph, weight>(w) {};
+	};
+};
+
+template <int Behaviour, int Layout>
+void bm_edge_footprint(benchmark::State& state)
+{
+	// Heap taken by 'create_edge' per edge (arena blocks included), and the size of the edge object
+	typedef typename footprint_chart<Behaviour, Layout>::type chart_type;
+	const shape& g = cached_shape(RANDOM, static_cast<std::size_t>(state.range(0)));
+	double bytes = 0;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		std::unique_ptr<chart_type> chart(new chart_type);
+		const std::vector<typename chart_type::vertex_id> ids = add_vertices(*chart, g.n_vertices);
+		heap_probe probe;
+		state.ResumeTiming();
+
+		for (std::size_t e = 0; e < g.edges.size(); ++e)
+		{
+			chart->create_edge(std::make_shared<weight>(weight{g.weights[e]}), ids[g.edges[e].first], ids[g.edges[e].second]);
+		}
+
+		state.PauseTiming();
+		bytes += probe.bytes();
+		chart.reset();
+		state.ResumeTiming();
+	}
+	static const char* layouts[] = {"no chart", "chart pointer", "std::function"};
+	state.SetLabel(std::string(behaviour_name(Behaviour)) + "/" + layouts[Layout]);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+	set_per_item(state, "bytes/edge", bytes, static_cast<double>(state.iterations()*g.edges.size()));
+	state.counters["sizeof(edge)"] = sizeof(typename chart_type::edge_type);
+}
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::UNDIRECTED, NO_CHART)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::UNDIRECTED, CHART_POINTER)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::UNDIRECTED, CHART_CALLBACK)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::BIDIRECTIONAL, NO_CHART)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::BIDIRECTIONAL, CHART_POINTER)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_edge_footprint, core::graph::BIDIRECTIONAL, CHART_CALLBACK)->ArgName("edges")->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+}
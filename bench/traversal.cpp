@@ -0,0 +1,303 @@
+
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+#include <boost/property_map/function_property_map.hpp>
+
+#include "bench_common.hpp"
+
+/*! Traversals and algorithms over a chart built once per benchmark (outside the timing):
+    adjacency iteration in its several flavours, connected components, searches and
+    shortest paths, with boost::dijkstra_shortest_paths on the chart's own graph as the
+    reference.
+*/
+namespace bench {
+
+template <int Behaviour>
+struct built_chart
+{
+	// Chart of the current benchmark arguments
+	typedef typename bench_chart<Behaviour>::type chart_type;
+
+	built_chart(const benchmark::State& state) : g(cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1))))
+	{
+		ids = build(chart, g);
+	};
+
+	const shape& g;
+	chart_type chart;
+	std::vector<typename chart_type::vertex_id> ids;
+};
+
+template <int Behaviour>
+void bm_out_edges(benchmark::State& state)
+{
+	// Allocation-free ranges
+	built_chart<Behaviour> built(state);
+	double sum = 0;
+	for (auto _ : state)
+	{
+		for (std::size_t v = 0; v < built.ids.size(); ++v)
+		{
+			for (auto e : built.chart.out_edges(built.ids[v]))
+			{
+				sum += built.chart.get_edge(e)->get_obj().value;
+			}
+		}
+	}
+	benchmark::DoNotOptimize(sum);
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_out_edges, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_out_edges, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_out_edges, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+void bm_get_edges_outgoing(benchmark::State& state)
+{
+	// Vector-filling getter (BIDIRECTIONAL only), same work as 'bm_out_edges'
+	built_chart<core::graph::BIDIRECTIONAL> built(state);
+	std::vector<typename built_chart<core::graph::BIDIRECTIONAL>::chart_type::edge_id> edges;
+	double sum = 0;
+	for (auto _ : state)
+	{
+		for (std::size_t v = 0; v < built.ids.size(); ++v)
+		{
+			edges.clear();
+			built.chart.get_edges_outgoing(built.ids[v], edges);
+			for (std::size_t e = 0; e < edges.size(); ++e)
+			{
+				sum += built.chart.get_edge(edges[e])->get_obj().value;
+			}
+		}
+	}
+	benchmark::DoNotOptimize(sum);
+	set_label(state, core::graph::BIDIRECTIONAL);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK(bm_get_edges_outgoing)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_freeze(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	for (auto _ : state)
+	{
+		auto frozen = built.chart.freeze();
+		benchmark::DoNotOptimize(frozen.num_edges());
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_freeze, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_freeze, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_freeze, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_frozen_get_edges_outgoing(benchmark::State& state)
+{
+	// CSR snapshot, same work as 'bm_out_edges'
+	built_chart<Behaviour> built(state);
+	const auto frozen = built.chart.freeze();
+	std::vector<std::size_t> edges;
+	double sum = 0;
+	for (auto _ : state)
+	{
+		for (std::size_t v = 0; v < frozen.num_vertices(); ++v)
+		{
+			edges.clear();
+			frozen.get_edges_outgoing(v, edges);
+			for (std::size_t e = 0; e < edges.size(); ++e)
+			{
+				sum += frozen.get_edges()[edges[e]]->get_obj().value;
+			}
+		}
+	}
+	benchmark::DoNotOptimize(sum);
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_frozen_get_edges_outgoing, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_frozen_get_edges_outgoing, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_frozen_get_edges_outgoing, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_connected_components(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	typename built_chart<Behaviour>::chart_type::_t_connected_components components;
+	for (auto _ : state)
+	{
+		components.clear();
+		benchmark::DoNotOptimize(built.chart.connected_components(components));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_connected_components, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_connected_components, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_parallel_connected_components(benchmark::State& state)
+{
+	// Dense indices and all the cores
+	built_chart<Behaviour> built(state);
+	std::vector<std::size_t> components;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.connected_components(components, 0));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_parallel_connected_components, core::graph::DIRECTED)->Apply(shapes_and_sizes)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_parallel_connected_components, core::graph::UNDIRECTED)->Apply(shapes_and_sizes)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_parallel_connected_components, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes)->UseRealTime();
+
+template <int Behaviour>
+void bm_strong_components(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	std::vector<std::size_t> components;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.strong_components(components));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_strong_components, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_strong_components, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_parallel_strong_components(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	std::vector<std::size_t> components;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.strong_components(components, 0));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_parallel_strong_components, core::graph::DIRECTED)->Apply(shapes_and_sizes)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_parallel_strong_components, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes)->UseRealTime();
+
+template <int Behaviour>
+void bm_topological_order(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	std::vector<std::size_t> order;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.topological_order(order));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_topological_order, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_breadth_first(benchmark::State& state)
+{
+	typedef typename built_chart<Behaviour>::chart_type chart_type;
+	built_chart<Behaviour> built(state);
+	core::graph::search<chart_type> search(built.chart);
+	core::graph::search_visitor<chart_type> visitor;
+	for (auto _ : state)
+	{
+		search.reset();
+		search.breadth_first(built.ids[0], visitor);
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_breadth_first, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_breadth_first, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_breadth_first, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+void bm_parallel_breadth_first(benchmark::State& state)
+{
+	// Direction-optimizing, BIDIRECTIONAL only
+	built_chart<core::graph::BIDIRECTIONAL> built(state);
+	std::vector<std::size_t> distance, parent;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.parallel_breadth_first(built.ids[0], distance, parent, 0));
+	}
+	set_label(state, core::graph::BIDIRECTIONAL);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK(bm_parallel_breadth_first)->Apply(shapes_and_sizes)->UseRealTime();
+
+double weight_of(const weight& w) { return w.value;}
+
+template <int Behaviour>
+void bm_dijkstra(benchmark::State& state)
+{
+	built_chart<Behaviour> built(state);
+	std::vector<double> distance;
+	std::vector<std::size_t> parent;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.dijkstra_shortest_paths(built.ids[0], weight_of, distance, parent));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_dijkstra, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_dijkstra, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_dijkstra, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+template <int Behaviour>
+void bm_delta_stepping(benchmark::State& state)
+{
+	// delta: the average weight
+	built_chart<Behaviour> built(state);
+	std::vector<double> distance;
+	std::vector<std::size_t> parent;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(built.chart.delta_stepping_shortest_paths(built.ids[0], weight_of, 5.0, distance, parent, 0));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*built.g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_delta_stepping, core::graph::DIRECTED)->Apply(shapes_and_sizes)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_delta_stepping, core::graph::UNDIRECTED)->Apply(shapes_and_sizes)->UseRealTime();
+BENCHMARK_TEMPLATE(bm_delta_stepping, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes)->UseRealTime();
+
+template <class Chart>
+struct chart_with_graph : Chart
+{
+	// The boost graph inside the chart, for the reference algorithms
+	const typename Chart::_t_graph& get_graph() const { return this->_graph;};
+};
+
+template <int Behaviour>
+void bm_boost_dijkstra(benchmark::State& state)
+{
+	// Reference: boost on the chart's own graph, with its vertex index map and edge weights
+	typedef chart_with_graph<typename bench_chart<Behaviour>::type> chart_type;
+	typedef typename chart_type::edge_id edge_id;
+	const shape& g = cached_shape(static_cast<int>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+	chart_type chart;
+	const std::vector<typename chart_type::vertex_id> ids = build(chart, g);
+	const auto& graph = chart.get_graph();
+	std::vector<double> distance(chart.num_vertices());
+	std::vector<typename chart_type::vertex_id> parent(chart.num_vertices());
+	for (auto _ : state)
+	{
+		boost::dijkstra_shortest_paths(graph, ids[0],
+			boost::weight_map(boost::make_function_property_map<edge_id>([&graph](const edge_id& e) { return weight_of(graph[e]->get_obj());}))
+			.distance_map(boost::make_iterator_property_map(distance.begin(), chart.get_vertex_index_map()))
+			.predecessor_map(boost::make_iterator_property_map(parent.begin(), chart.get_vertex_index_map()))
+			.vertex_index_map(chart.get_vertex_index_map()));
+	}
+	set_label(state, Behaviour);
+	state.SetItemsProcessed(state.iterations()*g.edges.size());
+}
+BENCHMARK_TEMPLATE(bm_boost_dijkstra, core::graph::DIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_boost_dijkstra, core::graph::UNDIRECTED)->Apply(shapes_and_sizes);
+BENCHMARK_TEMPLATE(bm_boost_dijkstra, core::graph::BIDIRECTIONAL)->Apply(shapes_and_sizes);
+
+}
@@ -0,0 +1,546 @@
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <boost/range/iterator_range.hpp>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "traits.hpp"
+#include "chart_io.hpp"
+
+namespace core { namespace graph {
+
+/*! Binary on-disk format of a chart, meant to be memory mapped (see 'mapped_chart').
+
+    A header followed by sections of 64-bit words (or bytes for payloads), each one aligned
+    to 8 bytes and located through the header:
+      - sources, targets: endpoints of every edge;
+      - out_offsets/out_edges and in_offsets/in_edges: CSR adjacency, as in 'frozen_chart';
+      - vertex_payload_offsets/vertex_payload, and the same for edges: bytes written by the
+        user serializers, element 'i' spans [offsets[i], offsets[i+1]).
+    Vertices and edges are numbered by their dense index in the chart ('get_vertex_index',
+    'get_edge_index'), as in 'chart::freeze()'. The edges of every vertex are sorted by index.
+    DIRECTED charts have no incoming edges: their in_offsets are all zero. Integers are
+    stored in the byte order of the machine that wrote the file, loading it on a different
+    one fails.
+*/
+namespace binary_format
+{
+	enum _e_section { SOURCES, TARGETS, OUT_OFFSETS, OUT_EDGES, IN_OFFSETS, IN_EDGES,
+	                  VERTEX_PAYLOAD_OFFSETS, VERTEX_PAYLOAD, EDGE_PAYLOAD_OFFSETS, EDGE_PAYLOAD, N_SECTIONS };
+
+	static const char magic[8] = {'C', 'G', 'C', 'H', 'A', 'R', 'T', '\0'};
+	static const std::uint32_t version = 1;
+	static const std::uint32_t byte_order = 0x01020304;
+
+	struct section
+	{
+		std::uint64_t offset, size; // in bytes from the beginning of the file
+	};
+
+	struct header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t behaviour; // _e_behaviour
+		std::uint32_t reserved;
+		std::uint64_t n_vertices, n_edges;
+		section sections[N_SECTIONS];
+	};
+
+	// Serializer for charts without payloads
+	struct no_payload
+	{
+		template <class Element>
+		void operator()(const Element&, std::vector<char>&) const {};
+	};
+}
+
+namespace detail {
+
+template <class Word>
+void write_section(std::ofstream& file, binary_format::header& header, binary_format::_e_section id, const Word* data, std::size_t n)
+{
+	// Appends 'data' at the (8 bytes aligned) end of 'file'
+	static const char padding[8] = {0};
+	std::uint64_t offset = static_cast<std::uint64_t>(file.tellp());
+	file.write(padding, (8 - offset % 8) % 8);
+	offset += (8 - offset % 8) % 8;
+	header.sections[id].offset = offset;
+	header.sections[id].size = n*sizeof(Word);
+	if (n)
+	{
+		file.write(reinterpret_cast<const char*>(data), n*sizeof(Word));
+	}
+}
+
+class section_writer
+{
+	// Streams the 64-bit words of a section at the (8 bytes aligned) end of 'file'
+	public:
+		section_writer(std::ofstream& file, binary_format::header& header, binary_format::_e_section id) : _file(file), _header(header), _id(id)
+		{
+			write_section(file, header, id, (const std::uint64_t*)0, 0);
+			_buffer.reserve(capacity);
+		};
+
+		void push(std::uint64_t word)
+		{
+			_buffer.push_back(word);
+			if (_buffer.size() == capacity)
+			{
+				this->flush();
+			}
+		};
+
+		void close()
+		{
+			this->flush();
+			_header.sections[_id].size = static_cast<std::uint64_t>(_file.tellp()) - _header.sections[_id].offset;
+		};
+
+	protected:
+		void flush()
+		{
+			_file.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size()*sizeof(std::uint64_t));
+			_buffer.clear();
+		};
+
+	protected:
+		static const std::size_t capacity = 1 << 16;
+		std::ofstream& _file;
+		binary_format::header& _header;
+		binary_format::_e_section _id;
+		std::vector<std::uint64_t> _buffer;
+};
+
+template <class Element, class Serializer>
+void write_payloads(std::ofstream& file, binary_format::header& header, binary_format::_e_section offsets_id, binary_format::_e_section payload_id, std::size_t n, Element element, Serializer serializer)
+{
+	// Payloads are streamed element by element ('element(i)' points to the one of dense index 'i'), their offsets follow them
+	std::vector<std::uint64_t> offsets(1, 0);
+	offsets.reserve(n + 1);
+	std::vector<char> buffer;
+	write_section(file, header, payload_id, (const char*)0, 0);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		buffer.clear();
+		serializer(*element(i), buffer);
+		file.write(buffer.data(), buffer.size());
+		offsets.push_back(offsets.back() + buffer.size());
+	}
+	header.sections[payload_id].size = offsets.back();
+	write_section(file, header, offsets_id, offsets.data(), offsets.size());
+}
+
+template <class Chart, class Incident>
+void write_adjacency(std::ofstream& file, binary_format::header& header, binary_format::_e_section offsets_id, binary_format::_e_section edges_id, const Chart& chart, Incident incident)
+{
+	/* CSR of 'incident(v, edges)', which appends the dense indices of the edges of 'v'. Two
+	   passes, offsets then edges, so only the edges of one vertex are held at a time.
+	*/
+	std::vector<std::uint64_t> edges;
+	section_writer offsets(file, header, offsets_id);
+	std::uint64_t offset = 0;
+	offsets.push(offset);
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		edges.clear();
+		incident(v, edges);
+		offset += edges.size();
+		offsets.push(offset);
+	}
+	offsets.close();
+
+	section_writer adjacency(file, header, edges_id);
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		edges.clear();
+		incident(v, edges);
+		for (std::vector<std::uint64_t>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+		{
+			adjacency.push(*it);
+		}
+	}
+	adjacency.close();
+}
+
+template <class Chart, class Range>
+void append_edges(const Chart& chart, const Range& range, std::vector<std::uint64_t>& edges)
+{
+	// Sorted by index; self loops of UNDIRECTED charts are listed twice by boost, keep one
+	const std::size_t begin = edges.size();
+	for (typename boost::range_iterator<const Range>::type it = boost::begin(range); it != boost::end(range); ++it)
+	{
+		edges.push_back(chart.get_edge_index(*it));
+	}
+	std::sort(edges.begin() + begin, edges.end());
+	edges.erase(std::unique(edges.begin() + begin, edges.end()), edges.end());
+}
+
+template <class Chart>
+void append_incoming(const Chart& chart, std::size_t v, std::vector<std::uint64_t>& edges, boost::bidirectionalS)
+{
+	append_edges(chart, chart.in_edges(chart.get_vertex_at(v)), edges);
+}
+
+template <class Chart>
+void append_incoming(const Chart& chart, std::size_t v, std::vector<std::uint64_t>& edges, boost::undirectedS)
+{
+	append_edges(chart, chart.out_edges(chart.get_vertex_at(v)), edges);
+}
+
+template <class Chart>
+void append_incoming(const Chart&, std::size_t, std::vector<std::uint64_t>&, boost::directedS)
+{
+	// Not stored for DIRECTED charts
+}
+
+}
+
+/*! Writes 'chart' to 'path' in the binary format (see 'binary_format'). The serializers are
+    called as 'serializer(element, bytes)' for every vertex and edge and append whatever
+    they need to 'bytes' (usually from 'element.get_obj()', the inner object). The bytes are
+    given back as they are by 'mapped_chart'.
+*/
+template <class Chart, class VertexSerializer, class EdgeSerializer>
+void save_binary(const Chart& chart, const std::string& path, VertexSerializer vertex_serializer, EdgeSerializer edge_serializer)
+{
+	// Straight from the dense indices of the chart, section after section
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		throw std::runtime_error("cannot open '" + path + "' for writing");
+	}
+
+	binary_format::header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, binary_format::magic, sizeof(header.magic));
+	header.version = binary_format::version;
+	header.byte_order = binary_format::byte_order;
+	header.behaviour = std::is_same<typename Chart::behaviour, boost::undirectedS>::value ? UNDIRECTED :
+	                   std::is_same<typename Chart::behaviour, boost::bidirectionalS>::value ? BIDIRECTIONAL : DIRECTED;
+	header.n_vertices = chart.num_vertices();
+	header.n_edges = chart.num_edges();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	const detail::edge_endpoints<Chart> endpoints(chart);
+	detail::section_writer sources(file, header, binary_format::SOURCES);
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		sources.push(endpoints.source(e));
+	}
+	sources.close();
+	detail::section_writer targets(file, header, binary_format::TARGETS);
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		targets.push(endpoints.target(e));
+	}
+	targets.close();
+
+	detail::write_adjacency(file, header, binary_format::OUT_OFFSETS, binary_format::OUT_EDGES, chart, [&chart](std::size_t v, std::vector<std::uint64_t>& edges)
+	{
+		detail::append_edges(chart, chart.out_edges(chart.get_vertex_at(v)), edges);
+	});
+	detail::write_adjacency(file, header, binary_format::IN_OFFSETS, binary_format::IN_EDGES, chart, [&chart](std::size_t v, std::vector<std::uint64_t>& edges)
+	{
+		detail::append_incoming(chart, v, edges, typename Chart::behaviour());
+	});
+
+	detail::write_payloads(file, header, binary_format::VERTEX_PAYLOAD_OFFSETS, binary_format::VERTEX_PAYLOAD, chart.num_vertices(),
+		[&chart](std::size_t v) { return chart.get_vertex(chart.get_vertex_at(v));}, vertex_serializer);
+	detail::write_payloads(file, header, binary_format::EDGE_PAYLOAD_OFFSETS, binary_format::EDGE_PAYLOAD, chart.num_edges(),
+		[&chart](std::size_t e) { return chart.get_edge(chart.get_edge_at(e));}, edge_serializer);
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!file)
+	{
+		throw std::runtime_error("error writing '" + path + "'");
+	}
+}
+
+template <class Chart>
+void save_binary(const Chart& chart, const std::string& path)
+{
+	// Topology only
+	save_binary(chart, path, binary_format::no_payload(), binary_format::no_payload());
+}
+
+
+namespace detail {
+
+class mapped_file
+{
+	// Read-only memory mapping of a whole file
+	public:
+		explicit mapped_file(const std::string& path) : _data(0), _size(0)
+		{
+#if defined(_WIN32)
+			_file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+			LARGE_INTEGER size;
+			if (_file == INVALID_HANDLE_VALUE || !::GetFileSizeEx(_file, &size))
+			{
+				this->release();
+				throw std::runtime_error("cannot open '" + path + "'");
+			}
+			_size = static_cast<std::size_t>(size.QuadPart);
+			_mapping = _size ? ::CreateFileMappingA(_file, 0, PAGE_READONLY, 0, 0, 0) : 0;
+			_data = _mapping ? static_cast<const char*>(::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : 0;
+#else
+			_file = ::open(path.c_str(), O_RDONLY);
+			struct stat status;
+			if (_file < 0 || ::fstat(_file, &status) != 0)
+			{
+				this->release();
+				throw std::runtime_error("cannot open '" + path + "'");
+			}
+			_size = static_cast<std::size_t>(status.st_size);
+			if (_size)
+			{
+				void* data = ::mmap(0, _size, PROT_READ, MAP_SHARED, _file, 0);
+				_data = (data == MAP_FAILED) ? 0 : static_cast<const char*>(data);
+			}
+#endif
+			if (!_data)
+			{
+				this->release();
+				throw std::runtime_error("cannot map '" + path + "'");
+			}
+		};
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		~mapped_file() { this->release();};
+
+		const char* data() const { return _data;};
+		std::size_t size() const { return _size;};
+
+	protected:
+		void release()
+		{
+#if defined(_WIN32)
+			if (_data) ::UnmapViewOfFile(_data);
+			if (_mapping) ::CloseHandle(_mapping);
+			if (_file != INVALID_HANDLE_VALUE) ::CloseHandle(_file);
+			_mapping = 0; _file = INVALID_HANDLE_VALUE;
+#else
+			if (_data) ::munmap(const_cast<char*>(_data), _size);
+			if (_file >= 0) ::close(_file);
+			_file = -1;
+#endif
+			_data = 0;
+		};
+
+	protected:
+#if defined(_WIN32)
+		HANDLE _file = INVALID_HANDLE_VALUE;
+		HANDLE _mapping = 0;
+#else
+		int _file = -1;
+#endif
+		const char* _data;
+		std::size_t _size;
+};
+
+}
+
+/*! Read-only chart straight from a file written by 'save_binary'.
+
+    The file is memory mapped and every query reads the arrays in place: loading costs a
+    few checks of the header, whatever the size of the graph, and pages are brought in by
+    the OS as they are touched (and shared between processes mapping the same file).
+    Nothing is copied nor allocated per element; payloads are returned as the ranges of
+    bytes written by the serializers, to be decoded by the client when needed.
+
+    It offers the query API of 'frozen_chart', with the same ids.
+
+    By default only the header and the bounds of the sections are checked, the arrays are
+    trusted as written by 'save_binary': a corrupt file can make queries read out of the
+    mapping. Pass 'verify' for files of unknown origin, every offset and id is then checked
+    once when loading, in O(V+E).
+*/
+class mapped_chart
+{
+	public:
+		typedef std::uint64_t vertex_id;
+		typedef std::uint64_t edge_id;
+		typedef boost::iterator_range<const edge_id*> edge_range;
+		typedef boost::iterator_range<const char*> payload_range;
+
+	public:
+		explicit mapped_chart(const std::string& path, bool verify = false) : _file(path)
+		{
+			if (_file.size() < sizeof(binary_format::header))
+			{
+				throw std::runtime_error("'" + path + "' is not a chart");
+			}
+			std::memcpy(&_header, _file.data(), sizeof(_header));
+			if (std::memcmp(_header.magic, binary_format::magic, sizeof(_header.magic)) != 0)
+			{
+				throw std::runtime_error("'" + path + "' is not a chart");
+			}
+			if (_header.version != binary_format::version || _header.byte_order != binary_format::byte_order)
+			{
+				throw std::runtime_error("'" + path + "' was written by an incompatible version or machine");
+			}
+
+			// Counts beyond the words the file can hold would overflow the lengths computed below
+			if (_header.n_vertices > _file.size()/8 || _header.n_edges > _file.size()/8 || _header.behaviour > static_cast<std::uint32_t>(DIRECTED))
+			{
+				throw std::runtime_error("'" + path + "' is corrupt");
+			}
+
+			// Every section must be inside the file and have the expected length
+			const std::uint64_t n_adjacent = (_header.behaviour == UNDIRECTED) ? 2*_header.n_edges : _header.n_edges; // upper bound, self loops count once
+			const std::uint64_t words[binary_format::N_SECTIONS] = {
+				_header.n_edges, _header.n_edges, _header.n_vertices + 1, n_adjacent, _header.n_vertices + 1, n_adjacent,
+				_header.n_vertices + 1, 0, _header.n_edges + 1, 0};
+			for (int s = 0; s < binary_format::N_SECTIONS; ++s)
+			{
+				const binary_format::section& section = _header.sections[s];
+				const bool is_payload = (s == binary_format::VERTEX_PAYLOAD || s == binary_format::EDGE_PAYLOAD);
+				const bool is_adjacency = (s == binary_format::OUT_EDGES || s == binary_format::IN_EDGES);
+				if (section.offset % 8 != 0 || section.offset > _file.size() || section.size > _file.size() - section.offset ||
+				    (!is_payload && !is_adjacency && section.size != 8*words[s]) || (is_adjacency && section.size > 8*words[s]))
+				{
+					throw std::runtime_error("'" + path + "' is corrupt");
+				}
+			}
+			if (this->words(binary_format::VERTEX_PAYLOAD_OFFSETS)[_header.n_vertices] != _header.sections[binary_format::VERTEX_PAYLOAD].size ||
+			    this->words(binary_format::EDGE_PAYLOAD_OFFSETS)[_header.n_edges] != _header.sections[binary_format::EDGE_PAYLOAD].size)
+			{
+				throw std::runtime_error("'" + path + "' is corrupt");
+			}
+			if (verify && !this->is_consistent())
+			{
+				throw std::runtime_error("'" + path + "' is corrupt");
+			}
+		};
+
+		std::size_t num_vertices() const { return static_cast<std::size_t>(_header.n_vertices);};
+		std::size_t num_edges() const { return static_cast<std::size_t>(_header.n_edges);};
+		_e_behaviour behaviour() const { return static_cast<_e_behaviour>(_header.behaviour);};
+
+		// Allocation-free ranges
+		edge_range out_edges(const vertex_id& vertex) const { return this->adjacency(binary_format::OUT_OFFSETS, binary_format::OUT_EDGES, vertex);};
+		edge_range in_edges(const vertex_id& vertex) const { return this->adjacency(binary_format::IN_OFFSETS, binary_format::IN_EDGES, vertex);};
+
+		void get_edges_outgoing(const vertex_id& vertex, std::vector<edge_id>& edges) const
+		{
+			edge_range range = this->out_edges(vertex);
+			edges.insert(edges.end(), range.begin(), range.end());
+		};
+
+		void get_edges_incoming(const vertex_id& vertex, std::vector<edge_id>& edges) const
+		{
+			edge_range range = this->in_edges(vertex);
+			edges.insert(edges.end(), range.begin(), range.end());
+		};
+
+		vertex_id get_source(const edge_id& edge) const { return this->words(binary_format::SOURCES)[edge];};
+		vertex_id get_target(const edge_id& edge) const { return this->words(binary_format::TARGETS)[edge];};
+
+		std::pair<vertex_id, vertex_id> get_connected(const edge_id& edge) const
+		{
+			return std::make_pair(this->get_source(edge), this->get_target(edge));
+		};
+
+		payload_range get_vertex_payload(const vertex_id& vertex) const { return this->payload(binary_format::VERTEX_PAYLOAD_OFFSETS, binary_format::VERTEX_PAYLOAD, vertex);};
+		payload_range get_edge_payload(const edge_id& edge) const { return this->payload(binary_format::EDGE_PAYLOAD_OFFSETS, binary_format::EDGE_PAYLOAD, edge);};
+
+	protected:
+		bool is_consistent() const
+		{
+			// Every query stays inside the mapping
+			return mapped_chart::is_below(this->words(binary_format::SOURCES), _header.n_edges, _header.n_vertices) &&
+			       mapped_chart::is_below(this->words(binary_format::TARGETS), _header.n_edges, _header.n_vertices) &&
+			       this->is_adjacency(binary_format::OUT_OFFSETS, binary_format::OUT_EDGES) &&
+			       this->is_adjacency(binary_format::IN_OFFSETS, binary_format::IN_EDGES) &&
+			       mapped_chart::is_monotonic(this->words(binary_format::VERTEX_PAYLOAD_OFFSETS), _header.n_vertices + 1) &&
+			       mapped_chart::is_monotonic(this->words(binary_format::EDGE_PAYLOAD_OFFSETS), _header.n_edges + 1);
+		};
+
+		bool is_adjacency(binary_format::_e_section offsets_id, binary_format::_e_section edges_id) const
+		{
+			const std::uint64_t* offsets = this->words(offsets_id);
+			return offsets[_header.n_vertices] == _header.sections[edges_id].size/8 &&
+			       mapped_chart::is_monotonic(offsets, _header.n_vertices + 1) &&
+			       mapped_chart::is_below(this->words(edges_id), offsets[_header.n_vertices], _header.n_edges);
+		};
+
+		static bool is_monotonic(const std::uint64_t* offsets, std::uint64_t n)
+		{
+			// Starts at 0, never decreases
+			if (offsets[0] != 0)
+			{
+				return false;
+			}
+			for (std::uint64_t i = 1; i < n; ++i)
+			{
+				if (offsets[i] < offsets[i - 1])
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		static bool is_below(const std::uint64_t* values, std::uint64_t n, std::uint64_t bound)
+		{
+			for (std::uint64_t i = 0; i < n; ++i)
+			{
+				if (values[i] >= bound)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		const std::uint64_t* words(binary_format::_e_section id) const
+		{
+			return reinterpret_cast<const std::uint64_t*>(_file.data() + _header.sections[id].offset);
+		};
+
+		edge_range adjacency(binary_format::_e_section offsets_id, binary_format::_e_section edges_id, const vertex_id& vertex) const
+		{
+			const std::uint64_t* offsets = this->words(offsets_id);
+			const edge_id* edges = this->words(edges_id);
+			return edge_range(edges + offsets[vertex], edges + offsets[vertex + 1]);
+		};
+
+		payload_range payload(binary_format::_e_section offsets_id, binary_format::_e_section payload_id, std::uint64_t index) const
+		{
+			const std::uint64_t* offsets = this->words(offsets_id);
+			const char* bytes = _file.data() + _header.sections[payload_id].offset;
+			return payload_range(bytes + offsets[index], bytes + offsets[index + 1]);
+		};
+
+	protected:
+		detail::mapped_file _file;
+		binary_format::header _header;
+};
+
+}}
@@ -0,0 +1,374 @@
+
+#pragma once
+
+#include <memory>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <boost/graph/adjacency_list.hpp>
+
+namespace core { namespace graph { namespace detail {
+
+/*! Memory arena owned by a chart.
+
+    Small requests are served from big blocks and classified in size classes (multiples
+    of 'granularity' bytes), each one with its own free list: freed memory is reused by
+    later allocations of the same class and never returned to the system until the
+    arena itself is destroyed, which releases all the blocks in one step.
+
+    Vertices and edges created by a chart (create_vertex/create_edge) and the nodes of
+    the underlying boost graph are allocated from the arena of the chart. Elements hold
+    a reference to the arena, so it is kept alive as long as any of them is alive.
+
+    Still on the global heap: the boost vertex nodes ('stored_vertex', which adjacency_list
+    creates with plain 'new' for list based vertex containers, only the list node pointing
+    to it comes from the arena), the elements and inner objects made by the user (given
+    to 'add_vertex'/'add_edge'), the edge sets of the vertices once they outgrow their
+    inline room, and the indices of the chart. See 'bm_create_edge' against
+    'bm_create_edge_heap_baseline' for the allocations per edge left.
+
+    Allocations take a lock, as elements may be released from any thread. Threads that
+    allocate in bulk (see 'chart_impl::parallel_add_edges') bind an 'arena_thread_cache'
+    instead: while it lives, the allocations and deallocations of that thread are served
+    from its own slab and free lists without locking, and it hands them back to the arena
+    when destroyed.
+*/
+class chart_arena
+{
+		friend class arena_thread_cache;
+	public:
+		static const std::size_t granularity = 16;
+		static const std::size_t max_pooled_size = 512;
+		static const std::size_t block_size = 64*1024;
+		static const std::size_t refill_size = 64; // free nodes a thread cache takes at once
+
+	public:
+		chart_arena() : _current(0), _remaining(0), _allocations(0), _bytes(0), _free_lists(max_pooled_size/granularity, (void*)0) {};
+		chart_arena(const chart_arena&) = delete;
+		chart_arena& operator=(const chart_arena&) = delete;
+
+		~chart_arena()
+		{
+			for (std::vector<void*>::iterator it = _blocks.begin(); it != _blocks.end(); ++it)
+			{
+				::operator delete(*it);
+			}
+		};
+
+		void* allocate(std::size_t bytes)
+		{
+			if (bytes > max_pooled_size)
+			{
+				return ::operator new(bytes);
+			}
+
+			std::size_t size_class = (bytes + granularity - 1)/granularity;
+			thread_cache* cache = chart_arena::cache();
+			if (cache && cache->arena == this)
+			{
+				return this->allocate(size_class, *cache);
+			}
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			++_allocations;
+			void*& free_list = _free_lists[size_class - 1];
+			if (free_list)
+			{
+				void* ret = free_list;
+				free_list = *static_cast<void**>(ret);
+				return ret;
+			}
+
+			std::size_t size = size_class*granularity;
+			if (size > _remaining)
+			{
+				_current = this->new_block();
+				_remaining = block_size;
+			}
+			void* ret = _current;
+			_current += size;
+			_remaining -= size;
+			_bytes += size;
+			return ret;
+		};
+
+		void deallocate(void* ptr, std::size_t bytes)
+		{
+			if (bytes > max_pooled_size)
+			{
+				::operator delete(ptr);
+				return;
+			}
+
+			std::size_t size_class = (bytes + granularity - 1)/granularity;
+			thread_cache* cache = chart_arena::cache();
+			if (cache && cache->arena == this)
+			{
+				void*& free_list = cache->free_lists[size_class - 1];
+				if (!free_list)
+				{
+					cache->tails[size_class - 1] = ptr;
+				}
+				*static_cast<void**>(ptr) = free_list;
+				free_list = ptr;
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			void*& free_list = _free_lists[size_class - 1];
+			*static_cast<void**>(ptr) = free_list;
+			free_list = ptr;
+		};
+
+		// Statistics
+		std::size_t get_allocations() const { return _allocations;}; // served from the arena
+		std::size_t get_bytes_used() const { return _bytes;}; // carved from the blocks
+		std::size_t get_bytes_reserved() const { return _blocks.size()*block_size;};
+
+		/*! Arena used by the allocations of graph nodes in the current thread (see
+		    'arena_scope' and 'arena_node_allocator').
+		*/
+		static chart_arena*& current()
+		{
+			static thread_local chart_arena* arena = 0;
+			return arena;
+		};
+
+	protected:
+		// Slab and free lists of a thread bound to the arena (see 'arena_thread_cache')
+		struct thread_cache
+		{
+			thread_cache(chart_arena* arena) : arena(arena), current(0), remaining(0), allocations(0), bytes(0), free_lists(max_pooled_size/granularity, (void*)0), tails(max_pooled_size/granularity, (void*)0) {};
+
+			chart_arena* arena;
+			char* current;
+			std::size_t remaining;
+			std::size_t allocations, bytes;
+			std::vector<void*> free_lists, tails;
+		};
+
+		static thread_cache*& cache()
+		{
+			static thread_local thread_cache* cache = 0;
+			return cache;
+		};
+
+		void* allocate(std::size_t size_class, thread_cache& cache)
+		{
+			++cache.allocations;
+			void*& free_list = cache.free_lists[size_class - 1];
+			std::size_t size = size_class*granularity;
+			if (!free_list && size > cache.remaining)
+			{
+				// Refill: up to 'refill_size' nodes from the free list of the arena, otherwise a new slab
+				std::lock_guard<std::mutex> lock(_mutex);
+				void*& shared = _free_lists[size_class - 1];
+				if (shared)
+				{
+					void* tail = shared;
+					for (std::size_t n = 1; n < refill_size && *static_cast<void**>(tail); ++n)
+					{
+						tail = *static_cast<void**>(tail);
+					}
+					free_list = shared;
+					cache.tails[size_class - 1] = tail;
+					shared = *static_cast<void**>(tail);
+					*static_cast<void**>(tail) = 0;
+				}
+				else
+				{
+					cache.current = this->new_block();
+					cache.remaining = block_size;
+				}
+			}
+			if (free_list)
+			{
+				void* ret = free_list;
+				free_list = *static_cast<void**>(ret);
+				return ret;
+			}
+
+			void* ret = cache.current;
+			cache.current += size;
+			cache.remaining -= size;
+			cache.bytes += size;
+			return ret;
+		};
+
+		void release(thread_cache& cache)
+		{
+			// Hands the memory of the cache back to the arena
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (std::size_t i = 0; i < _free_lists.size(); ++i)
+			{
+				if (cache.free_lists[i])
+				{
+					*static_cast<void**>(cache.tails[i]) = _free_lists[i];
+					_free_lists[i] = cache.free_lists[i];
+				}
+			}
+			if (cache.remaining > _remaining)
+			{
+				_current = cache.current;
+				_remaining = cache.remaining;
+			}
+			_allocations += cache.allocations;
+			_bytes += cache.bytes;
+		};
+
+		char* new_block()
+		{
+			// The caller holds the lock
+			_blocks.reserve(_blocks.size() + 1);
+			char* block = static_cast<char*>(::operator new(block_size));
+			_blocks.push_back(block);
+			return block;
+		};
+
+	protected:
+		std::mutex _mutex; // elements may be released from any thread
+		char* _current;
+		std::size_t _remaining;
+		std::size_t _allocations, _bytes;
+		std::vector<void*> _free_lists;
+		std::vector<void*> _blocks;
+};
+
+
+/*! Binds the current thread to 'arena' while in scope: its allocations from the arena
+    are served without locking (see 'chart_arena'). Memory may still be released from any
+    thread, including after the cache is gone.
+*/
+class arena_thread_cache
+{
+	public:
+		explicit arena_thread_cache(chart_arena& arena) : _cache(&arena), _previous(chart_arena::cache()) { chart_arena::cache() = &_cache;};
+		arena_thread_cache(const arena_thread_cache&) = delete;
+		arena_thread_cache& operator=(const arena_thread_cache&) = delete;
+
+		~arena_thread_cache()
+		{
+			chart_arena::cache() = _previous;
+			_cache.arena->release(_cache);
+		};
+
+	protected:
+		chart_arena::thread_cache _cache;
+		chart_arena::thread_cache* _previous;
+};
+
+
+/*! Stateful allocator drawing from a chart arena, it holds a reference to the arena
+    so 'std::allocate_shared' keeps it alive with the element (object and control
+    block in a single allocation).
+*/
+template <class T>
+class arena_allocator
+{
+		template <class U> friend class arena_allocator;
+	public:
+		typedef T value_type;
+
+	public:
+		explicit arena_allocator(std::shared_ptr<chart_arena> arena) : _arena(arena) {};
+		template <class U>
+		arena_allocator(const arena_allocator<U>& other) : _arena(other._arena) {};
+
+		T* allocate(std::size_t n) { return static_cast<T*>(_arena->allocate(n*sizeof(T)));};
+		void deallocate(T* ptr, std::size_t n) { _arena->deallocate(ptr, n*sizeof(T));};
+
+		template <class U>
+		bool operator==(const arena_allocator<U>& other) const { return _arena == other._arena;};
+		template <class U>
+		bool operator!=(const arena_allocator<U>& other) const { return _arena != other._arena;};
+
+	protected:
+		std::shared_ptr<chart_arena> _arena;
+};
+
+
+/*! Allocator for the containers inside boost::adjacency_list.
+
+    Boost builds these containers itself, so the allocator cannot carry state: it takes
+    the arena from 'chart_arena::current()' (set by the chart while it mutates the graph
+    through 'arena_scope') and stores it in a small header in front of every node, so
+    memory is always returned to the arena it came from. Without an active scope it falls
+    back to the global heap.
+*/
+template <class T>
+class arena_node_allocator
+{
+	public:
+		typedef T value_type;
+
+	public:
+		arena_node_allocator() {};
+		template <class U>
+		arena_node_allocator(const arena_node_allocator<U>&) {};
+
+		T* allocate(std::size_t n)
+		{
+			const std::size_t bytes = header_size + n*sizeof(T);
+			chart_arena* arena = chart_arena::current();
+			char* ptr = static_cast<char*>(arena ? arena->allocate(bytes) : ::operator new(bytes));
+			*reinterpret_cast<chart_arena**>(ptr) = arena;
+			return reinterpret_cast<T*>(ptr + header_size);
+		};
+
+		void deallocate(T* p, std::size_t n)
+		{
+			const std::size_t bytes = header_size + n*sizeof(T);
+			char* ptr = reinterpret_cast<char*>(p) - header_size;
+			chart_arena* arena = *reinterpret_cast<chart_arena**>(ptr);
+			if (arena)
+			{
+				arena->deallocate(ptr, bytes);
+			}
+			else
+			{
+				::operator delete(ptr);
+			}
+		};
+
+		template <class U>
+		bool operator==(const arena_node_allocator<U>&) const { return true;};
+		template <class U>
+		bool operator!=(const arena_node_allocator<U>&) const { return false;};
+
+	protected:
+		static const std::size_t header_size = (sizeof(chart_arena*) + alignof(std::max_align_t) - 1)/alignof(std::max_align_t)*alignof(std::max_align_t);
+};
+
+
+/*! Makes 'arena' the target of graph node allocations in this thread while in scope */
+class arena_scope
+{
+	public:
+		explicit arena_scope(chart_arena& arena) : _previous(chart_arena::current()) { chart_arena::current() = &arena;};
+		~arena_scope() { chart_arena::current() = _previous;};
+
+	protected:
+		chart_arena* _previous;
+};
+
+
+/*! boost::adjacency_list selector for std::list containers drawing from the chart arena */
+struct arena_listS {};
+
+}}}
+
+namespace boost
+{
+	template <class ValueType>
+	struct container_gen< ::core::graph::detail::arena_listS, ValueType>
+	{
+		typedef std::list<ValueType, ::core::graph::detail::arena_node_allocator<ValueType> > type;
+	};
+
+	template <>
+	struct parallel_edge_traits< ::core::graph::detail::arena_listS>
+	{
+		typedef allow_parallel_edge_tag type;
+	};
+}
@@ -3,20 +3,42 @@
 
 #include <memory>
 #include <vector>
+#include <tuple>
+#include <iterator>
 #include <set>
 #include <map>
+#include <exception>
+#include <algorithm>
+#include <type_traits>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
 #include <boost/iterator/zip_iterator.hpp>
 #include <boost/graph/iteration_macros.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/range/join.hpp>
 
-#include <boost/graph/graphviz.hpp>
+#ifndef BOOST_NO_RTTI
+#include <boost/graph/graphviz.hpp> // boost::dynamic_properties needs RTTI, not available with -fno-rtti
+#endif
 
 #include "chart_traits.hpp"
 #include "events.hpp"
+#include "frozen_chart.hpp"
+#include "chart_arena.hpp"
+#include "component_tracker.hpp"
+#include "chart_view.hpp" // before search.hpp, which calls the boost functions of the view adaptors
+#include "search.hpp"
+#include "parallel_bfs.hpp"
+#include "shortest_paths.hpp"
+#include "strong_components.hpp"
+#include "observer.hpp"
+#include "chart_io.hpp"
+#include "metrics.hpp"
 
 namespace core { namespace graph {
 
+template <class VertexType, class EdgeType, int Behaviour> class chart;
+
 namespace detail
 {
 
@@ -24,7 +46,7 @@ namespace detail
 	    to implement some custom/predefined functionalities.
 	*/
 	class chart_base
-	{ // Just for RTTI
+	{ // Common polymorphic base of all the charts
 		public:
 			virtual ~chart_base() {};
 	};
@@ -32,6 +54,12 @@ namespace detail
 	template <class VertexType, class EdgeType, int Behaviour>
 	class chart_impl : public chart_base
 	{
+			template <class Chart> friend class core::graph::frozen_chart;
+			template <class Chart> friend class component_tracker;
+			template <class Chart> friend class core::graph::search;
+			template <class Chart> friend class edge_endpoints;
+			template <class View, class Chart, class Graph> friend class chart_view;
+			template <class Chart> friend struct chart_graph;
 		public:
 			typedef typename chart_traits<VertexType, EdgeType, Behaviour>::vertex_type vertex_type;
 			typedef typename chart_traits<VertexType, EdgeType, Behaviour>::edge_type edge_type;
@@ -40,6 +68,7 @@ namespace detail
 			typedef typename std::shared_ptr<vertex_type> vertex_type_ptr;
 			typedef typename std::shared_ptr<edge_type> edge_type_ptr;
 			typedef std::shared_ptr<chart_impl> chart_ptr;
+			typedef core::graph::chart<VertexType, EdgeType, Behaviour> chart_type;
 
 		protected:
 			/* Necesitamos que los vértices y aristas se almacenen en listas (boost::listS) para que no 
@@ -52,43 +81,64 @@ namespace detail
 			 *   > in the range [0, num_vertices(g)) and are contiguous. When a vertex is removed 
 			 *   > the indices are adjusted so that they retain these properties.
 			 */
-			typedef boost::adjacency_list<boost::listS, boost::listS, behaviour, boost::property<boost::vertex_index_t, size_t, vertex_type_ptr>, edge_type_ptr> _t_graph;
-			//                                                                   ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ cuando utilizo listS no se crea un index para los vértices, el cual necesito para calcular los connected components.
-			//                                   ^^^^^         ^^^^^ cannot use boost::vecS, see above.
+			typedef boost::property<boost::vertex_index_t, size_t, vertex_type_ptr> _t_vertex_property;
+			typedef boost::property<boost::edge_index_t, size_t, edge_type_ptr> _t_edge_property;
+			//      ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ cuando utilizo listS no se crea un index para los vértices, el cual necesito para calcular los connected components.
+			//                                                                 The chart keeps both indices dense in [0, n) across removals (see 'remove_vertex' and 'remove_edge').
+
+			typedef boost::adjacency_list<arena_listS, arena_listS, behaviour, _t_vertex_property, _t_edge_property, boost::no_property, arena_listS> _t_graph;
+			//                            ^^^^^^^^^^^  ^^^^^^^^^^^ cannot use boost::vecS, see above. Same as boost::listS, but nodes are taken from the chart arena (see chart_arena.hpp)
 
 		public:
 			typedef typename _t_graph::vertex_descriptor vertex_id;
 			typedef typename _t_graph::edge_descriptor edge_id;
 
-			typedef std::map<vertex_type_ptr, vertex_id> _t_vertices;
-			typedef std::map<edge_type_ptr, edge_id> _t_edges;
+			typedef typename chart_traits<VertexType, EdgeType, Behaviour>::template vertex_index<vertex_id> _t_vertices;
+			typedef typename chart_traits<VertexType, EdgeType, Behaviour>::template edge_index<edge_id> _t_edges;
 
 			typedef std::map<vertex_id, typename _t_graph::vertices_size_type> _t_connected_components;
 
+			typedef typename boost::property_map<_t_graph, boost::vertex_index_t>::const_type vertex_index_map;
+			typedef typename boost::property_map<_t_graph, boost::edge_index_t>::const_type edge_index_map;
+
+			typedef typename boost::graph_traits<_t_graph>::out_edge_iterator out_edge_iterator;
+			typedef typename boost::graph_traits<_t_graph>::adjacency_iterator adjacency_iterator;
+			typedef boost::iterator_range<out_edge_iterator> out_edge_range;
+			typedef boost::iterator_range<adjacency_iterator> adjacency_range;
+
+			typedef chart_event<chart_impl> event_type;
+			typedef chart_listener<chart_impl> listener_type;
+			typedef chart_observer<chart_impl, static_listener<VertexType, EdgeType, Behaviour> > observer_type;
+			typedef typename std::conditional<chart_instrumentation<VertexType, EdgeType, Behaviour>::enabled, metrics_collector, no_metrics_collector>::type metrics_type;
+
 		public:
-			chart_impl() {};
-			virtual ~chart_impl()
+			chart_impl() : _self(0), _arena(std::make_shared<chart_arena>())
 			{
-				while (_edges.size())
+				if (static_listener<VertexType, EdgeType, Behaviour>::enabled)
 				{
-					this->remove_edge( _edges.begin()->first);
-				}
-
-				while(_vertices.size())
-				{
-					this->remove_vertex( _vertices.begin()->first);
+					this->enable_events();
 				}
 			};
+			virtual ~chart_impl()
+			{
+				_observer.reset(); // pending events are delivered while the chart is still whole, not its teardown
+				this->clear();
+			};
 
 			std::pair<vertex_id, bool> add_vertex(vertex_type_ptr ptr)
 			{
+				typename metrics_type::scope timing(_metrics, chart_metrics::ADD_VERTEX);
+				if (_components) _components->update(); // apply pending removals before the graph changes
 				// Is it already added?
-				_t_vertices::iterator it; bool inserted;
+				arena_scope scope(*_arena);
+				typename _t_vertices::iterator it; bool inserted;
 				std::tie(it, inserted) = _vertices.insert(std::make_pair(ptr, vertex_id()));
 				if (inserted)
 				{
-					it->second = boost::add_vertex(boost::property<boost::vertex_index_t, size_t, vertex_type_ptr>(boost::num_vertices(_graph), ptr), _graph);
-					ptr->insert_chart(this);
+					it->second = boost::add_vertex(_t_vertex_property(_vertex_by_index.size(), ptr), _graph);
+					_vertex_by_index.push_back(it->second);
+					ptr->insert_chart(_self);
+					if (_components) _components->on_vertex_added(it->second);
 					events::on_vertex_added_to_chart(*it, *this);
 				}
 				return std::make_pair(it->second, inserted);
@@ -96,18 +146,34 @@ namespace detail
 
 			void remove_vertex(vertex_type_ptr ptr)
 			{
-				_t_vertices::iterator it = _vertices.find(ptr);
+				typename metrics_type::scope timing(_metrics, chart_metrics::REMOVE_VERTEX);
+				typename _t_vertices::iterator it = _vertices.find(ptr);
 				if (it != _vertices.end())
 				{
-					/*! Si elimino un vértice se eliminan todos los edges conectados
-					  en _graph, pero no se eliminan las conexiones establecidas entre
-					  estos elementos. Sólo cuando se destruye un vértice se terminan
-					  de eliminar las conexiones (o cuando se llama a la función disconnect
-					  de los edges)
+					/*! Si elimino un vértice antes se eliminan del chart, uno a uno con
+					  'remove_edge' (índices, tracker y eventos incluidos), todos sus edges
+					  incidentes. Las conexiones entre vértice y edges se mantienen hasta que
+					  se destruye el edge o se llama a su función disconnect.
 					*/
-					boost::remove_vertex( it->second, _graph);
-					_vertices.erase(it);
-					ptr->erase_chart(this);
+					const vertex_id v_id = it->second;
+					std::vector<edge_type_ptr> incident;
+					this->collect_incident_edges(v_id, incident, typename boost::graph_traits<_t_graph>::directed_category());
+					for (typename std::vector<edge_type_ptr>::const_iterator e_it = incident.begin(); e_it != incident.end(); ++e_it)
+					{
+						this->remove_edge(*e_it); // boost::remove_vertex requires an isolated vertex
+					}
+
+					if (_components) _components->on_vertex_removed(v_id);
+
+					// Keep the vertex index dense: the last vertex takes the place of the removed one
+					const size_t index = boost::get(boost::vertex_index, _graph, v_id);
+					_vertex_by_index[index] = _vertex_by_index.back();
+					boost::put(boost::vertex_index, _graph, _vertex_by_index[index], index);
+					_vertex_by_index.pop_back();
+
+					boost::remove_vertex(v_id, _graph);
+					_vertices.erase(_vertices.find(ptr));
+					ptr->erase_chart(_self);
 					events::on_vertex_removed_from_chart(ptr, *this);
 				}
 			};
@@ -124,6 +190,7 @@ namespace detail
 				 * vertices must exists
 				 * edge must not be connected
 				 */
+				typename metrics_type::scope timing(_metrics, chart_metrics::ADD_EDGE);
 				if (ptr->is_connected())
 				{
 					throw std::runtime_error("edge is already connected");
@@ -131,11 +198,13 @@ namespace detail
 
 				vertex_type_ptr source_ptr = this->get_vertex(source);
 				vertex_type_ptr target_ptr = this->get_vertex(target);
-				_t_edges::iterator it; bool inserted;
+				if (_components) _components->update();
+				arena_scope scope(*_arena);
+				typename _t_edges::iterator it; bool inserted;
 				std::tie(it, inserted) = _edges.insert(std::make_pair(ptr, edge_id()));
 				if (inserted)
 				{
-					std::tie(it->second, inserted) = boost::add_edge(source, target, ptr, _graph);
+					std::tie(it->second, inserted) = boost::add_edge(source, target, _t_edge_property(_edge_by_index.size(), ptr), _graph);
 					/* boost::add_edge: Adds edge (u,v) to the graph and returns the edge descriptor for the new edge. 
 					    For graphs that do not allow parallel edges, if the edge is already
 					    in the graph then a duplicate will not be added and the bool flag
@@ -144,9 +213,12 @@ namespace detail
 					*/
 					if (inserted)
 					{
+						_edge_by_index.push_back(it->second);
 						// Create connection
 						ptr->connect(source_ptr.get(), target_ptr.get());
-						ptr->set_chart(this, [this, it](){this->remove_edge(it->second);} );
+						ptr->set_chart(_self, _edge_by_index.size() - 1);
+						if (_components) _components->on_edge_added(source, target);
+						this->observe_degrees(source, target);
 						events::on_edge_added_to_chart(*it, *this);
 					}
 				}
@@ -155,12 +227,22 @@ namespace detail
 
 			void remove_edge(edge_type_ptr ptr)
 			{
-				_t_edges::iterator it = _edges.find(ptr);
+				typename metrics_type::scope timing(_metrics, chart_metrics::REMOVE_EDGE);
+				typename _t_edges::iterator it = _edges.find(ptr);
 				if (it != _edges.end())
 				{
+					if (_components) _components->on_edge_removed(boost::source(it->second, _graph), boost::target(it->second, _graph));
+
+					// Keep the edge index dense: the last edge takes the place of the removed one
+					const size_t index = boost::get(boost::edge_index, _graph, it->second);
+					_edge_by_index[index] = _edge_by_index.back();
+					boost::put(boost::edge_index, _graph, _edge_by_index[index], index);
+					_graph[_edge_by_index[index]]->set_chart(_self, index);
+					_edge_by_index.pop_back();
+
 					boost::remove_edge(it->second, _graph);
 					_edges.erase(it);
-					ptr->remove_chart(this);
+					ptr->remove_chart(_self);
 					events::on_edge_removed_from_chart(ptr, *this);
 				}
 			};
@@ -171,14 +253,349 @@ namespace detail
 				this->remove_edge(ptr);
 			};
 
+			/*! Batch construction: 'add_vertices' takes a range of vertex_type_ptr and
+			    'add_edges' a range of (edge_type_ptr, source vertex_id, target vertex_id)
+			    tuples. Storage is reserved up front and listeners receive a single
+			    notification for the whole batch. Both return the ids of the elements in
+			    the same order as the input (elements already in the chart keep their id).
+
+			    'add_edges' checks that no edge is connected before modifying the chart. If
+			    the range throws midway, the elements added so far are removed again: the
+			    chart is left as it was and nobody is notified.
+			*/
+			typedef std::tuple<edge_type_ptr, vertex_id, vertex_id> edge_entry;
+
+			template <class VertexRange>
+			std::vector<vertex_id> add_vertices(const VertexRange& vertices)
+			{
+				const std::size_t n = std::distance(std::begin(vertices), std::end(vertices));
+				if (_components) _components->update();
+				arena_scope scope(*_arena);
+				_vertices.reserve(_vertices.size() + n);
+
+				_vertex_by_index.reserve(_vertex_by_index.size() + n);
+
+				std::vector<vertex_id> ids; ids.reserve(n);
+				std::vector<typename _t_vertices::value_type> added; added.reserve(n);
+				try
+				{
+					for (auto item = std::begin(vertices); item != std::end(vertices); ++item)
+					{
+						const vertex_type_ptr& ptr = *item;
+						typename _t_vertices::iterator it; bool inserted;
+						std::tie(it, inserted) = _vertices.insert(std::make_pair(ptr, vertex_id()));
+						if (inserted)
+						{
+							it->second = boost::add_vertex(_t_vertex_property(_vertex_by_index.size(), ptr), _graph);
+							_vertex_by_index.push_back(it->second);
+							added.push_back(*it);
+							ptr->insert_chart(_self);
+							if (_components) _components->on_vertex_added(it->second);
+						}
+						ids.push_back(it->second);
+					}
+				}
+				catch (...)
+				{
+					this->rollback_vertices(added);
+					throw;
+				}
+				events::on_vertices_added_to_chart(added, *this);
+				return ids;
+			};
+
+			template <class EdgeRange>
+			std::vector<edge_id> add_edges(const EdgeRange& edges)
+			{
+				const std::size_t n = std::distance(std::begin(edges), std::end(edges));
+				for (auto item = std::begin(edges); item != std::end(edges); ++item)
+				{
+					// Check everything before modifying the chart
+					if (std::get<0>(*item)->is_connected())
+					{
+						throw std::runtime_error("edge is already connected");
+					}
+				}
+
+				if (_components) _components->update();
+				arena_scope scope(*_arena);
+				_edges.reserve(_edges.size() + n);
+
+				_edge_by_index.reserve(_edge_by_index.size() + n);
+
+				std::vector<edge_id> ids; ids.reserve(n);
+				std::vector<typename _t_edges::value_type> added; added.reserve(n);
+				try
+				{
+					for (auto item = std::begin(edges); item != std::end(edges); ++item)
+					{
+						const edge_entry& entry = *item;
+						const edge_type_ptr& ptr = std::get<0>(entry);
+						const vertex_id& source = std::get<1>(entry);
+						const vertex_id& target = std::get<2>(entry);
+
+						typename _t_edges::iterator it; bool inserted;
+						std::tie(it, inserted) = _edges.insert(std::make_pair(ptr, edge_id()));
+						if (inserted)
+						{
+							std::tie(it->second, inserted) = boost::add_edge(source, target, _t_edge_property(_edge_by_index.size(), ptr), _graph);
+							if (inserted)
+							{
+								_edge_by_index.push_back(it->second);
+								added.push_back(*it);
+								ptr->connect(_graph[source].get(), _graph[target].get());
+								ptr->set_chart(_self, _edge_by_index.size() - 1);
+								if (_components) _components->on_edge_added(source, target);
+								this->observe_degrees(source, target);
+							}
+						}
+						ids.push_back(it->second);
+					}
+				}
+				catch (...)
+				{
+					this->rollback_edges(added);
+					throw;
+				}
+				events::on_edges_added_to_chart(added, *this);
+				return ids;
+			};
+
+			template <class EdgeFactory>
+			std::vector<edge_id> parallel_add_edges(std::size_t n, EdgeFactory make_edge, unsigned n_threads = 0)
+			{
+				/*! Multi-threaded 'add_edges' ('n_threads' = 0 uses all the cores) for bulk loading:
+				    'make_edge(i)' returns the 'edge_entry' of the i-th edge in [0, n) and it is called
+				    concurrently from several threads, so edges (and their inner objects) are created in
+				    parallel into per-thread staging buffers. Every thread allocates from its own slab
+				    of the arena (see 'arena_thread_cache'). They are merged into the chart in steps,
+				    separated by barriers:
+				      1) (parallel) edges are created, checked and sharded by vertex;
+				      2) (serial) edges are inserted in the index and numbered, in order. This is the
+				         only serial pass over the edges: the index cannot take concurrent inserts;
+				      3) (parallel) every thread builds the boost edge properties of its edges in a list
+				         of its own, the lists are spliced into the graph in bulk;
+				      4) (parallel) every thread fills the edge lists of the vertices of its shard and
+				         connects their edges, so no vertex is modified by two threads.
+				    Same result, notifications and exceptions as 'add_edges' with the edges in order
+				    (nothing is modified if any of them is already connected or 'make_edge' throws).
+				*/
+				typedef typename boost::graph_traits<_t_graph>::directed_category directed_category;
+				const std::size_t not_added = std::size_t(-1);
+
+				n_threads = detail::resolve_threads(n_threads, n);
+				std::vector<edge_entry> entries(n);
+				std::vector<std::vector<std::vector<std::size_t> > > shards(n_threads, std::vector<std::vector<std::size_t> >(n_threads)); // [producer][owner]
+				std::vector<std::exception_ptr> errors(n_threads);
+				detail::parallel_for(n, n_threads, [&](unsigned thread, std::size_t begin, std::size_t end)
+				{
+					arena_thread_cache cache(*_arena);
+					try
+					{
+						for (std::size_t i = begin; i < end; ++i)
+						{
+							entries[i] = make_edge(i);
+							if (std::get<0>(entries[i])->is_connected())
+							{
+								throw std::runtime_error("edge is already connected");
+							}
+							// Owners of the source and the target, 2*i+1 stands for the target
+							shards[thread][this->get_vertex_index(std::get<1>(entries[i])) % n_threads].push_back(2*i);
+							shards[thread][this->get_vertex_index(std::get<2>(entries[i])) % n_threads].push_back(2*i + 1);
+						}
+					}
+					catch (...)
+					{
+						errors[thread] = std::current_exception();
+					}
+				});
+				for (std::size_t t = 0; t < errors.size(); ++t)
+				{
+					if (errors[t])
+					{
+						std::rethrow_exception(errors[t]);
+					}
+				}
+
+				if (_components) _components->update();
+				_edges.reserve(_edges.size() + n); // the inserts below do not move the entries
+				std::vector<typename _t_edges::iterator> slots(n);
+				std::vector<std::size_t> index(n, not_added);
+				std::size_t n_edges = _edge_by_index.size();
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					bool inserted;
+					try
+					{
+						std::tie(slots[i], inserted) = _edges.insert(std::make_pair(std::get<0>(entries[i]), edge_id()));
+					}
+					catch (...)
+					{
+						for (std::size_t j = i; j-- > 0;)
+						{
+							if (index[j] != not_added) _edges.erase(_edges.find(std::get<0>(entries[j])));
+						}
+						throw;
+					}
+					if (inserted)
+					{
+						index[i] = n_edges++;
+					}
+				}
+				_edge_by_index.resize(n_edges);
+
+				std::vector<typename _t_edge_container::iterator> properties(n);
+				if (!std::is_same<directed_category, boost::directed_tag>::value)
+				{
+					// Edge properties live in a list of the graph, 'm_edges' (see boost::add_edge)
+					std::vector<_t_edge_container> staged(n_threads);
+					detail::parallel_for(n, n_threads, [&](unsigned thread, std::size_t begin, std::size_t end)
+					{
+						arena_scope scope(*_arena);
+						arena_thread_cache cache(*_arena);
+						for (std::size_t i = begin; i < end; ++i)
+						{
+							if (index[i] != not_added)
+							{
+								const edge_entry& entry = entries[i];
+								staged[thread].push_back(typename _t_edge_container::value_type(std::get<1>(entry), std::get<2>(entry), _t_edge_property(index[i], std::get<0>(entry))));
+								properties[i] = std::prev(staged[thread].end());
+							}
+						}
+					});
+					for (typename std::vector<_t_edge_container>::iterator it = staged.begin(); it != staged.end(); ++it)
+					{
+						_graph.m_edges.splice(_graph.m_edges.end(), *it);
+					}
+				}
+
+				detail::parallel_for(n_threads, n_threads, [&](unsigned owner, std::size_t, std::size_t)
+				{
+					arena_scope scope(*_arena);
+					arena_thread_cache cache(*_arena);
+					for (std::size_t producer = 0; producer < shards.size(); ++producer)
+					{
+						// Producers took contiguous chunks in order, so every vertex gets its edges in order
+						const std::vector<std::size_t>& mine = shards[producer][owner];
+						for (std::vector<std::size_t>::const_iterator it = mine.begin(); it != mine.end(); ++it)
+						{
+							const std::size_t i = *it/2;
+							if (index[i] == not_added)
+							{
+								continue;
+							}
+							const edge_entry& entry = entries[i];
+							const edge_type_ptr& ptr = std::get<0>(entry);
+							if (*it % 2 == 0)
+							{
+								const edge_id id = this->stage_out_edge(std::get<1>(entry), std::get<2>(entry), index[i], ptr, properties[i], directed_category());
+								slots[i]->second = id;
+								_edge_by_index[index[i]] = id;
+								ptr->set_chart(_self, index[i]);
+								ptr->connect_source(_graph[std::get<1>(entry)].get());
+							}
+							else
+							{
+								this->stage_in_edge(std::get<1>(entry), std::get<2>(entry), properties[i], directed_category());
+								ptr->connect_target(_graph[std::get<2>(entry)].get());
+							}
+						}
+					}
+				});
+
+				std::vector<edge_id> ids; ids.reserve(n);
+				std::vector<typename _t_edges::value_type> added; added.reserve(n);
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					ids.push_back(slots[i]->second);
+					if (index[i] != not_added)
+					{
+						added.push_back(*slots[i]);
+						if (_components) _components->on_edge_added(std::get<1>(entries[i]), std::get<2>(entries[i]));
+						this->observe_degrees(std::get<1>(entries[i]), std::get<2>(entries[i])); // degrees only grow, same peak as one at a time
+					}
+				}
+				events::on_edges_added_to_chart(added, *this);
+				return ids;
+			};
+
+			void clear()
+			{
+				/*! Removes all the edges and vertices at once, in linear time: elements are
+				    detached from the chart and the whole graph storage is released in one go,
+				    without the per-element lookups and boost::remove_* calls.
+				*/
+				for (typename _t_edges::iterator it = _edges.begin(); it != _edges.end(); ++it)
+				{
+					it->first->remove_chart(_self);
+					events::on_edge_removed_from_chart(it->first, *this);
+				}
+				for (typename _t_vertices::iterator it = _vertices.begin(); it != _vertices.end(); ++it)
+				{
+					it->first->erase_chart(_self);
+					events::on_vertex_removed_from_chart(it->first, *this);
+				}
+
+				/* Edges disconnect from their vertices when destroyed, so vertices must be
+				   kept alive (by '_vertices') until the graph has released all the edges.
+				*/
+				_edges.clear();
+				_graph.clear();
+				_vertices.clear();
+				std::vector<edge_id>().swap(_edge_by_index);
+				std::vector<vertex_id>().swap(_vertex_by_index);
+				if (_components) _components->on_clear();
+			};
+
 			const _t_vertices& get_vertices() const { return _vertices;};
 			const _t_edges& get_edges() const { return _edges;};
 
 			vertex_type_ptr get_vertex(const vertex_id& id) const { return _graph[id];};
 			edge_type_ptr get_edge(const edge_id& id) const { return _graph[id];};
 
-			vertex_id get_vertex_id(const vertex_type_ptr& ptr) const { return _vertices.find(ptr)->second;};
-			edge_id get_edge_id(const edge_type_ptr& ptr) const { return _edges.find(ptr)->second;};
+			vertex_id get_vertex_id(const vertex_type_ptr& ptr) const
+			{
+				typename metrics_type::scope timing(_metrics, chart_metrics::LOOKUP);
+				return _vertices.find(ptr)->second;
+			};
+
+			edge_id get_edge_id(const edge_type_ptr& ptr) const
+			{
+				typename metrics_type::scope timing(_metrics, chart_metrics::LOOKUP);
+				return _edges.find(ptr)->second;
+			};
+
+			/*! Dense indices: vertices and edges are numbered in [0, num_vertices) and [0, num_edges)
+			    at any time, so BGL algorithms can use iterator_property_map/vector_property_map
+			    over these property maps. Removing an element moves the last one to its index.
+			*/
+			size_t num_vertices() const { return _vertex_by_index.size();};
+			size_t num_edges() const { return _edge_by_index.size();};
+
+			vertex_index_map get_vertex_index_map() const { return boost::get(boost::vertex_index, _graph);};
+			edge_index_map get_edge_index_map() const { return boost::get(boost::edge_index, _graph);};
+
+			size_t get_vertex_index(const vertex_id& id) const { return boost::get(boost::vertex_index, _graph, id);};
+			size_t get_edge_index(const edge_id& id) const { return boost::get(boost::edge_index, _graph, id);};
+
+			const vertex_id& get_vertex_at(size_t index) const { return _vertex_by_index[index];};
+			const edge_id& get_edge_at(size_t index) const { return _edge_by_index[index];};
+
+			/*! Adjacency as ranges over the graph itself (no copies nor allocations), to be used
+			    in range-for loops. For UNDIRECTED charts 'out_edges' are all the edges of the
+			    vertex and 'adjacent_vertices' all its neighbours; for the other behaviours they
+			    follow the direction of the edges (see also 'chart_behaviour').
+			    Ranges are invalidated by the modifications of the chart.
+			*/
+			out_edge_range out_edges(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::out_edges(vertex, _graph));
+			};
+
+			adjacency_range adjacent_vertices(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::adjacent_vertices(vertex, _graph));
+			};
 
 			size_t connected_components(_t_connected_components& vertex_at_cmp) const
 			{
@@ -187,22 +604,332 @@ namespace detail
 				                 http://lists.boost.org/boost-users/2007/08/30612.php
 				                 http://www.boost.org/doc/libs/1_35_0/libs/graph/doc/faq.html
 				*/
+				typename metrics_type::scope timing(_metrics, chart_metrics::CONNECTED_COMPONENTS);
+				std::vector<size_t> component(this->num_vertices());
+				size_t n_components = boost::connected_components(_graph, boost::make_iterator_property_map(component.begin(), this->get_vertex_index_map()));
 
-				boost::associative_property_map< _t_connected_components > component_map(vertex_at_cmp);
-
-				size_t index = 0;
-				BGL_FORALL_VERTICES(v, _graph, _t_graph)
+				for (size_t index = 0; index < component.size(); ++index)
 				{
-					boost::put(component_map, v, index++);
+					vertex_at_cmp[_vertex_by_index[index]] = component[index];
 				}
+				return n_components;
+			}
+
+			size_t connected_components(std::vector<size_t>& vertex_at_cmp, unsigned n_threads) const
+			{
+				/*! Multi-threaded version ('n_threads' = 0 uses all the cores), results are keyed by
+				    the dense vertex index (see 'get_vertex_index'). On UNDIRECTED charts they are the
+				    same as the serial version, direction is ignored for the other behaviours (weakly
+				    connected components).
+				*/
+				typename metrics_type::scope timing(_metrics, chart_metrics::CONNECTED_COMPONENTS);
+				parallel_component_roots(this->num_vertices(), this->num_edges(), [this](size_t e)
+				{
+					const edge_id& id = _edge_by_index[e];
+					return std::make_pair(this->get_vertex_index(boost::source(id, _graph)), this->get_vertex_index(boost::target(id, _graph)));
+				}, vertex_at_cmp, n_threads);
 
-				return boost::connected_components(_graph, component_map);
+				// Number components in the order the serial algorithm discovers them
+				std::vector<size_t> number(vertex_at_cmp.size(), size_t(-1));
+				size_t n_components = 0;
+				typename boost::graph_traits<_t_graph>::vertex_iterator v_it, v_end;
+				for (boost::tie(v_it, v_end) = boost::vertices(_graph); v_it != v_end; ++v_it)
+				{
+					size_t& root_number = number[vertex_at_cmp[this->get_vertex_index(*v_it)]];
+					if (root_number == size_t(-1))
+					{
+						root_number = n_components++;
+					}
+				}
+				for (size_t index = 0; index < vertex_at_cmp.size(); ++index)
+				{
+					vertex_at_cmp[index] = number[vertex_at_cmp[index]];
+				}
+				return n_components;
 			}
 
+			size_t strong_components(std::vector<size_t>& vertex_at_cmp) const
+			{
+				/*! Strongly connected components of DIRECTED and BIDIRECTIONAL charts, keyed by the
+				    dense vertex index and numbered in reverse topological order: an edge between
+				    two components goes from the higher number to the lower one. Iterative, see
+				    'detail::strong_components'.
+				*/
+				static_assert(Behaviour != UNDIRECTED, "strongly connected components need DIRECTED or BIDIRECTIONAL charts");
+				return detail::strong_components(this->num_vertices(), this->out_targets(), vertex_at_cmp);
+			};
+
+			size_t strong_components(std::vector<size_t>& vertex_at_cmp, unsigned n_threads) const
+			{
+				/*! Multi-threaded version ('n_threads' = 0 uses all the cores): same components,
+				    numbered in order of their first vertex, see 'detail::parallel_strong_components'.
+				*/
+				static_assert(Behaviour != UNDIRECTED, "strongly connected components need DIRECTED or BIDIRECTIONAL charts");
+				return detail::parallel_strong_components(this->num_vertices(), this->out_targets(), vertex_at_cmp, n_threads);
+			};
+
+			bool topological_order(std::vector<size_t>& order) const
+			{
+				/*! Dense vertex indices sorted so that every edge goes forwards. Returns false if the
+				    chart has cycles, see 'detail::topological_order'.
+				*/
+				static_assert(Behaviour != UNDIRECTED, "topological order needs DIRECTED or BIDIRECTIONAL charts");
+				return detail::topological_order(this->num_vertices(), this->out_targets(), order);
+			};
+
+			/*! Incremental connected components (opt-in): once enabled the chart keeps a
+			    union-find up to date on every addition, so 'same_component' and 'component_of'
+			    cost O(α(n)) instead of a full 'connected_components' run. Removals are applied
+			    lazily on the next query, recomputing only the components they touched. See
+			    'component_tracker'.
+			*/
+			void enable_component_tracking()
+			{
+				if (!_components)
+				{
+					_components.reset(new component_tracker<chart_impl>(*this));
+				}
+			};
+
+			void disable_component_tracking() { _components.reset();};
+			bool is_component_tracking_enabled() const { return static_cast<bool>(_components);};
+
+			bool same_component(const vertex_id& u, const vertex_id& v) const { return this->get_component_tracker().same_component(u, v);};
+			size_t component_of(const vertex_id& v) const { return this->get_component_tracker().component_of(v);};
+			size_t num_components() const { return this->get_component_tracker().num_components();};
+
+			/*! Events (opt-in): once enabled every mutation is queued as an 'event_type' and
+			    delivered in batches to the listeners, see 'chart_observer'. Charts with a
+			    'static_listener' have them enabled from the start. While disabled, mutations
+			    only pay for a null pointer check.
+			*/
+			observer_type& enable_events(std::size_t capacity = 4096)
+			{
+				if (!_observer)
+				{
+					_observer.reset(new observer_type(*this, capacity));
+				}
+				return *_observer;
+			};
+
+			void disable_events() { _observer.reset();}; // pending events are delivered first
+			observer_type* get_observer() const { return _observer.get();};
+
+			const std::shared_ptr<chart_arena>& get_arena() const { return _arena;};
+
+			frozen_chart<chart_impl> freeze() const
+			{
+				/*! Builds an immutable CSR snapshot of the chart for read-mostly traversals,
+				    see 'frozen_chart'.
+				*/
+				return frozen_chart<chart_impl>(*this);
+			};
+
+			/*! Views of the chart without copying it (see 'filtered_chart'): the subgraph induced
+			    by the vertices satisfying 'vertex_predicate', the chart without the edges failing
+			    'edge_predicate', or both.
+			*/
+			template <class VertexPredicate>
+			filtered_chart<chart_impl, VertexPredicate> induced(VertexPredicate vertex_predicate) const
+			{
+				return filtered_chart<chart_impl, VertexPredicate>(*this, vertex_predicate);
+			};
+
+			template <class EdgePredicate>
+			filtered_chart<chart_impl, boost::keep_all, EdgePredicate> edge_filtered(EdgePredicate edge_predicate) const
+			{
+				return filtered_chart<chart_impl, boost::keep_all, EdgePredicate>(*this, boost::keep_all(), edge_predicate);
+			};
+
+			template <class VertexPredicate, class EdgePredicate>
+			filtered_chart<chart_impl, VertexPredicate, EdgePredicate> filtered(VertexPredicate vertex_predicate, EdgePredicate edge_predicate) const
+			{
+				return filtered_chart<chart_impl, VertexPredicate, EdgePredicate>(*this, vertex_predicate, edge_predicate);
+			};
+
+			chart_metrics get_metrics() const
+			{
+				/*! Counters and latency histograms of the operations if the chart is instrumented
+				    (see 'chart_instrumentation'; batch insertions are not timed), and its current
+				    size and memory. 'max_degree' and 'edge_set_bytes' are not maintained by the
+				    updates but summed here over all the vertices: each call is O(V), meant for
+				    periodic reports rather than hot paths.
+				*/
+				chart_metrics metrics;
+				_metrics.collect(metrics);
+				metrics.vertices = this->num_vertices();
+				metrics.edges = this->num_edges();
+				metrics.vertex_index_bytes = _vertices.heap_bytes() + _vertex_by_index.capacity()*sizeof(vertex_id);
+				metrics.edge_index_bytes = _edges.heap_bytes() + _edge_by_index.capacity()*sizeof(edge_id);
+				metrics.arena_bytes = _arena->get_bytes_used();
+				metrics.max_degree = metrics.edge_set_bytes = 0;
+				for (typename std::vector<vertex_id>::const_iterator it = _vertex_by_index.begin(); it != _vertex_by_index.end(); ++it)
+				{
+					metrics.max_degree = std::max(metrics.max_degree, this->degree(*it, typename boost::graph_traits<_t_graph>::directed_category()));
+					metrics.edge_set_bytes += _graph[*it]->get_edges_heap_bytes();
+				}
+				return metrics;
+			};
+
+			void reset_metrics() { _metrics.reset();}; // operations only
+
 		protected:
+			auto out_targets() const
+			{
+				// 'f(target)' for the outgoing edges of a dense vertex index
+				return [this](size_t v, auto f)
+				{
+					typename boost::graph_traits<_t_graph>::adjacency_iterator it, it_end;
+					for (boost::tie(it, it_end) = boost::adjacent_vertices(this->get_vertex_at(v), _graph); it != it_end; ++it)
+					{
+						f(this->get_vertex_index(*it));
+					}
+				};
+			};
+
+			void rollback_vertices(const std::vector<typename _t_vertices::value_type>& added)
+			{
+				// Undoes a failed 'add_vertices': these are isolated and the last dense indices
+				for (typename std::vector<typename _t_vertices::value_type>::const_reverse_iterator it = added.rbegin(); it != added.rend(); ++it)
+				{
+					_vertex_by_index.pop_back();
+					boost::remove_vertex(it->second, _graph);
+					_vertices.erase(_vertices.find(it->first));
+					it->first->erase_chart(_self);
+				}
+				if (_components && !added.empty()) _components.reset(new component_tracker<chart_impl>(*this)); // exceptional path, rebuilt
+			};
+
+			void rollback_edges(const std::vector<typename _t_edges::value_type>& added)
+			{
+				// Undoes a failed 'add_edges': these are the last dense indices, and were not connected before
+				for (typename std::vector<typename _t_edges::value_type>::const_reverse_iterator it = added.rbegin(); it != added.rend(); ++it)
+				{
+					_edge_by_index.pop_back();
+					boost::remove_edge(it->second, _graph);
+					_edges.erase(_edges.find(it->first));
+					it->first->remove_chart(_self);
+					it->first->disconnect();
+				}
+				if (_components && !added.empty()) _components.reset(new component_tracker<chart_impl>(*this));
+			};
+
+			void observe_degrees(const vertex_id& source, const vertex_id& target)
+			{
+				if (metrics_type::enabled)
+				{
+					_metrics.observe_degree(this->degree(source, typename boost::graph_traits<_t_graph>::directed_category()));
+					_metrics.observe_degree(this->degree(target, typename boost::graph_traits<_t_graph>::directed_category()));
+				}
+			};
+
+			/* 'parallel_add_edges' fills the graph as boost::add_edge does: the properties of the
+			   edges are kept in '_graph.m_edges' and referenced from the edge lists of both ends,
+			   but for DIRECTED graphs, where the out edge list of the source owns the property.
+			*/
+			typedef typename _t_graph::EdgeContainer _t_edge_container;
+			typedef typename std::remove_reference<decltype(std::declval<_t_graph&>().out_edge_list(vertex_id()))>::type::value_type _t_stored_edge;
+
+			edge_id stage_out_edge(const vertex_id& source, const vertex_id& target, size_t index, const edge_type_ptr& ptr, typename _t_edge_container::iterator, boost::directed_tag)
+			{
+				typename std::remove_reference<decltype(_graph.out_edge_list(source))>::type& out = _graph.out_edge_list(source);
+				out.push_back(_t_stored_edge(target, _t_edge_property(index, ptr)));
+				return edge_id(source, target, &out.back().get_property());
+			};
+			edge_id stage_out_edge(const vertex_id& source, const vertex_id& target, size_t, const edge_type_ptr&, typename _t_edge_container::iterator property, boost::undirected_tag)
+			{
+				_graph.out_edge_list(source).push_back(_t_stored_edge(target, property, &_graph.m_edges));
+				return edge_id(source, target, &property->get_property());
+			};
+			edge_id stage_out_edge(const vertex_id& source, const vertex_id& target, size_t, const edge_type_ptr&, typename _t_edge_container::iterator property, boost::bidirectional_tag)
+			{
+				_graph.out_edge_list(source).push_back(_t_stored_edge(target, property, &_graph.m_edges));
+				return edge_id(source, target, &property->get_property());
+			};
+
+			void stage_in_edge(const vertex_id&, const vertex_id&, typename _t_edge_container::iterator, boost::directed_tag) {};
+			void stage_in_edge(const vertex_id& source, const vertex_id& target, typename _t_edge_container::iterator property, boost::undirected_tag)
+			{
+				_graph.out_edge_list(target).push_back(_t_stored_edge(source, property, &_graph.m_edges));
+			};
+			void stage_in_edge(const vertex_id& source, const vertex_id& target, typename _t_edge_container::iterator property, boost::bidirectional_tag)
+			{
+				boost::in_edge_list(_graph, target).push_back(_t_stored_edge(source, property, &_graph.m_edges));
+			};
+
+			// Incident edges of a vertex, only the outgoing ones for DIRECTED charts
+			size_t degree(const vertex_id& v_id, boost::undirected_tag) const { return boost::out_degree(v_id, _graph);};
+			size_t degree(const vertex_id& v_id, boost::directed_tag) const { return boost::out_degree(v_id, _graph);};
+			size_t degree(const vertex_id& v_id, boost::bidirectional_tag) const { return boost::out_degree(v_id, _graph) + boost::in_degree(v_id, _graph);};
+
+			component_tracker<chart_impl>& get_component_tracker() const
+			{
+				if (!_components)
+				{
+					throw std::runtime_error("component tracking is not enabled");
+				}
+				return *_components;
+			};
+
+			void collect_incident_edges(const vertex_id& v_id, std::vector<edge_type_ptr>& edges, boost::undirected_tag) const
+			{
+				typename boost::graph_traits<_t_graph>::out_edge_iterator it, it_end;
+				for (boost::tie(it, it_end) = boost::out_edges(v_id, _graph); it != it_end; ++it)
+				{
+					// UNDIRECTED self-loops are listed twice
+					if (boost::target(*it, _graph) != v_id || std::find(edges.begin(), edges.end(), _graph[*it]) == edges.end())
+					{
+						edges.push_back(_graph[*it]);
+					}
+				}
+			};
+
+			void collect_incident_edges(const vertex_id& v_id, std::vector<edge_type_ptr>& edges, boost::bidirectional_tag) const
+			{
+				this->collect_incident_edges(v_id, edges, boost::undirected_tag());
+				typename boost::graph_traits<_t_graph>::in_edge_iterator it, it_end;
+				for (boost::tie(it, it_end) = boost::in_edges(v_id, _graph); it != it_end; ++it)
+				{
+					if (boost::source(*it, _graph) != v_id) // self-loops are already among the out edges
+					{
+						edges.push_back(_graph[*it]);
+					}
+				}
+			};
+
+			void collect_incident_edges(const vertex_id& v_id, std::vector<edge_type_ptr>& edges, boost::directed_tag) const
+			{
+				/* '_graph' does not store incoming edges for DIRECTED charts, the vertex does. They
+				   may belong to other charts: keep the ones indexed here (self-loops are out edges).
+				*/
+				this->collect_incident_edges(v_id, edges, boost::undirected_tag());
+				const typename vertex_type::_t_edges& incoming = _graph[v_id]->get_incoming();
+				for (typename vertex_type::_t_edges::const_iterator it = incoming.begin(); it != incoming.end(); ++it)
+				{
+					typename _t_edges::const_iterator e_it = _edges.find(edge_type_ptr(edge_type_ptr(), *it)); // non-owning key
+					if (e_it != _edges.end() && boost::source(e_it->second, _graph) != v_id)
+					{
+						edges.push_back(e_it->first);
+					}
+				}
+			};
+
+		protected:
+			/* Vertices and edges keep pointers to the (most derived) chart they belong to. The
+			   'chart' sets this pointer on construction, so there is no need to downcast from
+			   this virtual base at runtime (dynamic_cast): everything works without RTTI.
+			*/
+			chart_type* _self;
+
+			std::shared_ptr<chart_arena> _arena; // must outlive '_graph'
 			_t_graph _graph;
 			_t_vertices _vertices;
 			_t_edges _edges;
+			std::vector<vertex_id> _vertex_by_index; // vertex_id for each dense vertex index
+			std::vector<edge_id> _edge_by_index; // edge_id for each dense edge index
+			std::unique_ptr<component_tracker<chart_impl> > _components; // null unless tracking is enabled
+			std::unique_ptr<observer_type> _observer; // null unless events are enabled
+			mutable metrics_type _metrics; // empty unless the chart is instrumented
 	};
 
 
@@ -221,10 +948,15 @@ namespace detail
 	{
 			static_assert(true, "YES");
 			// Add some functions to 'chart' when vertex class implements vertex_inner behaviour
+			typedef chart_impl<VertexType, EdgeType, Behaviour> _t_base;
 		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::vertex_type;
+			using typename _t_base::vertex_type_ptr;
+
 			std::pair<vertex_id, bool> create_vertex(typename VertexType::inner_type_ptr inner)
 			{
-				vertex_type_ptr ptr(new vertex_type(inner));
+				vertex_type_ptr ptr = std::allocate_shared<vertex_type>(arena_allocator<vertex_type>(this->get_arena()), inner);
 				return this->add_vertex(ptr);
 			};
 	};
@@ -235,10 +967,16 @@ namespace detail
 	template <class VertexType, class EdgeType, int Behaviour, typename Enable=void>
 	class chart_edge_inner : public virtual chart_impl<VertexType, EdgeType, Behaviour>
 	{
+			typedef chart_impl<VertexType, EdgeType, Behaviour> _t_base;
 		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::edge_id;
+			using typename _t_base::edge_type;
+			using typename _t_base::edge_type_ptr;
+
 			std::pair<edge_id, bool> create_edge(const vertex_id& source, const vertex_id& target)
 			{
-				edge_type_ptr ptr(new edge_type());
+				edge_type_ptr ptr = std::allocate_shared<edge_type>(arena_allocator<edge_type>(this->get_arena()));
 				return this->add_edge(ptr, source, target);
 			};
 	};
@@ -248,12 +986,54 @@ namespace detail
 	: public virtual chart_impl<VertexType, EdgeType, Behaviour>
 	{
 		// Add some functions to 'chart' when vertex class implements vertex_inner behaviour
+			typedef chart_impl<VertexType, EdgeType, Behaviour> _t_base;
+		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::edge_id;
+			using typename _t_base::edge_type;
+			using typename _t_base::edge_type_ptr;
+		protected:
+			using typename _t_base::_t_graph;
+
 		public:
 			std::pair<edge_id, bool> create_edge(typename EdgeType::inner_type_ptr inner, const vertex_id& source, const vertex_id& target)
 			{
-				edge_type_ptr ptr(new edge_type(inner));
+				edge_type_ptr ptr = std::allocate_shared<edge_type>(arena_allocator<edge_type>(this->get_arena()), inner);
 				return this->add_edge(ptr, source, target);
 			};
+
+			/*! Weighted shortest paths from 'source', 'weight(inner)' returns the (non negative)
+			    weight of an edge given its 'EdgeType::inner_type'. 'distance' and 'parent' are
+			    keyed by the dense vertex index (see 'get_vertex_index'), unreachable vertices get
+			    numeric_limits<Distance>::max() and size_t(-1). Return the number of vertices reached.
+			*/
+			template <class Distance, class WeightFunction>
+			size_t dijkstra_shortest_paths(const vertex_id& source, WeightFunction weight, std::vector<Distance>& distance, std::vector<size_t>& parent) const
+			{
+				return detail::dijkstra_shortest_paths(this->num_vertices(), this->get_vertex_index(source), this->template weighted_out_edges<Distance>(weight), distance, parent);
+			};
+
+			template <class Distance, class WeightFunction>
+			size_t delta_stepping_shortest_paths(const vertex_id& source, WeightFunction weight, const Distance& delta, std::vector<Distance>& distance, std::vector<size_t>& parent, unsigned n_threads = 0) const
+			{
+				// Multi-threaded ('n_threads' = 0 uses all the cores), see 'detail::delta_stepping_shortest_paths' to choose 'delta'
+				return detail::delta_stepping_shortest_paths(this->num_vertices(), this->get_vertex_index(source), this->template weighted_out_edges<Distance>(weight), delta, distance, parent, n_threads);
+			};
+
+		protected:
+			template <class Distance, class WeightFunction>
+			auto weighted_out_edges(WeightFunction weight) const
+			{
+				// 'f(target, weight)' for the outgoing edges of a dense vertex index
+				return [this, weight](size_t v, auto f)
+				{
+					typename boost::graph_traits<_t_graph>::out_edge_iterator it, it_end;
+					for (boost::tie(it, it_end) = boost::out_edges(this->get_vertex_at(v), this->_graph); it != it_end; ++it)
+					{
+						f(this->get_vertex_index(boost::target(*it, this->_graph)), static_cast<Distance>(weight(this->_graph[*it]->get_obj())));
+					}
+				};
+			};
 	};
 
 
@@ -268,43 +1048,139 @@ namespace detail
 	template <class VertexType, class EdgeType>
 	class chart_behaviour<VertexType, EdgeType, BIDIRECTIONAL> : public virtual chart_impl<VertexType, EdgeType, BIDIRECTIONAL>
 	{
+			typedef chart_impl<VertexType, EdgeType, BIDIRECTIONAL> _t_base;
+		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::edge_id;
+			using typename _t_base::adjacency_range;
+			using typename _t_base::out_edge_range;
+		protected:
+			using typename _t_base::_t_graph;
+
+		public:
+			typedef boost::iterator_range<typename _t_graph::in_edge_iterator> in_edge_range;
+			typedef boost::iterator_range<typename _t_graph::inv_adjacency_iterator> inv_adjacency_range;
+			typedef boost::range::joined_range<const adjacency_range, const inv_adjacency_range> neighbor_range;
+
 		public:
 			// All this functions requires "Directional" graphs
 			void get_edges_outgoing(const vertex_id& vertex, std::vector<edge_id>& edges) const
 			{
-				boost::graph_traits<_t_graph>::out_edge_iterator it_begin, it_end;
-				boost::tie(it_begin, it_end) = boost::out_edges(vertex, _graph);
-				//std::copy(it_begin, it_end, edges.begin()); //! \todo TODO: Why not?
-				std::for_each(it_begin, it_end, [&edges](const edge_id& id) {edges.push_back(id);});
+				// 'edges' is appended to (std::copy would need a back_inserter), insert the whole range at once
+				out_edge_range range = this->out_edges(vertex);
+				edges.insert(edges.end(), range.begin(), range.end());
 			};
 
 			void get_edges_incoming(const vertex_id& vertex, std::vector<edge_id>& edges) const
 			{
-				//boost::graph_traits<_t_graph>::in_edge_iterator it_begin, it_end;
-				_t_graph::in_edge_iterator it_begin, it_end;
-				boost::tie(it_begin, it_end) = boost::in_edges(vertex, _graph);
-				//std::copy(it_begin, it_end, edges.begin()); //! \todo TODO: Why not?
-				std::for_each(it_begin, it_end, [&edges](const edge_id& id) {edges.push_back(id);});
+				in_edge_range range = this->in_edges(vertex);
+				edges.insert(edges.end(), range.begin(), range.end());
+			};
+
+			// Allocation-free ranges, see 'chart_impl::out_edges'
+			in_edge_range in_edges(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::in_edges(vertex, this->_graph));
+			};
+
+			inv_adjacency_range inv_adjacent_vertices(const vertex_id& vertex) const
+			{
+				// Sources of the incoming edges
+				return boost::make_iterator_range(boost::inv_adjacent_vertices(vertex, this->_graph));
+			};
+
+			neighbor_range neighbors(const vertex_id& vertex) const
+			{
+				// Both ways: targets of the outgoing edges followed by sources of the incoming ones
+				const adjacency_range outgoing = this->adjacent_vertices(vertex);
+				const inv_adjacency_range incoming = this->inv_adjacent_vertices(vertex);
+				return neighbor_range(outgoing, incoming);
 			};
 
 			vertex_id get_source(const edge_id& edge) const
 			{
-				return boost::source(edge, _graph);
+				return boost::source(edge, this->_graph);
 			};
 
 			vertex_id get_target(const edge_id& edge) const
 			{
-				return boost::target(edge, _graph);
+				return boost::target(edge, this->_graph);
+			};
+
+			reversed_chart<chart_impl<VertexType, EdgeType, BIDIRECTIONAL> > reversed() const
+			{
+				// View with all the edges reversed (see 'reversed_chart')
+				return reversed_chart<chart_impl<VertexType, EdgeType, BIDIRECTIONAL> >(*this);
+			};
+
+			size_t parallel_breadth_first(const vertex_id& source, std::vector<size_t>& distance, std::vector<size_t>& parent, unsigned n_threads = 0) const
+			{
+				/*! Multi-threaded BFS from 'source' ('n_threads' = 0 uses all the cores), switching
+				    to bottom-up steps through the incoming edges while the frontier is large (see
+				    'detail::parallel_direction_optimizing_bfs'). 'distance' and 'parent' are keyed
+				    by the dense vertex index (see 'get_vertex_index'), size_t(-1) for unreachable
+				    vertices. Returns the number of vertices reached.
+				*/
+				return parallel_direction_optimizing_bfs(this->num_vertices(), this->num_edges(), this->get_vertex_index(source),
+					[this](size_t v)
+					{
+						return boost::out_degree(this->get_vertex_at(v), this->_graph);
+					},
+					[this](size_t v, auto visit)
+					{
+						typename _t_graph::adjacency_iterator it, it_end;
+						for (boost::tie(it, it_end) = boost::adjacent_vertices(this->get_vertex_at(v), this->_graph); it != it_end; ++it)
+						{
+							visit(this->get_vertex_index(*it));
+						}
+					},
+					[this](size_t v, auto visit)
+					{
+						typename _t_graph::in_edge_iterator it, it_end;
+						for (boost::tie(it, it_end) = boost::in_edges(this->get_vertex_at(v), this->_graph); it != it_end; ++it)
+						{
+							if (visit(this->get_vertex_index(boost::source(*it, this->_graph))))
+							{
+								return;
+							}
+						}
+					},
+					distance, parent, n_threads);
 			};
 	};
 	
 	template <class VertexType, class EdgeType>
 	class chart_behaviour<VertexType, EdgeType, UNDIRECTED> : public virtual chart_impl<VertexType, EdgeType, UNDIRECTED>
 	{
+			typedef chart_impl<VertexType, EdgeType, UNDIRECTED> _t_base;
 		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::edge_id;
+			using typename _t_base::adjacency_range;
+
 			std::pair<vertex_id, vertex_id> get_connected(const edge_id& edge) const
 			{
-				return std::make_pair(boost::source(edge, _graph), boost::target(edge, _graph));
+				return std::make_pair(boost::source(edge, this->_graph), boost::target(edge, this->_graph));
+			};
+
+			adjacency_range neighbors(const vertex_id& vertex) const
+			{
+				return this->adjacent_vertices(vertex);
+			};
+	};
+
+	template <class VertexType, class EdgeType>
+	class chart_behaviour<VertexType, EdgeType, DIRECTED> : public virtual chart_impl<VertexType, EdgeType, DIRECTED>
+	{
+			typedef chart_impl<VertexType, EdgeType, DIRECTED> _t_base;
+		public:
+			using typename _t_base::vertex_id;
+			using typename _t_base::adjacency_range;
+
+			adjacency_range neighbors(const vertex_id& vertex) const
+			{
+				// Only forwards, incoming edges are hidden
+				return this->adjacent_vertices(vertex);
 			};
 	};
 }
@@ -318,6 +1194,7 @@ class chart : public virtual detail::chart_impl<VertexType, EdgeType, Behaviour>
               public virtual detail::chart_behaviour<VertexType, EdgeType, Behaviour>
 {
 	public:
+		chart() { this->_self = this;};
 		virtual ~chart() {};
 };
 
@@ -0,0 +1,380 @@
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace core { namespace graph { namespace detail {
+
+/*! Index policies used by 'chart_impl' to map every vertex/edge object to its
+    descriptor inside the boost graph (chart_impl::_vertices and chart_impl::_edges).
+
+    Any policy must provide a (small) subset of the std::map interface, storing
+    'std::pair<Ptr, Id>' values:
+        begin(), end(), size(), find(ptr), insert(pair), erase(iterator), reserve(n), clear()
+    and 'heap_bytes()', the memory it holds (only used by 'chart_impl::get_metrics').
+
+    The policies are template parameters of 'chart_traits', given as selectors
+    ('hashed_indexS', 'intrusive_indexS' or any class with a nested 'bind<Ptr, Id>::type').
+    They default to 'default_indexS', which asks 'index_traits' for the element type:
+    users can either specialize 'index_traits' for their type or 'chart_traits' for their
+    chart, deriving from the 'chart_traits' with the selectors they want.
+*/
+
+template <class Ptr, class Id> class hashed_index;
+template <typename T> struct is_vertex_multichart;
+
+namespace _impl
+{
+	template <class Value>
+	class index_slot_iterator
+	{
+		/*! Iterates over the occupied slots of an open-addressing table, empty slots
+		    are those holding a null pointer.
+		*/
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef typename std::remove_const<Value>::type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef Value* pointer;
+			typedef Value& reference;
+
+		public:
+			index_slot_iterator() : _slot(0), _end(0) {};
+			index_slot_iterator(Value* slot, Value* end) : _slot(slot), _end(end) { skip();};
+
+			template <class Other>
+			index_slot_iterator(const index_slot_iterator<Other>& other) : _slot(other._slot), _end(other._end) {};
+
+			Value& operator*() const { return *_slot;};
+			Value* operator->() const { return _slot;};
+
+			index_slot_iterator& operator++() { ++_slot; skip(); return *this;};
+			index_slot_iterator operator++(int) { index_slot_iterator ret(*this); ++(*this); return ret;};
+
+			template <class Other>
+			bool operator==(const index_slot_iterator<Other>& other) const { return _slot == other._slot;};
+			template <class Other>
+			bool operator!=(const index_slot_iterator<Other>& other) const { return _slot != other._slot;};
+
+		protected:
+			template <class Other> friend class index_slot_iterator;
+			template <class Ptr, class Id> friend class core::graph::detail::hashed_index;
+
+			void skip()
+			{
+				while (_slot != _end && !_slot->first)
+				{
+					++_slot;
+				}
+			};
+
+		protected:
+			Value* _slot;
+			Value* _end;
+	};
+}
+
+
+/*************
+*   HASHED INDEX
+*************/
+template <class Ptr, class Id>
+class hashed_index
+{
+	/*! Open-addressing hash table (linear probing, backward-shift deletion) keyed by the
+	    address of the object. Lookups touch a contiguous array and insertions do not
+	    allocate except when the table grows.
+	*/
+	public:
+		typedef std::pair<Ptr, Id> value_type;
+		typedef _impl::index_slot_iterator<value_type> iterator;
+		typedef _impl::index_slot_iterator<const value_type> const_iterator;
+
+	public:
+		hashed_index() : _size(0) {};
+
+		iterator begin() { return iterator(_slots.data(), _slots.data() + _slots.size());};
+		iterator end() { return iterator(_slots.data() + _slots.size(), _slots.data() + _slots.size());};
+		const_iterator begin() const { return const_iterator(_slots.data(), _slots.data() + _slots.size());};
+		const_iterator end() const { return const_iterator(_slots.data() + _slots.size(), _slots.data() + _slots.size());};
+
+		std::size_t size() const { return _size;};
+		bool empty() const { return _size == 0;};
+		std::size_t heap_bytes() const { return _slots.capacity()*sizeof(value_type);};
+
+		iterator find(const Ptr& ptr)
+		{
+			if (_size == 0) return end();
+			std::size_t pos = this->probe(ptr.get());
+			return _slots[pos].first ? this->at(pos) : end();
+		};
+
+		const_iterator find(const Ptr& ptr) const
+		{
+			if (_size == 0) return end();
+			std::size_t pos = this->probe(ptr.get());
+			return _slots[pos].first ? const_iterator(_slots.data() + pos, _slots.data() + _slots.size()) : end();
+		};
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			if ((_size + 1)*4 > _slots.size()*3)
+			{
+				this->rehash(_slots.empty() ? 16 : _slots.size()*2);
+			}
+			std::size_t pos = this->probe(value.first.get());
+			if (_slots[pos].first)
+			{
+				return std::make_pair(this->at(pos), false);
+			}
+			_slots[pos] = value;
+			++_size;
+			return std::make_pair(this->at(pos), true);
+		};
+
+		void erase(iterator it)
+		{
+			const std::size_t mask = _slots.size() - 1;
+			std::size_t hole = it._slot - _slots.data();
+			_slots[hole] = value_type();
+			--_size;
+
+			// Backward-shift the elements of the cluster so no tombstones are needed
+			for (std::size_t next = (hole + 1) & mask; _slots[next].first; next = (next + 1) & mask)
+			{
+				std::size_t ideal = hash(_slots[next].first.get()) & mask;
+				if (((next - ideal) & mask) >= ((next - hole) & mask))
+				{
+					_slots[hole] = std::move(_slots[next]);
+					_slots[next] = value_type();
+					hole = next;
+				}
+			}
+		};
+
+		void reserve(std::size_t n)
+		{
+			std::size_t capacity = 16;
+			while (capacity*3 < n*4)
+			{
+				capacity *= 2;
+			}
+			if (capacity > _slots.size())
+			{
+				this->rehash(capacity);
+			}
+		};
+
+		void clear()
+		{
+			std::vector<value_type>().swap(_slots);
+			_size = 0;
+		};
+
+	protected:
+		static std::size_t hash(const void* ptr)
+		{
+			std::uint64_t h = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(ptr));
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return static_cast<std::size_t>(h);
+		};
+
+		std::size_t probe(const void* ptr) const
+		{
+			// Position of 'ptr' or of the empty slot where it should be inserted
+			const std::size_t mask = _slots.size() - 1;
+			std::size_t pos = hash(ptr) & mask;
+			while (_slots[pos].first && _slots[pos].first.get() != ptr)
+			{
+				pos = (pos + 1) & mask;
+			}
+			return pos;
+		};
+
+		iterator at(std::size_t pos)
+		{
+			return iterator(_slots.data() + pos, _slots.data() + _slots.size());
+		};
+
+		void rehash(std::size_t capacity)
+		{
+			std::vector<value_type> old(capacity);
+			old.swap(_slots);
+			for (typename std::vector<value_type>::iterator it = old.begin(); it != old.end(); ++it)
+			{
+				if (it->first)
+				{
+					_slots[this->probe(it->first.get())] = std::move(*it);
+				}
+			}
+		};
+
+	protected:
+		std::vector<value_type> _slots; // size is always zero or a power of two
+		std::size_t _size;
+};
+
+
+/*************
+*   INTRUSIVE INDEX
+*************/
+class intrusive_indexed
+{
+	/*! Inherit vertex/edge classes from 'intrusive_indexed' to make the chart store the
+	    position of the element inside its index in the element itself: lookups are
+	    O(1) without hashing nor allocations.
+
+	    An intrusively indexed element can belong to only one chart at a time, so it cannot
+	    be a 'vertex_multichart'.
+	*/
+		template <class Ptr, class Id> friend class intrusive_index;
+	public:
+		intrusive_indexed() : _index_owner(0), _index_slot(0) {};
+		intrusive_indexed(const intrusive_indexed&) : _index_owner(0), _index_slot(0) {};
+		intrusive_indexed& operator=(const intrusive_indexed&) { return *this;};
+
+	protected:
+		const void* _index_owner;
+		std::size_t _index_slot;
+		static int IsIntrusiveIndexed;
+};
+
+template <class Ptr, class Id>
+class intrusive_index
+{
+	static_assert( !is_vertex_multichart<typename Ptr::element_type>::value, "multichart vertices belong to several charts, an intrusive index only keeps the slot of one: use 'hashed_indexS'" );
+	public:
+		typedef std::pair<Ptr, Id> value_type;
+		typedef typename std::vector<value_type>::iterator iterator;
+		typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	public:
+		intrusive_index() {};
+		intrusive_index(const intrusive_index&) = delete;
+		intrusive_index& operator=(const intrusive_index&) = delete;
+		~intrusive_index() { this->clear();};
+
+		iterator begin() { return _values.begin();};
+		iterator end() { return _values.end();};
+		const_iterator begin() const { return _values.begin();};
+		const_iterator end() const { return _values.end();};
+
+		std::size_t size() const { return _values.size();};
+		bool empty() const { return _values.empty();};
+		std::size_t heap_bytes() const { return _values.capacity()*sizeof(value_type);};
+
+		iterator find(const Ptr& ptr)
+		{
+			const intrusive_indexed& item = *ptr;
+			return (item._index_owner == this) ? _values.begin() + item._index_slot : _values.end();
+		};
+
+		const_iterator find(const Ptr& ptr) const
+		{
+			const intrusive_indexed& item = *ptr;
+			return (item._index_owner == this) ? _values.begin() + item._index_slot : _values.end();
+		};
+
+		std::pair<iterator, bool> insert(const value_type& value)
+		{
+			intrusive_indexed& item = *value.first;
+			if (item._index_owner == this)
+			{
+				return std::make_pair(_values.begin() + item._index_slot, false);
+			}
+			if (item._index_owner)
+			{
+				throw std::runtime_error("intrusive indexed element already belongs to another chart");
+			}
+			item._index_owner = this;
+			item._index_slot = _values.size();
+			_values.push_back(value);
+			return std::make_pair(_values.end() - 1, true);
+		};
+
+		void erase(iterator it)
+		{
+			// Swap with last so positions stay dense
+			intrusive_indexed& item = *it->first;
+			item._index_owner = 0;
+			if (it != _values.end() - 1)
+			{
+				*it = std::move(_values.back());
+				intrusive_indexed& moved = *it->first;
+				moved._index_slot = it - _values.begin();
+			}
+			_values.pop_back();
+		};
+
+		void reserve(std::size_t n) { _values.reserve(n);};
+
+		void clear()
+		{
+			for (iterator it = _values.begin(); it != _values.end(); ++it)
+			{
+				intrusive_indexed& item = *it->first;
+				item._index_owner = 0;
+			}
+			std::vector<value_type>().swap(_values);
+		};
+
+	protected:
+		std::vector<value_type> _values;
+};
+
+// SFINAE test for intrusive_indexed
+template <typename T> struct is_intrusive_indexed
+{
+	struct Fallback { int IsIntrusiveIndexed; }; // introduce member name "IsIntrusiveIndexed"
+	struct Derived : T, Fallback {};
+
+	template <typename C, C> struct ChT;
+
+	template<typename C> static char (&f(ChT<int Fallback::*, &C::IsIntrusiveIndexed>*))[1];
+	template<typename C> static char (&f(...))[2];
+
+	static bool const value = (sizeof(f<Derived>(0)) == 2);
+};
+
+
+/*************
+*   SELECTION
+*************/
+template <class T, class Id, typename Enable=void>
+struct index_traits
+{
+	typedef hashed_index<std::shared_ptr<T>, Id> type;
+};
+
+template <class T, class Id>
+struct index_traits<T, Id, typename std::enable_if<is_intrusive_indexed<T>::value>::type>
+{
+	typedef intrusive_index<std::shared_ptr<T>, Id> type;
+};
+
+// Selectors of the index policy, template parameters of 'chart_traits'
+struct hashed_indexS
+{
+	template <class Ptr, class Id> struct bind { typedef hashed_index<Ptr, Id> type; };
+};
+
+struct intrusive_indexS
+{
+	template <class Ptr, class Id> struct bind { typedef intrusive_index<Ptr, Id> type; };
+};
+
+template <class T>
+struct default_indexS
+{
+	template <class Ptr, class Id> struct bind { typedef typename index_traits<T, Id>::type type; };
+};
+
+}}}
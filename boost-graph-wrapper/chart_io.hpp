@@ -0,0 +1,478 @@
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <exception>
+#include <utility>
+#include <tuple>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <boost/graph/graph_selectors.hpp>
+
+#include "parallel.hpp"
+
+namespace core { namespace graph {
+
+namespace detail { template <class VertexType, class EdgeType, int Behaviour> class chart_impl; }
+
+/*! Text import/export of charts:
+      - 'write_graphviz': DOT, readable by boost::read_graphviz, dot,...
+      - 'write_edge_list'/'read_edge_list': one edge per line, "source target [label]", the
+        vertices being numbered by their dense index (see 'chart_impl::get_vertex_index').
+        Vertices without edges are written alone in a line, "vertex", so the topology is
+        kept; lines starting with '#' are comments.
+
+    Labels come from user writers called as 'writer(element, label)' for every vertex or
+    edge, appending to the std::string 'label' (usually from 'element.get_obj()', the inner
+    object). Nothing is written for elements with an empty label.
+
+    Output goes through a large buffer ('detail::buffered_writer') instead of an ostream call
+    per element, input is read and parsed by chunks: neither keeps the whole file in memory.
+*/
+struct no_label
+{
+	template <class Element>
+	void operator()(const Element&, std::string&) const {};
+};
+
+namespace detail {
+
+class buffered_writer
+{
+	// Output buffer flushed to an ostream when full (or on 'flush')
+	public:
+		explicit buffered_writer(std::ostream& out, std::size_t capacity = 1 << 20) : _out(out), _capacity(capacity)
+		{
+			_buffer.reserve(capacity);
+		};
+
+		void append(char c)
+		{
+			if (_buffer.size() == _capacity)
+			{
+				this->flush_buffer();
+			}
+			_buffer.push_back(c);
+		};
+
+		void append(const char* data, std::size_t n)
+		{
+			if (_buffer.size() + n > _capacity)
+			{
+				this->flush_buffer();
+			}
+			_buffer.insert(_buffer.end(), data, data + n);
+		};
+
+		void append(const char* text) { this->append(text, std::strlen(text));};
+		void append(const std::string& text) { this->append(text.data(), text.size());};
+
+		void append_number(std::uint64_t value)
+		{
+			char digits[20];
+			char* begin = digits + sizeof(digits);
+			do
+			{
+				*--begin = static_cast<char>('0' + value % 10);
+				value /= 10;
+			} while (value);
+			this->append(begin, digits + sizeof(digits) - begin);
+		};
+
+		void append_quoted(const std::string& text)
+		{
+			// DOT string: between double quotes, with '"' and '\' escaped
+			this->append('"');
+			for (std::string::const_iterator it = text.begin(); it != text.end(); ++it)
+			{
+				if (*it == '"' || *it == '\\')
+				{
+					this->append('\\');
+				}
+				this->append(*it);
+			}
+			this->append('"');
+		};
+
+		void flush()
+		{
+			this->flush_buffer();
+			_out.flush();
+			if (!_out)
+			{
+				throw std::runtime_error("error writing the output stream");
+			}
+		};
+
+	protected:
+		void flush_buffer()
+		{
+			_out.write(_buffer.data(), _buffer.size());
+			_buffer.clear();
+		};
+
+	protected:
+		std::ostream& _out;
+		std::size_t _capacity;
+		std::vector<char> _buffer;
+};
+
+template <class Chart>
+class edge_endpoints
+{
+	// Dense indices of the endpoints of the edges, for any behaviour
+	public:
+		explicit edge_endpoints(const Chart& chart) : _chart(chart) {};
+
+		std::size_t source(std::size_t edge) const { return edge_endpoints::source_of(_chart, _chart.get_edge_at(edge));};
+		std::size_t target(std::size_t edge) const { return edge_endpoints::target_of(_chart, _chart.get_edge_at(edge));};
+
+	protected:
+		template <class VertexType, class EdgeType, int Behaviour>
+		static std::size_t source_of(const chart_impl<VertexType, EdgeType, Behaviour>& chart, const typename chart_impl<VertexType, EdgeType, Behaviour>::edge_id& edge)
+		{
+			return chart.get_vertex_index(boost::source(edge, chart._graph));
+		};
+
+		template <class VertexType, class EdgeType, int Behaviour>
+		static std::size_t target_of(const chart_impl<VertexType, EdgeType, Behaviour>& chart, const typename chart_impl<VertexType, EdgeType, Behaviour>::edge_id& edge)
+		{
+			return chart.get_vertex_index(boost::target(edge, chart._graph));
+		};
+
+	protected:
+		const Chart& _chart;
+};
+
+struct edge_list_record
+{
+	// Parsed line, 'target' is 'none' for a lonely vertex, the label is [label_begin, label_end) of the chunk
+	static const std::uint64_t none = std::uint64_t(-1);
+	std::uint64_t source, target;
+	std::size_t label_begin, label_end;
+};
+
+inline bool parse_number(const char*& it, const char* end, std::uint64_t& value)
+{
+	const char* begin = it;
+	value = 0;
+	for (; it != end && *it >= '0' && *it <= '9'; ++it)
+	{
+		// Reject overflow (and 'none'): the id is used to size the vertex tables
+		const std::uint64_t digit = static_cast<std::uint64_t>(*it - '0');
+		if (value > (edge_list_record::none - 1 - digit)/10)
+		{
+			return false;
+		}
+		value = 10*value + digit;
+	}
+	return it != begin && (it == end || *it == ' ' || *it == '\t' || *it == '\r');
+}
+
+inline const char* skip_blanks(const char* it, const char* end)
+{
+	while (it != end && (*it == ' ' || *it == '\t'))
+	{
+		++it;
+	}
+	return it;
+}
+
+inline void parse_edge_list(const char* chunk, std::size_t begin, std::size_t end, std::vector<edge_list_record>& records)
+{
+	// Lines of 'chunk' in [begin, end), which is made of whole lines
+	const char* it = chunk + begin;
+	const char* const stop = chunk + end;
+	while (it != stop)
+	{
+		const char* line_end = static_cast<const char*>(std::memchr(it, '\n', stop - it));
+		if (!line_end)
+		{
+			line_end = stop;
+		}
+		const char* content_end = (line_end != it && line_end[-1] == '\r') ? line_end - 1 : line_end;
+
+		it = skip_blanks(it, content_end);
+		if (it != content_end && *it != '#')
+		{
+			edge_list_record record;
+			if (!parse_number(it, content_end, record.source))
+			{
+				throw std::runtime_error("malformed edge list line: '" + std::string(chunk + begin, content_end).substr(0, 80) + "'");
+			}
+			it = skip_blanks(it, content_end);
+			record.target = edge_list_record::none;
+			if (it != content_end && !parse_number(it, content_end, record.target))
+			{
+				throw std::runtime_error("malformed edge list line, bad target: '" + std::string(chunk + begin, content_end).substr(0, 80) + "'");
+			}
+			it = skip_blanks(it, content_end);
+			if (record.target == edge_list_record::none && it != content_end)
+			{
+				throw std::runtime_error("malformed edge list line, label without target");
+			}
+			record.label_begin = it - chunk;
+			record.label_end = content_end - chunk;
+			records.push_back(record);
+		}
+		it = (line_end == stop) ? stop : line_end + 1;
+		begin = it - chunk;
+	}
+}
+
+}
+
+
+template <class Chart, class VertexLabel, class EdgeLabel>
+void write_graphviz(std::ostream& out, const Chart& chart, VertexLabel vertex_label, EdgeLabel edge_label)
+{
+	const bool undirected = std::is_same<typename Chart::behaviour, boost::undirectedS>::value;
+	const detail::edge_endpoints<Chart> endpoints(chart);
+	detail::buffered_writer writer(out);
+	std::string label;
+
+	writer.append(undirected ? "graph G {\n" : "digraph G {\n");
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		label.clear();
+		vertex_label(*chart.get_vertex(chart.get_vertex_at(v)), label);
+		writer.append_number(v);
+		if (!label.empty())
+		{
+			writer.append(" [label=");
+			writer.append_quoted(label);
+			writer.append(']');
+		}
+		writer.append(";\n");
+	}
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		label.clear();
+		edge_label(*chart.get_edge(chart.get_edge_at(e)), label);
+		writer.append_number(endpoints.source(e));
+		writer.append(undirected ? "--" : "->");
+		writer.append_number(endpoints.target(e));
+		if (!label.empty())
+		{
+			writer.append(" [label=");
+			writer.append_quoted(label);
+			writer.append(']');
+		}
+		writer.append(";\n");
+	}
+	writer.append("}\n");
+	writer.flush();
+}
+
+template <class Chart>
+void write_graphviz(std::ostream& out, const Chart& chart)
+{
+	write_graphviz(out, chart, no_label(), no_label());
+}
+
+template <class Chart, class EdgeLabel>
+void write_edge_list(std::ostream& out, const Chart& chart, EdgeLabel edge_label)
+{
+	// Labels are written as they are up to the end of the line, they cannot contain line breaks
+	const detail::edge_endpoints<Chart> endpoints(chart);
+	detail::buffered_writer writer(out);
+	std::vector<bool> has_edges(chart.num_vertices(), false);
+	std::string label;
+
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const std::size_t source = endpoints.source(e), target = endpoints.target(e);
+		has_edges[source] = has_edges[target] = true;
+		label.clear();
+		edge_label(*chart.get_edge(chart.get_edge_at(e)), label);
+		writer.append_number(source);
+		writer.append(' ');
+		writer.append_number(target);
+		if (!label.empty())
+		{
+			writer.append(' ');
+			writer.append(label);
+		}
+		writer.append('\n');
+	}
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		if (!has_edges[v])
+		{
+			writer.append_number(v);
+			writer.append('\n');
+		}
+	}
+	writer.flush();
+}
+
+template <class Chart>
+void write_edge_list(std::ostream& out, const Chart& chart)
+{
+	write_edge_list(out, chart, no_label());
+}
+
+
+/*! Adds the edges (and vertices) of an edge list to 'chart' and returns the vertex of every
+    number of the file (null ids for the numbers not used). The file is read in chunks of
+    'chunk_size' bytes, the lines of a chunk are parsed by 'n_threads' threads (0 = all the
+    cores) and inserted with 'parallel_add_edges', so:
+      - 'make_vertex(number)' returns the vertex_type_ptr of a new vertex, it is called once
+        per number from the calling thread, in order of appearance;
+      - 'make_edge(label_begin, label_end)' returns the edge_type_ptr of an edge from its
+        label (maybe empty), it is called concurrently from several threads.
+    Edges are added in the order of the file. Vertex numbers are used as indices, they
+    should be dense (as written by 'write_edge_list'): tables are sized by the highest
+    number, so numbers from 'max_vertices' on are rejected instead of allocating for them.
+    Throws std::runtime_error on malformed lines and rejected numbers, edges of the chunks
+    before the bad one are already in the chart.
+*/
+template <class Chart, class VertexFactory, class EdgeFactory>
+std::vector<typename Chart::vertex_id> read_edge_list(std::istream& in, Chart& chart, VertexFactory make_vertex, EdgeFactory make_edge,
+                                                      unsigned n_threads = 0, std::size_t chunk_size = 16 << 20,
+                                                      std::uint64_t max_vertices = std::uint64_t(1) << 27)
+{
+	typedef typename Chart::vertex_id vertex_id;
+	typedef typename Chart::vertex_type_ptr vertex_type_ptr;
+	typedef typename Chart::edge_entry edge_entry;
+
+	std::vector<vertex_id> vertices;
+	std::vector<bool> known;
+	std::size_t n_numbers = 0; // highest number + 1
+	std::vector<char> chunk(chunk_size);
+	std::size_t carried = 0; // bytes of an incomplete line at the beginning of 'chunk'
+	std::vector<std::vector<detail::edge_list_record> > records;
+	std::vector<std::exception_ptr> errors;
+	std::vector<const detail::edge_list_record*> edges; // records that are edges, in order
+	std::vector<vertex_type_ptr> new_vertices;
+	std::vector<std::uint64_t> new_numbers;
+
+	while (in || carried)
+	{
+		if (carried == chunk.size())
+		{
+			chunk.resize(2*chunk.size()); // line longer than a chunk
+		}
+		in.read(chunk.data() + carried, chunk.size() - carried);
+		std::size_t size = carried + static_cast<std::size_t>(in.gcount());
+		std::size_t complete = size; // whole lines
+		if (in)
+		{
+			while (complete > 0 && chunk[complete - 1] != '\n')
+			{
+				--complete;
+			}
+			if (complete == 0)
+			{
+				carried = size;
+				continue;
+			}
+		}
+		if (size == 0)
+		{
+			break;
+		}
+
+		// Parse: the chunk is split at line boundaries, one slice per thread
+		const unsigned n_slices = detail::resolve_threads(n_threads, complete/4096 + 1);
+		records.assign(n_slices, std::vector<detail::edge_list_record>());
+		errors.assign(n_slices, std::exception_ptr());
+		std::vector<std::size_t> cuts(n_slices + 1, complete);
+		cuts[0] = 0;
+		for (unsigned s = 1; s < n_slices; ++s)
+		{
+			std::size_t cut = std::max(cuts[s - 1], s*(complete/n_slices));
+			while (cut < complete && cut > 0 && chunk[cut - 1] != '\n')
+			{
+				++cut;
+			}
+			cuts[s] = cut;
+		}
+		detail::parallel_for(n_slices, n_slices, [&](unsigned thread, std::size_t, std::size_t)
+		{
+			try
+			{
+				detail::parse_edge_list(chunk.data(), cuts[thread], cuts[thread + 1], records[thread]);
+			}
+			catch (...)
+			{
+				errors[thread] = std::current_exception();
+			}
+		});
+		for (unsigned s = 0; s < n_slices; ++s)
+		{
+			if (errors[s])
+			{
+				std::rethrow_exception(errors[s]);
+			}
+		}
+
+		// Vertices, in order of appearance
+		edges.clear();
+		new_vertices.clear();
+		new_numbers.clear();
+		for (unsigned s = 0; s < n_slices; ++s)
+		{
+			for (std::size_t r = 0; r < records[s].size(); ++r)
+			{
+				const detail::edge_list_record& record = records[s][r];
+				const std::uint64_t numbers[2] = {record.source, record.target};
+				for (int i = 0; i < 2 && numbers[i] != detail::edge_list_record::none; ++i)
+				{
+					if (numbers[i] >= max_vertices)
+					{
+						throw std::runtime_error("vertex number " + std::to_string(numbers[i]) + " in edge list is not below 'max_vertices' (" + std::to_string(max_vertices) + ")");
+					}
+					if (numbers[i] >= known.size())
+					{
+						known.resize(std::max<std::size_t>(numbers[i] + 1, 2*known.size()), false);
+					}
+					n_numbers = std::max<std::size_t>(n_numbers, numbers[i] + 1);
+					if (!known[numbers[i]])
+					{
+						known[numbers[i]] = true;
+						new_numbers.push_back(numbers[i]);
+						new_vertices.push_back(make_vertex(static_cast<std::size_t>(numbers[i])));
+					}
+				}
+				if (record.target != detail::edge_list_record::none)
+				{
+					edges.push_back(&record);
+				}
+			}
+		}
+		const std::vector<vertex_id> ids = chart.add_vertices(new_vertices);
+		vertices.resize(known.size());
+		for (std::size_t i = 0; i < ids.size(); ++i)
+		{
+			vertices[new_numbers[i]] = ids[i];
+		}
+
+		// Edges
+		const char* const data = chunk.data();
+		chart.parallel_add_edges(edges.size(), [&](std::size_t i)
+		{
+			const detail::edge_list_record& record = *edges[i];
+			return edge_entry(make_edge(data + record.label_begin, data + record.label_end), vertices[record.source], vertices[record.target]);
+		}, n_threads);
+
+		// The incomplete line goes to the beginning of the next chunk
+		carried = size - complete;
+		std::memmove(chunk.data(), chunk.data() + complete, carried);
+		if (!in && carried == 0)
+		{
+			break;
+		}
+	}
+	vertices.resize(n_numbers);
+	return vertices;
+}
+
+}}
@@ -5,6 +5,7 @@
 
 #include "vertex_traits.hpp"
 #include "edge_traits.hpp"
+#include "chart_index.hpp"
 
 namespace core { namespace graph { namespace detail {
 
@@ -56,20 +57,31 @@ namespace core { namespace graph { namespace detail {
 }
 
 
-template <class VertexType, class EdgeType, int Behaviour>
+/*! Types of a chart. 'VertexIndexS' and 'EdgeIndexS' select the index policies mapping the
+    elements to their descriptors (see chart_index.hpp); to change them for a chart, specialize
+    'chart_traits<VertexType, EdgeType, Behaviour>' deriving from the one with the selectors:
+        template <> struct chart_traits<MyVertex, MyEdge, UNDIRECTED>
+            : chart_traits<MyVertex, MyEdge, UNDIRECTED, detail::hashed_indexS, detail::hashed_indexS> {};
+*/
+template <class VertexType, class EdgeType, int Behaviour,
+          class VertexIndexS = detail::default_indexS<VertexType>, class EdgeIndexS = detail::default_indexS<EdgeType> >
 struct chart_traits
 {
 	// vertex type check
 	static_assert( detail::is_vertex_connected<VertexType>::value, "VertexType template argument must inherit form core::graph::detail::vertex_connected<EdgeType, Behaviour>" );
-	static_assert( detail::is_vertex_multichart<VertexType>::value, "VertexType template argument must inherit form core::graph::detail::vertex_multichart<Graph>" );
+	// 'vertex_multichart<Graph>' is optional: with Graph=void vertices do not know their charts
 
 	// edge type check
 	static_assert( detail::is_edge_connected<EdgeType>::value, "EdgeType template argument must inherit form core::graph::detail::edge_connected<VertexType, Behaviour>" );
-	static_assert( detail::is_edge_chart<EdgeType>::value, "EdgeType template argument must inherit form core::graph::detail::edge_chart<Graph>" );
+	// 'edge_chart<Graph>' is optional: with Graph=void edges do not know their chart
 
 	typedef typename detail::behaviour_traits<VertexType, EdgeType, Behaviour>::behaviour behaviour;
 	typedef VertexType vertex_type;
 	typedef EdgeType edge_type;
+
+	// Index policies mapping vertex/edge objects to their descriptors (see chart_index.hpp)
+	template <class VertexId> using vertex_index = typename VertexIndexS::template bind<std::shared_ptr<VertexType>, VertexId>::type;
+	template <class EdgeId> using edge_index = typename EdgeIndexS::template bind<std::shared_ptr<EdgeType>, EdgeId>::type;
 };
 
 }}
@@ -0,0 +1,440 @@
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <boost/graph/filtered_graph.hpp>
+#include <boost/graph/reverse_graph.hpp>
+#include <boost/graph/adjacency_iterator.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <boost/range/join.hpp>
+
+#include "components.hpp"
+#include "parallel_bfs.hpp"
+#include "shortest_paths.hpp"
+#include "strong_components.hpp"
+
+namespace core { namespace graph {
+
+namespace detail {
+
+	template <class VertexType, class EdgeType, int Behaviour> class chart_impl;
+
+	// The boost graph of a chart, to build the adaptors of the views
+	template <class Chart>
+	struct chart_graph
+	{
+		typedef typename Chart::_t_graph type;
+	};
+
+	template <class Predicate>
+	class view_predicate
+	{
+		/* Predicate of the boost::filtered_graph of a view. The filtered iterators copy,
+		   assign and default-construct their predicates (lambdas cannot be), so they only
+		   carry a pointer to the one kept by the view.
+		*/
+		public:
+			view_predicate() : _predicate(0) {};
+			explicit view_predicate(const Predicate* predicate) : _predicate(predicate) {};
+
+			template <class Descriptor>
+			bool operator()(const Descriptor& d) const { return (*_predicate)(d);};
+
+		protected:
+			const Predicate* _predicate;
+	};
+
+	// Edge id of the chart behind the edge id of a view (reversed views wrap them)
+	template <class EdgeId>
+	const EdgeId& underlying_edge_id(const EdgeId& id) { return id;}
+
+	template <class EdgeId>
+	const EdgeId& underlying_edge_id(const boost::detail::reverse_graph_edge_descriptor<EdgeId>& id) { return id.underlying_descx;}
+
+
+	/*! Query API of 'chart' over a boost adaptor ('Graph') of the graph of a chart, see
+	    'filtered_chart' and 'reversed_chart'. 'View' is the derived class, it tells which
+	    vertices and edges belong to the view ('contains').
+
+	    Vertices keep their ids and their dense indices in the chart: 'num_vertices' and
+	    'num_edges' are those of the chart (as for boost::filtered_graph), that is the size
+	    of the vectors keyed by dense index, 'count_vertices' and 'count_edges' walk the view.
+	    Results of the algorithms are size_t(-1) for the vertices out of the view.
+	*/
+	template <class View, class Chart, class Graph>
+	class chart_view
+	{
+		public:
+			typedef Chart underlying_chart;
+			typedef typename Chart::vertex_type vertex_type;
+			typedef typename Chart::edge_type edge_type;
+			typedef typename Chart::behaviour behaviour;
+			typedef typename Chart::vertex_type_ptr vertex_type_ptr;
+			typedef typename Chart::edge_type_ptr edge_type_ptr;
+
+			typedef Graph _t_graph;
+			typedef typename boost::graph_traits<_t_graph>::vertex_descriptor vertex_id;
+			typedef typename boost::graph_traits<_t_graph>::edge_descriptor edge_id;
+
+			typedef typename boost::property_map<_t_graph, boost::vertex_index_t>::const_type vertex_index_map;
+			typedef typename boost::property_map<_t_graph, boost::edge_index_t>::const_type edge_index_map;
+
+			typedef typename boost::graph_traits<_t_graph>::out_edge_iterator out_edge_iterator;
+			typedef typename boost::graph_traits<_t_graph>::adjacency_iterator adjacency_iterator;
+			typedef boost::iterator_range<out_edge_iterator> out_edge_range;
+			typedef boost::iterator_range<adjacency_iterator> adjacency_range;
+
+		public:
+			chart_view(const Chart& chart, const _t_graph& graph) : _chart(chart), _graph(graph) {};
+
+			const Chart& get_chart() const { return _chart;};
+			const _t_graph& get_graph() const { return _graph;}; // to run boost algorithms on the view
+
+			vertex_type_ptr get_vertex(const vertex_id& id) const { return _graph[id];};
+			edge_type_ptr get_edge(const edge_id& id) const { return _graph[id];};
+			typename Chart::edge_id get_chart_edge_id(const edge_id& id) const { return underlying_edge_id(id);};
+
+			size_t num_vertices() const { return _chart.num_vertices();};
+			size_t num_edges() const { return _chart.num_edges();};
+
+			size_t count_vertices() const
+			{
+				typename boost::graph_traits<_t_graph>::vertex_iterator it, it_end;
+				boost::tie(it, it_end) = boost::vertices(_graph);
+				return std::distance(it, it_end);
+			};
+
+			size_t count_edges() const
+			{
+				typename boost::graph_traits<_t_graph>::edge_iterator it, it_end;
+				boost::tie(it, it_end) = boost::edges(_graph);
+				return std::distance(it, it_end);
+			};
+
+			vertex_index_map get_vertex_index_map() const { return boost::get(boost::vertex_index, _graph);};
+			edge_index_map get_edge_index_map() const { return boost::get(boost::edge_index, _graph);};
+
+			size_t get_vertex_index(const vertex_id& id) const { return boost::get(boost::vertex_index, _graph, id);};
+			size_t get_edge_index(const edge_id& id) const { return boost::get(boost::edge_index, _graph, id);};
+
+			vertex_id get_vertex_at(size_t index) const { return _chart.get_vertex_at(index);};
+			edge_id get_edge_at(size_t index) const { return edge_id(_chart.get_edge_at(index));};
+
+			// Allocation-free ranges, see 'chart_impl::out_edges' (in the view both ends are)
+			out_edge_range out_edges(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::out_edges(vertex, _graph));
+			};
+
+			adjacency_range adjacent_vertices(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::adjacent_vertices(vertex, _graph));
+			};
+
+			// Incoming edges need BIDIRECTIONAL charts
+			auto in_edges(const vertex_id& vertex) const
+			{
+				return boost::make_iterator_range(boost::in_edges(vertex, _graph));
+			};
+
+			auto inv_adjacent_vertices(const vertex_id& vertex) const
+			{
+				// The boost adaptors have no 'inv_adjacent_vertices', sources of the incoming edges
+				typedef typename boost::graph_traits<_t_graph>::in_edge_iterator in_edge_iterator;
+				typedef typename boost::inv_adjacency_iterator_generator<_t_graph, vertex_id, in_edge_iterator>::type inv_adjacency_iterator;
+				in_edge_iterator it, it_end;
+				boost::tie(it, it_end) = boost::in_edges(vertex, _graph);
+				return boost::make_iterator_range(inv_adjacency_iterator(it, &_graph), inv_adjacency_iterator(it_end, &_graph));
+			};
+
+			auto neighbors(const vertex_id& vertex) const
+			{
+				return this->neighbors(vertex, typename boost::graph_traits<_t_graph>::directed_category());
+			};
+
+			void get_edges_outgoing(const vertex_id& vertex, std::vector<edge_id>& edges) const
+			{
+				out_edge_range range = this->out_edges(vertex);
+				edges.insert(edges.end(), range.begin(), range.end());
+			};
+
+			void get_edges_incoming(const vertex_id& vertex, std::vector<edge_id>& edges) const
+			{
+				auto range = this->in_edges(vertex);
+				edges.insert(edges.end(), range.begin(), range.end());
+			};
+
+			vertex_id get_source(const edge_id& edge) const { return boost::source(edge, _graph);};
+			vertex_id get_target(const edge_id& edge) const { return boost::target(edge, _graph);};
+
+			size_t connected_components(std::vector<size_t>& vertex_at_cmp, unsigned n_threads = 0) const
+			{
+				/*! Connected components of the view, see 'chart_impl::connected_components'. The
+				    predicates are called from several threads.
+				*/
+				const View& view = static_cast<const View&>(*this);
+				parallel_component_roots(_chart.num_vertices(), _chart.num_edges(), [this, &view](size_t e)
+				{
+					const edge_id id = this->get_edge_at(e);
+					const size_t source = this->get_vertex_index(boost::source(id, _graph));
+					return view.contains(id) ? std::make_pair(source, this->get_vertex_index(boost::target(id, _graph))) : std::make_pair(source, source);
+				}, vertex_at_cmp, n_threads);
+
+				// Number components in the order the vertices of the view are iterated
+				std::vector<size_t> number(vertex_at_cmp.size(), size_t(-1));
+				size_t n_components = 0;
+				typename boost::graph_traits<_t_graph>::vertex_iterator v_it, v_end;
+				for (boost::tie(v_it, v_end) = boost::vertices(_graph); v_it != v_end; ++v_it)
+				{
+					size_t& root_number = number[vertex_at_cmp[this->get_vertex_index(*v_it)]];
+					if (root_number == size_t(-1))
+					{
+						root_number = n_components++;
+					}
+				}
+				for (size_t index = 0; index < vertex_at_cmp.size(); ++index)
+				{
+					vertex_at_cmp[index] = view.contains(this->get_vertex_at(index)) ? number[vertex_at_cmp[index]] : size_t(-1);
+				}
+				return n_components;
+			};
+
+			size_t strong_components(std::vector<size_t>& vertex_at_cmp) const
+			{
+				// See 'chart_impl::strong_components', numbers stay in reverse topological order
+				const size_t n_components = detail::strong_components(this->num_vertices(), this->out_targets(), vertex_at_cmp);
+				return this->drop_outside(vertex_at_cmp, n_components);
+			};
+
+			size_t strong_components(std::vector<size_t>& vertex_at_cmp, unsigned n_threads) const
+			{
+				const size_t n_components = detail::parallel_strong_components(this->num_vertices(), this->out_targets(), vertex_at_cmp, n_threads);
+				return this->drop_outside(vertex_at_cmp, n_components);
+			};
+
+			bool topological_order(std::vector<size_t>& order) const
+			{
+				// See 'chart_impl::topological_order', only with the vertices of the view
+				const View& view = static_cast<const View&>(*this);
+				detail::topological_order(this->num_vertices(), this->out_targets(), order);
+				order.erase(std::remove_if(order.begin(), order.end(), [this, &view](size_t v) { return !view.contains(this->get_vertex_at(v));}), order.end());
+				return order.size() == this->count_vertices();
+			};
+
+			size_t parallel_breadth_first(const vertex_id& source, std::vector<size_t>& distance, std::vector<size_t>& parent, unsigned n_threads = 0) const
+			{
+				// See 'chart_behaviour<BIDIRECTIONAL>::parallel_breadth_first'
+				this->check_source(source);
+				const View& view = static_cast<const View&>(*this);
+				return parallel_direction_optimizing_bfs(this->num_vertices(), this->count_edges(), this->get_vertex_index(source),
+					[this](size_t v)
+					{
+						return boost::out_degree(this->get_vertex_at(v), _graph);
+					},
+					[this](size_t v, auto visit)
+					{
+						adjacency_iterator it, it_end;
+						for (boost::tie(it, it_end) = boost::adjacent_vertices(this->get_vertex_at(v), _graph); it != it_end; ++it)
+						{
+							visit(this->get_vertex_index(*it));
+						}
+					},
+					[this, &view](size_t v, auto visit)
+					{
+						// 'in_edges' of a filtered graph only checks the source: skip targets out of the view
+						if (!view.contains(this->get_vertex_at(v)))
+						{
+							return;
+						}
+						typename boost::graph_traits<_t_graph>::in_edge_iterator it, it_end;
+						for (boost::tie(it, it_end) = boost::in_edges(this->get_vertex_at(v), _graph); it != it_end; ++it)
+						{
+							if (visit(this->get_vertex_index(boost::source(*it, _graph))))
+							{
+								return;
+							}
+						}
+					},
+					distance, parent, n_threads);
+			};
+
+			// Edges with inner objects, see 'chart_edge_inner::dijkstra_shortest_paths'
+			template <class Distance, class WeightFunction>
+			size_t dijkstra_shortest_paths(const vertex_id& source, WeightFunction weight, std::vector<Distance>& distance, std::vector<size_t>& parent) const
+			{
+				this->check_source(source);
+				return detail::dijkstra_shortest_paths(this->num_vertices(), this->get_vertex_index(source), this->weighted_out_edges<Distance>(weight), distance, parent);
+			};
+
+			template <class Distance, class WeightFunction>
+			size_t delta_stepping_shortest_paths(const vertex_id& source, WeightFunction weight, const Distance& delta, std::vector<Distance>& distance, std::vector<size_t>& parent, unsigned n_threads = 0) const
+			{
+				this->check_source(source);
+				return detail::delta_stepping_shortest_paths(this->num_vertices(), this->get_vertex_index(source), this->weighted_out_edges<Distance>(weight), delta, distance, parent, n_threads);
+			};
+
+		protected:
+			template <class VertexType, class EdgeType, int Behaviour>
+			static const typename chart_impl<VertexType, EdgeType, Behaviour>::_t_graph& graph_of(const chart_impl<VertexType, EdgeType, Behaviour>& chart) { return chart._graph;};
+
+			void check_source(const vertex_id& source) const
+			{
+				// Out of the view a source would still reach its (filtered) neighbours
+				if (!static_cast<const View&>(*this).contains(source))
+				{
+					throw std::runtime_error("source vertex is not in the view");
+				}
+			};
+
+			auto neighbors(const vertex_id& vertex, boost::bidirectional_tag) const
+			{
+				return boost::range::join(this->adjacent_vertices(vertex), this->inv_adjacent_vertices(vertex));
+			};
+
+			adjacency_range neighbors(const vertex_id& vertex, boost::directed_tag) const { return this->adjacent_vertices(vertex);};
+			adjacency_range neighbors(const vertex_id& vertex, boost::undirected_tag) const { return this->adjacent_vertices(vertex);};
+
+			auto out_targets() const
+			{
+				// 'f(target)' for the outgoing edges of a dense vertex index, none out of the view
+				return [this](size_t v, auto f)
+				{
+					const vertex_id vertex = this->get_vertex_at(v);
+					if (!static_cast<const View&>(*this).contains(vertex))
+					{
+						return;
+					}
+					adjacency_iterator it, it_end;
+					for (boost::tie(it, it_end) = boost::adjacent_vertices(vertex, _graph); it != it_end; ++it)
+					{
+						f(this->get_vertex_index(*it));
+					}
+				};
+			};
+
+			size_t drop_outside(std::vector<size_t>& vertex_at_cmp, size_t n_components) const
+			{
+				// Vertices out of the view are components by themselves: remove them, keeping the order of the others
+				const View& view = static_cast<const View&>(*this);
+				std::vector<size_t> number(n_components, 0);
+				for (size_t index = 0; index < vertex_at_cmp.size(); ++index)
+				{
+					if (view.contains(this->get_vertex_at(index)))
+					{
+						number[vertex_at_cmp[index]] = 1;
+					}
+				}
+				size_t n_kept = 0;
+				for (size_t c = 0; c < n_components; ++c)
+				{
+					number[c] = number[c] ? n_kept++ : size_t(-1);
+				}
+				for (size_t index = 0; index < vertex_at_cmp.size(); ++index)
+				{
+					vertex_at_cmp[index] = number[vertex_at_cmp[index]];
+				}
+				return n_kept;
+			};
+
+			template <class Distance, class WeightFunction>
+			auto weighted_out_edges(WeightFunction weight) const
+			{
+				// 'f(target, weight)' for the outgoing edges of a dense vertex index
+				return [this, weight](size_t v, auto f)
+				{
+					out_edge_iterator it, it_end;
+					for (boost::tie(it, it_end) = boost::out_edges(this->get_vertex_at(v), _graph); it != it_end; ++it)
+					{
+						f(this->get_vertex_index(boost::target(*it, _graph)), static_cast<Distance>(weight(_graph[*it]->get_obj())));
+					}
+				};
+			};
+
+		protected:
+			const Chart& _chart;
+			_t_graph _graph;
+	};
+
+}
+
+
+/*! Subgraph of a chart made of the vertices and edges satisfying the given predicates,
+    called with their ids ('vertex_id' and 'edge_id' of the chart). Edges are only kept if
+    both ends are. Nothing is copied: every query filters the chart on the fly, so the
+    predicates should be cheap, and they must be safe to call from several threads for the
+    multi-threaded algorithms.
+
+    It is a view: the chart must outlive it and any modification of the chart is seen (ranges
+    being invalidated as for the chart). Copies share the predicates. The query API is that
+    of 'chart', see 'detail::chart_view'; it can also be walked by 'search' and by the boost
+    algorithms through 'get_graph'.
+*/
+template <class Chart, class VertexPredicate, class EdgePredicate = boost::keep_all>
+class filtered_chart : public detail::chart_view<filtered_chart<Chart, VertexPredicate, EdgePredicate>, Chart,
+                                                 boost::filtered_graph<typename detail::chart_graph<Chart>::type, detail::view_predicate<EdgePredicate>, detail::view_predicate<VertexPredicate> > >
+{
+	typedef detail::chart_view<filtered_chart, Chart,
+	                           boost::filtered_graph<typename detail::chart_graph<Chart>::type, detail::view_predicate<EdgePredicate>, detail::view_predicate<VertexPredicate> > > _t_base;
+
+	public:
+		typedef typename _t_base::_t_graph _t_graph;
+		typedef typename _t_base::vertex_id vertex_id;
+		typedef typename _t_base::edge_id edge_id;
+
+	public:
+		filtered_chart(const Chart& chart, VertexPredicate vertex_predicate, EdgePredicate edge_predicate = EdgePredicate())
+			: filtered_chart(chart, std::make_shared<const predicates>(vertex_predicate, edge_predicate)) {};
+
+		bool contains(const vertex_id& v) const { return _predicates->vertex(v);};
+
+		bool contains(const edge_id& e) const
+		{
+			return _predicates->edge(e) && this->contains(boost::source(e, this->_graph)) && this->contains(boost::target(e, this->_graph));
+		};
+
+	protected:
+		struct predicates
+		{
+			predicates(VertexPredicate v, EdgePredicate e) : vertex(v), edge(e) {};
+			VertexPredicate vertex;
+			EdgePredicate edge;
+		};
+
+		filtered_chart(const Chart& chart, const std::shared_ptr<const predicates>& p)
+			: _t_base(chart, _t_graph(_t_base::graph_of(chart), detail::view_predicate<EdgePredicate>(&p->edge), detail::view_predicate<VertexPredicate>(&p->vertex))), _predicates(p) {};
+
+	protected:
+		std::shared_ptr<const predicates> _predicates; // the filtered graph points to them
+};
+
+
+/*! A BIDIRECTIONAL chart with all its edges reversed: outgoing edges are the incoming ones
+    of the chart, sources are targets and so on. As 'filtered_chart' it is a view, but its
+    'edge_id' wraps the one of the chart: 'edge_id(e)' builds it, 'get_chart_edge_id' goes
+    back.
+*/
+template <class Chart>
+class reversed_chart : public detail::chart_view<reversed_chart<Chart>, Chart, boost::reverse_graph<typename detail::chart_graph<Chart>::type> >
+{
+	static_assert(std::is_same<typename Chart::behaviour, boost::bidirectionalS>::value, "only BIDIRECTIONAL charts can be reversed");
+	typedef detail::chart_view<reversed_chart, Chart, boost::reverse_graph<typename detail::chart_graph<Chart>::type> > _t_base;
+
+	public:
+		typedef typename _t_base::_t_graph _t_graph;
+		typedef typename _t_base::vertex_id vertex_id;
+		typedef typename _t_base::edge_id edge_id;
+
+	public:
+		explicit reversed_chart(const Chart& chart) : _t_base(chart, _t_graph(_t_base::graph_of(chart))) {};
+
+		bool contains(const vertex_id&) const { return true;};
+		bool contains(const edge_id&) const { return true;};
+};
+
+}}
@@ -0,0 +1,325 @@
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <boost/graph/graph_traits.hpp>
+
+namespace core { namespace graph { namespace detail {
+
+/*! Incremental connected components of a chart (see 'chart_impl::enable_component_tracking').
+
+    Additions are applied to a union-find as they happen, so queries cost O(α(n)).
+    A union-find cannot split sets: removals only mark the component they touch as dirty
+    and remember the vertices that were at the ends of the removed edges. Before the
+    next query or addition the dirty components are rebuilt by traversing the graph from
+    those vertices, which only visits the vertices of the affected components. Every
+    piece of a component that got split contains at least one of them.
+
+    '_graph' does not store incoming edges for DIRECTED charts: the traversal takes them
+    from the vertex instead ('get_incoming'), keeping those indexed by the chart.
+
+    Direction is ignored: for BIDIRECTIONAL and DIRECTED charts these are the weakly
+    connected components.
+
+    The union-find works on its own slots instead of the dense vertex indices of the chart,
+    which move when a vertex is removed. Slots of removed vertices are not reused until
+    the dirty components have been rebuilt, as other slots may still point to them.
+*/
+template <class Chart>
+class component_tracker
+{
+	public:
+		typedef typename Chart::vertex_id vertex_id;
+		typedef typename Chart::_t_graph _t_graph;
+
+	public:
+		explicit component_tracker(const Chart& chart) : _chart(chart), _n_components(0), _epoch(0)
+		{
+			this->rebuild();
+		};
+
+		// Notifications from the chart
+		void on_vertex_added(const vertex_id& v)
+		{
+			// The chart has already given the next dense index to 'v' (and called 'update' before)
+			std::size_t slot;
+			if (_free.empty())
+			{
+				slot = _parent.size();
+				_parent.push_back(slot);
+				_size.push_back(1);
+				_vertex_of_slot.push_back(v);
+				_alive.push_back(1);
+				_dirty.push_back(0);
+				_visited.push_back(0);
+			}
+			else
+			{
+				slot = _free.back();
+				_free.pop_back();
+				_parent[slot] = slot;
+				_size[slot] = 1;
+				_vertex_of_slot[slot] = v;
+				_alive[slot] = 1;
+			}
+			_slot_of.push_back(slot);
+			++_n_components;
+		};
+
+		void on_edge_added(const vertex_id& source, const vertex_id& target)
+		{
+			// The chart must call 'update' before adding the edge to the graph
+			if (this->unite(this->slot(source), this->slot(target)))
+			{
+				--_n_components;
+			}
+		};
+
+		void on_edge_removed(const vertex_id& source, const vertex_id& target)
+		{
+			const std::size_t source_slot = this->slot(source);
+			this->mark_dirty(source_slot);
+			_pending.push_back(source_slot);
+			_pending.push_back(this->slot(target));
+		};
+
+		void on_vertex_removed(const vertex_id& v)
+		{
+			/* Called once the vertex is isolated and before the chart moves the last
+			   vertex to its dense index.
+			*/
+			const std::size_t index = _chart.get_vertex_index(v);
+			const std::size_t slot = _slot_of[index];
+			this->mark_dirty(slot);
+			_alive[slot] = 0;
+			_released.push_back(slot);
+			_slot_of[index] = _slot_of.back();
+			_slot_of.pop_back();
+		};
+
+		void on_clear()
+		{
+			this->rebuild();
+		};
+
+		// Queries
+		bool same_component(const vertex_id& u, const vertex_id& v)
+		{
+			this->update();
+			return this->find(this->slot(u)) == this->find(this->slot(v));
+		};
+
+		std::size_t component_of(const vertex_id& v)
+		{
+			/*! Label of the component of 'v': two vertices have the same label iff they are
+			    connected. Labels are not contiguous and are only stable until the chart is
+			    modified.
+			*/
+			this->update();
+			return this->find(this->slot(v));
+		};
+
+		std::size_t num_components()
+		{
+			this->update();
+			return _n_components;
+		};
+
+		void update()
+		{
+			/*! Applies the pending removals. Dirty components are traversed in the current
+			    graph, so the chart calls it before adding anything to the graph.
+			*/
+			if (!_dirty_roots.empty())
+			{
+				this->update(typename boost::graph_traits<_t_graph>::directed_category());
+			}
+			_free.insert(_free.end(), _released.begin(), _released.end());
+			_released.clear();
+		};
+
+	protected:
+		std::size_t slot(const vertex_id& v) const { return _slot_of[_chart.get_vertex_index(v)];};
+
+		std::size_t find(std::size_t x)
+		{
+			while (_parent[x] != x)
+			{
+				_parent[x] = _parent[_parent[x]]; // path halving
+				x = _parent[x];
+			}
+			return x;
+		};
+
+		bool unite(std::size_t a, std::size_t b)
+		{
+			a = this->find(a);
+			b = this->find(b);
+			if (a == b)
+			{
+				return false;
+			}
+			if (_size[a] < _size[b])
+			{
+				std::swap(a, b);
+			}
+			_parent[b] = a;
+			_size[a] += _size[b];
+			return true;
+		};
+
+		void mark_dirty(std::size_t slot)
+		{
+			const std::size_t root = this->find(slot);
+			if (!_dirty[root])
+			{
+				_dirty[root] = 1;
+				_dirty_roots.push_back(root);
+			}
+		};
+
+		void update(boost::undirected_tag)
+		{
+			_n_components -= _dirty_roots.size();
+			for (std::vector<std::size_t>::const_iterator it = _dirty_roots.begin(); it != _dirty_roots.end(); ++it)
+			{
+				_dirty[*it] = 0;
+			}
+			_dirty_roots.clear();
+
+			++_epoch;
+			for (std::vector<std::size_t>::const_iterator it = _pending.begin(); it != _pending.end(); ++it)
+			{
+				if (_alive[*it] && _visited[*it] != _epoch)
+				{
+					this->relabel(*it);
+					++_n_components;
+				}
+			}
+			_pending.clear();
+		};
+
+		void update(boost::directed_tag)
+		{
+			this->update(boost::undirected_tag());
+		};
+
+		void relabel(std::size_t root)
+		{
+			// Breadth-first traversal of the piece containing 'root', which becomes its representative
+			_visited[root] = _epoch;
+			_parent[root] = root;
+			_queue.assign(1, root);
+			for (std::size_t head = 0; head < _queue.size(); ++head)
+			{
+				const vertex_id v = _vertex_of_slot[_queue[head]];
+				this->visit_adjacent(v, root, typename boost::graph_traits<_t_graph>::directed_category());
+			}
+			_size[root] = _queue.size();
+		};
+
+		void visit(const vertex_id& v, std::size_t root)
+		{
+			const std::size_t slot = this->slot(v);
+			if (_visited[slot] != _epoch)
+			{
+				_visited[slot] = _epoch;
+				_parent[slot] = root;
+				_queue.push_back(slot);
+			}
+		};
+
+		void visit_adjacent(const vertex_id& v, std::size_t root, boost::undirected_tag)
+		{
+			const _t_graph& graph = _chart._graph;
+			typename boost::graph_traits<_t_graph>::out_edge_iterator it, it_end;
+			for (boost::tie(it, it_end) = boost::out_edges(v, graph); it != it_end; ++it)
+			{
+				this->visit(boost::target(*it, graph), root);
+			}
+		};
+
+		void visit_adjacent(const vertex_id& v, std::size_t root, boost::bidirectional_tag)
+		{
+			this->visit_adjacent(v, root, boost::undirected_tag());
+			const _t_graph& graph = _chart._graph;
+			typename boost::graph_traits<_t_graph>::in_edge_iterator it, it_end;
+			for (boost::tie(it, it_end) = boost::in_edges(v, graph); it != it_end; ++it)
+			{
+				this->visit(boost::source(*it, graph), root);
+			}
+		};
+
+		void visit_adjacent(const vertex_id& v, std::size_t root, boost::directed_tag)
+		{
+			// Incoming edges of the vertex may belong to other charts: keep the ones indexed here
+			this->visit_adjacent(v, root, boost::undirected_tag());
+			const _t_graph& graph = _chart._graph;
+			typedef typename Chart::vertex_type::_t_edges _t_incoming;
+			const _t_incoming& incoming = graph[v]->get_incoming();
+			for (typename _t_incoming::const_iterator it = incoming.begin(); it != incoming.end(); ++it)
+			{
+				typename Chart::_t_edges::const_iterator e_it = _chart._edges.find(typename Chart::edge_type_ptr(typename Chart::edge_type_ptr(), *it)); // non-owning key
+				if (e_it != _chart._edges.end())
+				{
+					this->visit(boost::source(e_it->second, graph), root);
+				}
+			}
+		};
+
+		void rebuild()
+		{
+			// Union-find of the whole chart from scratch: slot == dense vertex index
+			const std::size_t n = _chart.num_vertices();
+			_slot_of.resize(n);
+			_parent.resize(n);
+			_size.assign(n, 1);
+			_vertex_of_slot.resize(n);
+			_alive.assign(n, 1);
+			_dirty.assign(n, 0);
+			_visited.assign(n, 0);
+			for (std::size_t index = 0; index < n; ++index)
+			{
+				_slot_of[index] = index;
+				_parent[index] = index;
+				_vertex_of_slot[index] = _chart.get_vertex_at(index);
+			}
+			_free.clear();
+			_released.clear();
+			_dirty_roots.clear();
+			_pending.clear();
+			_epoch = 0;
+
+			_n_components = n;
+			const _t_graph& graph = _chart._graph;
+			typename boost::graph_traits<_t_graph>::edge_iterator it, it_end;
+			for (boost::tie(it, it_end) = boost::edges(graph); it != it_end; ++it)
+			{
+				if (this->unite(this->slot(boost::source(*it, graph)), this->slot(boost::target(*it, graph))))
+				{
+					--_n_components;
+				}
+			}
+		};
+
+	protected:
+		const Chart& _chart;
+		std::size_t _n_components;
+
+		// Union-find over slots
+		std::vector<std::size_t> _slot_of; // slot for each dense vertex index
+		std::vector<std::size_t> _parent, _size;
+		std::vector<vertex_id> _vertex_of_slot;
+		std::vector<char> _alive;
+		std::vector<std::size_t> _free, _released;
+
+		// Lazy removals
+		std::vector<char> _dirty;
+		std::vector<std::size_t> _dirty_roots, _pending;
+		std::vector<std::size_t> _visited, _queue;
+		std::size_t _epoch;
+};
+
+}}}
@@ -0,0 +1,132 @@
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+namespace core { namespace graph { namespace detail {
+
+/*! Lock-free union-find over dense indices [0, n).
+
+    Roots are always linked under the smaller one and path halving only moves a parent
+    pointer to an ancestor, so parent[x] <= x holds at any time: there can be no cycles,
+    and once all the unions are done the root of every set is its minimum index,
+    whatever the interleaving of the threads was.
+*/
+class concurrent_union_find
+{
+	public:
+		explicit concurrent_union_find(std::size_t n) : _parent(n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				_parent[i].store(i, std::memory_order_relaxed);
+			}
+		};
+
+		std::size_t size() const { return _parent.size();};
+
+		std::size_t find(std::size_t x)
+		{
+			while (true)
+			{
+				std::size_t parent = _parent[x].load(std::memory_order_acquire);
+				if (parent == x)
+				{
+					return x;
+				}
+				std::size_t grandparent = _parent[parent].load(std::memory_order_acquire);
+				if (grandparent != parent)
+				{
+					_parent[x].compare_exchange_weak(parent, grandparent, std::memory_order_acq_rel); // path halving, may fail
+				}
+				x = grandparent;
+			}
+		};
+
+		void unite(std::size_t a, std::size_t b)
+		{
+			while (true)
+			{
+				a = this->find(a);
+				b = this->find(b);
+				if (a == b)
+				{
+					return;
+				}
+				if (a < b)
+				{
+					std::swap(a, b);
+				}
+				std::size_t expected = a;
+				if (_parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+				{
+					return;
+				}
+			}
+		};
+
+		bool same(std::size_t a, std::size_t b)
+		{
+			// Only meaningful when there are no concurrent unions
+			return this->find(a) == this->find(b);
+		};
+
+	protected:
+		std::vector<std::atomic<std::size_t> > _parent;
+};
+
+
+/*! Fills 'root' with the representative of the connected component of every vertex
+    in [0, n_vertices): the minimum vertex index in the component. 'endpoints(e)' returns
+    the pair of vertex indices of the edge 'e' in [0, n_edges), edges are considered
+    undirected (for directed graphs these are the weakly connected components).
+*/
+template <class Endpoints>
+void parallel_component_roots(std::size_t n_vertices, std::size_t n_edges, Endpoints endpoints, std::vector<std::size_t>& root, unsigned n_threads = 0)
+{
+	concurrent_union_find sets(n_vertices);
+	parallel_for(n_edges, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t e = begin; e < end; ++e)
+		{
+			std::pair<std::size_t, std::size_t> vertices = endpoints(e);
+			sets.unite(vertices.first, vertices.second);
+		}
+	});
+
+	root.resize(n_vertices);
+	parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t v = begin; v < end; ++v)
+		{
+			root[v] = sets.find(v);
+		}
+	});
+}
+
+/*! Multi-threaded connected components ('n_threads' = 0 uses all the cores).
+
+    Components are numbered in order of their first vertex, which is exactly what the
+    serial boost::connected_components returns when vertices are visited in index order,
+    so results are deterministic and do not depend on the number of threads.
+*/
+template <class Endpoints>
+std::size_t parallel_connected_components(std::size_t n_vertices, std::size_t n_edges, Endpoints endpoints, std::vector<std::size_t>& component, unsigned n_threads = 0)
+{
+	parallel_component_roots(n_vertices, n_edges, endpoints, component, n_threads);
+
+	// Roots are the minimum vertex of their component: number them in order (roots come first)
+	std::size_t n_components = 0;
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		component[v] = (component[v] == v) ? n_components++ : component[component[v]];
+	}
+	return n_components;
+}
+
+}}}
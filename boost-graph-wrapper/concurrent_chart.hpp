@@ -0,0 +1,223 @@
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+#include "frozen_chart.hpp"
+
+namespace core { namespace graph {
+
+/*! Read-only view of a version of a chart, as published by 'concurrent_chart'.
+
+    Readers only get what the writer never modifies: the dense ids and the CSR adjacency of
+    the version (a 'frozen_chart' of it) and the inner objects of its elements, through
+    'get_vertex_obj'/'get_edge_obj'. The vertex and edge objects themselves stay out of
+    reach, because they are shared with the live chart and the writer keeps changing them
+    (edge sets, chart back-references, visitation labels). Inner objects are not copied:
+    mutations must replace elements rather than modify the inner objects of existing ones.
+*/
+template <class Chart>
+class chart_snapshot : protected frozen_chart<Chart>
+{
+		template <class C> friend class concurrent_chart;
+		typedef frozen_chart<Chart> _t_base;
+	public:
+		using typename _t_base::vertex_id;
+		using typename _t_base::edge_id;
+		using typename _t_base::vertex_type;
+		using typename _t_base::edge_type;
+		using typename _t_base::_t_offsets;
+		using typename _t_base::_t_adjacency;
+
+		using _t_base::num_vertices;
+		using _t_base::num_edges;
+		using _t_base::get_edges_outgoing;
+		using _t_base::get_edges_incoming;
+		using _t_base::get_source;
+		using _t_base::get_target;
+		using _t_base::get_connected;
+		using _t_base::connected_components;
+		using _t_base::get_out_offsets;
+		using _t_base::get_out_edges;
+		using _t_base::get_in_offsets;
+		using _t_base::get_in_edges;
+
+	public:
+		// Inner object of an element ('Vertex'/'Edge' only delay the lookup of 'inner_type' to the call)
+		template <class Vertex = vertex_type>
+		const typename Vertex::inner_type& get_vertex_obj(const vertex_id& vertex) const { return this->_vertices[vertex]->get_obj();};
+
+		template <class Edge = edge_type>
+		const typename Edge::inner_type& get_edge_obj(const edge_id& edge) const { return this->_edges[edge]->get_obj();};
+
+	protected:
+		explicit chart_snapshot(const Chart& chart) : _t_base(chart) {};
+};
+
+
+/*! Chart shared between many reader threads and writer threads (versioned snapshots).
+
+    The chart itself is only touched by the writers, one mutation at a time. Published
+    versions are immutable 'chart_snapshot's, and readers take the latest one with
+    'snapshot': an atomic load that never waits for the writers. A reader keeps working on
+    the same consistent version for as long as it holds the pointer, whatever the writers
+    do meanwhile; there is no torn state because a snapshot gives no access to anything the
+    writers modify (see 'chart_snapshot').
+
+    Publishing a version costs O(V + E), so it is amortized over many mutations:
+      - 'apply' changes the chart without publishing, 'publish' makes all the mutations
+        applied so far visible at once (nothing is rebuilt if there are none);
+      - 'update' is 'apply' then 'publish', and concurrent updates share publications: an
+        update whose mutation is already included in a newer version returns without
+        rebuilding, so N writers hammering the chart cost far fewer than N rebuilds.
+    'version()' is the number of mutations included in the latest published version.
+
+    Reclamation: vertices and edges removed from the chart may still be referenced by older
+    snapshots, and destroying an edge modifies its vertices (see 'edge_connected::disconnect').
+    So readers never destroy anything, the snapshots they release are queued and freed by
+    the writers while they hold the chart. Snapshots should be released before the
+    concurrent_chart is destroyed.
+*/
+template <class Chart>
+class concurrent_chart
+{
+	public:
+		typedef Chart chart_type;
+		typedef chart_snapshot<Chart> snapshot_type;
+		typedef std::shared_ptr<const snapshot_type> snapshot_ptr;
+
+	public:
+		concurrent_chart() : _retired(std::make_shared<retired_list>()), _applied(0), _version(0)
+		{
+			this->publish_version();
+		};
+
+		concurrent_chart(const concurrent_chart&) = delete;
+		concurrent_chart& operator=(const concurrent_chart&) = delete;
+
+		~concurrent_chart()
+		{
+			std::atomic_store(&_snapshot, snapshot_ptr());
+			_retired->reclaim();
+		};
+
+		// Readers (any thread, never blocks)
+		snapshot_ptr snapshot() const { return std::atomic_load(&_snapshot);};
+		std::size_t version() const { return _version.load(std::memory_order_acquire);};
+
+		// Writers
+		template <class Mutation>
+		std::size_t apply(Mutation mutation)
+		{
+			/*! Calls 'mutation(chart)' without publishing it, returns its number (see 'version').
+			    Concurrent calls are serialized. If 'mutation' throws the chart may have changed
+			    anyway: it is counted all the same.
+			*/
+			std::lock_guard<std::mutex> lock(_writer);
+			_retired->reclaim();
+			++_applied;
+			mutation(_chart);
+			return _applied;
+		};
+
+		void publish()
+		{
+			// Makes every mutation applied so far visible to the readers
+			std::lock_guard<std::mutex> lock(_publisher);
+			this->publish_version();
+		};
+
+		template <class Mutation>
+		void update(Mutation mutation)
+		{
+			/*! 'apply' then publish, the result is published even if 'mutation' throws. Returns
+			    as soon as a version including the mutation is published, by this call or by a
+			    concurrent one.
+			*/
+			std::size_t applied = 0;
+			try
+			{
+				applied = this->apply(mutation);
+			}
+			catch (...)
+			{
+				this->publish();
+				throw;
+			}
+			std::lock_guard<std::mutex> lock(_publisher);
+			if (_version.load(std::memory_order_acquire) < applied)
+			{
+				this->publish_version();
+			}
+		};
+
+	protected:
+		class retired_list
+		{
+			// Lock-free stack of released snapshots, readers push and the writer takes them all
+			public:
+				retired_list() : _head(0) {};
+				~retired_list() { this->reclaim();};
+
+				void push(const snapshot_type* snapshot)
+				{
+					node* n = new node(snapshot, _head.load(std::memory_order_relaxed));
+					while (!_head.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed)) {}
+				};
+
+				void reclaim()
+				{
+					for (node* n = _head.exchange(0, std::memory_order_acquire); n != 0;)
+					{
+						node* next = n->next;
+						delete n->snapshot;
+						delete n;
+						n = next;
+					}
+				};
+
+			protected:
+				struct node
+				{
+					node(const snapshot_type* s, node* n) : snapshot(s), next(n) {};
+					const snapshot_type* snapshot;
+					node* next;
+				};
+				std::atomic<node*> _head;
+		};
+
+		void publish_version()
+		{
+			// With '_publisher' held: snapshot of the chart, unless nothing changed since the last one
+			std::shared_ptr<retired_list> retired = _retired;
+			std::unique_ptr<const snapshot_type> snapshot;
+			std::size_t applied = 0;
+			{
+				std::lock_guard<std::mutex> lock(_writer);
+				_retired->reclaim();
+				applied = _applied;
+				if (_snapshot && applied == _version.load(std::memory_order_relaxed))
+				{
+					return;
+				}
+				snapshot.reset(new snapshot_type(_chart));
+			}
+			std::atomic_store(&_snapshot, snapshot_ptr(snapshot.release(), [retired](const snapshot_type* s) { retired->push(s);}));
+			_version.store(applied, std::memory_order_release);
+		};
+
+	protected:
+		Chart _chart;
+		std::mutex _writer; // the chart and '_applied'
+		std::mutex _publisher; // '_snapshot' and '_version', taken before '_writer'
+		std::shared_ptr<retired_list> _retired; // shared with the deleters of the snapshots
+		snapshot_ptr _snapshot;
+		std::size_t _applied; // mutations applied to the chart
+		std::atomic<std::size_t> _version; // mutations included in '_snapshot'
+};
+
+}}
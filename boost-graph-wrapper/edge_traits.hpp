@@ -2,12 +2,12 @@
 #pragma once
 
 #include <memory>
-#include <functional>
+#include <cstddef>
 #include <assert.h>
 
 #include "core/graph/boost-graph-wrapper_export.h"
 
-#include "traits.h"
+#include "traits.hpp"
 
 namespace core { namespace graph { namespace detail {
 
@@ -19,11 +19,14 @@ namespace _impl
 	template <class VertexType, class EdgeType> 
 	class edge_connected
 	{
+		/*! 'EdgeType' is the concrete edge class, derived (non virtually) from this one: the
+		    edge registered in its vertices is reached with a static_cast, no RTTI involved.
+		*/
 		protected:
 			edge_connected() : _source(0), _target(0) {};
 
 		public:
-			virtual ~edge_connected()
+			~edge_connected()
 			{
 				this->disconnect();
 			}
@@ -33,28 +36,49 @@ namespace _impl
 				return (_source || _target);
 			}
 
-			virtual void connect(VertexType* source, VertexType* target)
+			void connect(VertexType* source, VertexType* target)
 			{
 				if (is_connected())
 				{
 					throw std::runtime_error("Disconnect before connecting to other vertices.");
 				}
-				_source = source; source->append_outgoing(dynamic_cast<EdgeType*>(this));
-				_target = target; target->append_incoming(dynamic_cast<EdgeType*>(this));
+				_source = source; source->append_outgoing(this->self());
+				_target = target; target->append_incoming(this->self());
 			}
 
-			virtual void disconnect()
+			/*! Both halves of 'connect', for parallel loading (see 'chart_impl::parallel_add_edges'):
+			    they can run at the same time in different threads, as long as no other thread
+			    is modifying the same vertex.
+			*/
+			void connect_source(VertexType* source)
+			{
+				_source = source; source->append_outgoing(this->self());
+			}
+
+			void connect_target(VertexType* target)
+			{
+				_target = target; target->append_incoming(this->self());
+			}
+
+			void disconnect()
 			{
 				if (is_connected())
 				{
 					assert(_target!=0 && _source!=0);
-					_source->erase_outgoing(dynamic_cast<EdgeType*>(this));
+					_source->erase_outgoing(this->self());
 					_source = 0;
-					_target->erase_incoming(dynamic_cast<EdgeType*>(this));
+					_target->erase_incoming(this->self());
 					_target = 0;
 				}
 			}
 
+		protected:
+			EdgeType* self()
+			{
+				// Non-virtual base: a compile-time offset, also valid from the destructor ('disconnect').
+				return static_cast<EdgeType*>(this);
+			};
+
 		protected:
 			VertexType* _source;
 			VertexType* _target;
@@ -71,7 +95,7 @@ class edge_connected<VertexType, EdgeType, UNDIRECTED> : public _impl::edge_conn
 	public:
 		std::pair<VertexType*, VertexType*> get_connected() const
 		{
-			return std::make_pair(_target, _source); /* Intentionally return them in "wrong" order,
+			return std::make_pair(this->_target, this->_source); /* Intentionally return them in "wrong" order,
 			                                            cause for UNDIRECTED connections there is no
 			                                            source nor target.
 			                                         */
@@ -85,7 +109,7 @@ template <class VertexType, class EdgeType>
 class edge_connected<VertexType, EdgeType, DIRECTED> : public _impl::edge_connected<VertexType, EdgeType> {
 	public:
 		// On directed graph client code will only be able to traverse forwards.
-		VertexType* get_target() const { return _target;};
+		VertexType* get_target() const { return this->_target;};
 	protected:
 		static const int IsEdgeConnectedDirected;
 	};
@@ -94,8 +118,8 @@ template <class VertexType, class EdgeType>
 class edge_connected<VertexType, EdgeType, BIDIRECTIONAL> : public _impl::edge_connected<VertexType, EdgeType>
 {
 	public:
-		VertexType* get_source() const { return _source;};
-		VertexType* get_target() const { return _target;};
+		VertexType* get_source() const { return this->_source;};
+		VertexType* get_target() const { return this->_target;};
 
 	protected:
 		static const int IsEdgeConnectedBidirectional;
@@ -169,57 +193,62 @@ template <typename T> struct is_edge_inner
 /*************
 *   CHART Belonging
 *************/
-class chart_base;
-
 template <class Chart, class EdgeType>
 class edge_chart
 {
 	//typedef typename Chart::vertex_type_ptr vertex_type_ptr;
 	//typedef typename Chart::edge_id edge_id;
-		template <class VertexType, class EdgeType, int Behaviour> friend class chart_impl;
+		template <class V, class E, int B> friend class chart_impl;
 
 	public:
 		Chart* get_chart() const { return _chart;};
 
 	protected:
-		edge_chart() : _chart(0) {};
+		edge_chart() : _chart(0), _chart_index(0) {};
 
-		virtual void disconnect()
+		void disconnect()
 		{
 			if (_chart)
 			{
-				//_chart->remove_edge(static_cast<EdgeType*>(this));
-				_on_disconnect();
-				//_chart->remove_edge(_e_id);
+				_chart->remove_edge(_chart->get_edge_at(_chart_index));
 			}
 		};
 
-		void set_chart(chart_base* chart, std::function<void ()> on_disconnect)
+		template <class ChartType>
+		void set_chart(ChartType* chart, std::size_t index)
 		{
-			_chart = dynamic_cast<Chart*>(chart);
-			_on_disconnect = on_disconnect;
+			// 'chart' is the most derived 'core::graph::chart', 'Chart' is either the same or derived from it
+			_chart = static_cast<Chart*>(chart);
+			_chart_index = index;
 		};
 
-		void remove_chart(chart_base* chart)
+		template <class ChartType>
+		void remove_chart(ChartType*)
 		{
-			/*assert(_chart == dynamic_cast<Chart*>(chart)); /*! \todo TODO: 'dynamic_cast<Chart*>(chart)' 
-			                                                           is evaluated to 0! when called from
-			                                                           'chart' destructor...
-			                                                 */
 			_chart = (Chart*)0;
 		};
 
 	protected:
+		/* 'Chart::edge_id' cannot be stored here ('Chart' is still incomplete when the edge
+		   class is defined), so the edge keeps its dense index in the chart instead. The
+		   chart updates it when the index changes (see 'chart_impl::remove_edge').
+		*/
 		Chart* _chart;
-		std::function<void ()> _on_disconnect;
+		std::size_t _chart_index;
 		static int IsChart;
 };
 
 template <class EdgeType>
 class edge_chart<void, EdgeType>
 {
+	// Edges that do not know their chart: 'disconnect' only releases the vertices
+		template <class VertexType, class EdgeType_, int Behaviour> friend class chart_impl;
 	public:
-		virtual void disconnect() {};
+		void disconnect() {};
+
+	protected:
+		template <class ChartType> void set_chart(ChartType*, std::size_t) {};
+		template <class ChartType> void remove_chart(ChartType*) {};
 };
 
 // SFINAE test for edge_chart
@@ -256,6 +285,12 @@ class edge_visitable
 		_e_visitor_labels _label;
 };
 
+template <bool Enabled>
+class optional_edge_visitable : public edge_visitable {};
+
+template <>
+class optional_edge_visitable<false> {};
+
 
 
 /*************
@@ -268,7 +303,7 @@ class edge : public detail::edge_connected<VertexType, EdgeType, Behaviour>,
              public detail::edge_visitable
 {
 	public:
-		edge(inner_type_ptr obj) : detail::edge_inner<Inner>(obj) {};
+		edge(typename detail::edge_inner<Inner>::inner_type_ptr obj) : detail::edge_inner<Inner>(obj) {};
 
 		virtual ~edge() {};
 
@@ -299,5 +334,49 @@ class edge<VertexType, EdgeType, Behaviour, Graph, void> :  public edge_connecte
 
 };
 
+
+/*************
+*   COMPACT EDGE
+*************/
+/*! Policy-based alternative to 'edge' for big charts (see 'compact_vertex'), with no vtable
+    and nothing but source and target unless more features are selected:
+      - Graph: chart type, the edge keeps a pointer to its chart so 'disconnect' removes it
+        from there too. With 'void' edges must be removed through the chart.
+      - Inner: inner object (shared_ptr), 'void' for none.
+      - Visitable: in-object visitation label (see 'edge_visitable').
+*/
+template <class VertexType, class EdgeType, int Behaviour, class Graph=void, class Inner=void, bool Visitable=false>
+class CORE_GRAPH_EMPTY_BASES compact_edge : public detail::edge_connected<VertexType, EdgeType, Behaviour>,
+                                            public detail::edge_chart<Graph, EdgeType>,
+                                            public detail::edge_inner<Inner>,
+                                            public detail::optional_edge_visitable<Visitable>
+{
+	public:
+		compact_edge(typename detail::edge_inner<Inner>::inner_type_ptr obj) : detail::edge_inner<Inner>(obj) {};
+
+		void disconnect()
+		{
+			detail::edge_connected<VertexType, EdgeType, Behaviour>::disconnect();
+			detail::edge_chart<Graph, EdgeType>::disconnect();
+		};
+};
+
+// Specialization not requesting 'inner' instance on constructor
+template <class VertexType, class EdgeType, int Behaviour, class Graph, bool Visitable>
+class CORE_GRAPH_EMPTY_BASES compact_edge<VertexType, EdgeType, Behaviour, Graph, void, Visitable> : public detail::edge_connected<VertexType, EdgeType, Behaviour>,
+                                                                                                     public detail::edge_chart<Graph, EdgeType>,
+                                                                                                     public detail::edge_inner<void>,
+                                                                                                     public detail::optional_edge_visitable<Visitable>
+{
+	public:
+		compact_edge() {};
+
+		void disconnect()
+		{
+			detail::edge_connected<VertexType, EdgeType, Behaviour>::disconnect();
+			detail::edge_chart<Graph, EdgeType>::disconnect();
+		};
+};
+
 } } }
 
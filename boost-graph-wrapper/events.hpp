@@ -2,27 +2,44 @@
 #pragma once
 
 #include <typeinfo>
-#include "vertex_traits.h"
+#include <vector>
+#include "vertex_traits.hpp"
 
 namespace core { namespace graph { namespace detail {
 
 struct events {
+	/* Hooks called synchronously by every mutation of a chart, they only forward to the
+	   chart observer when events are enabled (see 'chart_impl::enable_events').
+	*/
 
 	/***********
 	*   VERTICES
 	***********/
 	// events::on_vertex_added_to_chart
 	template <class Chart>
-	static void on_vertex_added_to_chart(const std::pair<typename Chart::vertex_type_ptr, typename Chart::vertex_id>&, Chart& chart)
+	static void on_vertex_added_to_chart(const std::pair<typename Chart::vertex_type_ptr, typename Chart::vertex_id>& item, Chart& chart)
 	{
 		// Called whenever a vertex is added to a chart
+		if (chart.get_observer()) chart.get_observer()->push(Chart::event_type::VERTEX_ADDED, item.first, typename Chart::edge_type_ptr());
+	};
+
+	// events::on_vertices_added_to_chart
+	template <class Chart>
+	static void on_vertices_added_to_chart(const std::vector<std::pair<typename Chart::vertex_type_ptr, typename Chart::vertex_id> >& items, Chart& chart)
+	{
+		// Called once for all the vertices added by 'chart::add_vertices'
+		for (std::size_t i = 0; chart.get_observer() && i < items.size(); ++i)
+		{
+			chart.get_observer()->push(Chart::event_type::VERTEX_ADDED, items[i].first, typename Chart::edge_type_ptr());
+		}
 	};
 
 	// events::on_vertex_removed_from_chart
 	template <class Chart>
-	static void on_vertex_removed_from_chart(typename Chart::vertex_type_ptr, Chart& chart)
+	static void on_vertex_removed_from_chart(typename Chart::vertex_type_ptr ptr, Chart& chart)
 	{
 		// Called whenever a vertex is removed from a chart
+		if (chart.get_observer()) chart.get_observer()->push(Chart::event_type::VERTEX_REMOVED, ptr, typename Chart::edge_type_ptr());
 	};
 
 	/***********
@@ -30,14 +47,27 @@ struct events {
 	***********/
 	// events::on_edge_added_to_chart
 	template <class Chart>
-	static void on_edge_added_to_chart(const typename std::pair<typename Chart::edge_type_ptr, typename Chart::edge_id>&, Chart& chart)
+	static void on_edge_added_to_chart(const typename std::pair<typename Chart::edge_type_ptr, typename Chart::edge_id>& item, Chart& chart)
+	{
+		if (chart.get_observer()) chart.get_observer()->push(Chart::event_type::EDGE_ADDED, typename Chart::vertex_type_ptr(), item.first);
+	};
+
+	// events::on_edges_added_to_chart
+	template <class Chart>
+	static void on_edges_added_to_chart(const std::vector<std::pair<typename Chart::edge_type_ptr, typename Chart::edge_id> >& items, Chart& chart)
 	{
+		// Called once for all the edges added by 'chart::add_edges'
+		for (std::size_t i = 0; chart.get_observer() && i < items.size(); ++i)
+		{
+			chart.get_observer()->push(Chart::event_type::EDGE_ADDED, typename Chart::vertex_type_ptr(), items[i].first);
+		}
 	};
 
 	// events::on_edge_removed_from_chart
 	template <class Chart>
-	static void on_edge_removed_from_chart(typename Chart::edge_type_ptr, Chart& chart)
+	static void on_edge_removed_from_chart(typename Chart::edge_type_ptr ptr, Chart& chart)
 	{
+		if (chart.get_observer()) chart.get_observer()->push(Chart::event_type::EDGE_REMOVED, typename Chart::vertex_type_ptr(), ptr);
 	};
 
 };
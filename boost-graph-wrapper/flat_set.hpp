@@ -0,0 +1,196 @@
+
+#pragma once
+
+#include <set>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+namespace core { namespace graph {
+
+/*! Storage policies for the edges of a vertex (see 'detail::vertex_connected'):
+    1) ordered_edge_set: std::set, one node allocation per edge.
+    2) flat_edge_set<N>: sorted array with room for N edges inside the vertex itself, it
+        only allocates (and then grows geometrically) for vertices with more than N edges.
+        Much more compact and faster to traverse for the usual small degrees, but
+        iterators are invalidated by any insertion or removal. Insertion and removal
+        shift the array, O(degree) each: building a vertex of degree d costs O(d²), so
+        keep ordered_edge_set for graphs with hubs (power-law degrees).
+    Both keep edges ordered by address, so iteration order does not depend on the policy.
+*/
+struct ordered_edge_set {};
+
+template <std::size_t N = 8>
+struct flat_edge_set {};
+
+namespace detail {
+
+/*************
+*   SMALL FLAT SET
+*************/
+template <class T, std::size_t N>
+class small_flat_set
+{
+	/*! Sorted array of trivially copyable values, stored inline while they fit in N and
+	    spilled to the heap beyond that. Provides the subset of the std::set interface
+	    used by the library.
+	*/
+		static_assert(std::is_trivially_copyable<T>::value, "small_flat_set requires trivially copyable values");
+		static_assert(N > 0, "small_flat_set requires some inline capacity");
+	public:
+		typedef T value_type;
+		typedef const T* iterator; // values are keys, they cannot be modified in place (same as std::set)
+		typedef const T* const_iterator;
+		typedef std::size_t size_type;
+
+	public:
+		small_flat_set() : _data(_inline), _size(0), _capacity(N) {};
+		small_flat_set(const small_flat_set& other) : _data(_inline), _size(0), _capacity(N)
+		{
+			this->assign(other.begin(), other.end());
+		};
+		small_flat_set& operator=(const small_flat_set& other)
+		{
+			if (this != &other)
+			{
+				_size = 0;
+				this->assign(other.begin(), other.end());
+			}
+			return *this;
+		};
+		~small_flat_set()
+		{
+			if (_data != _inline)
+			{
+				delete[] _data;
+			}
+		};
+
+		const_iterator begin() const { return _data;};
+		const_iterator end() const { return _data + _size;};
+
+		size_type size() const { return _size;};
+		bool empty() const { return _size == 0;};
+		size_type capacity() const { return _capacity;};
+
+		const_iterator find(const T& value) const
+		{
+			const_iterator it = this->lower_bound(value);
+			return (it != this->end() && !std::less<T>()(value, *it)) ? it : this->end();
+		};
+
+		size_type count(const T& value) const { return (this->find(value) != this->end()) ? 1 : 0;};
+
+		std::pair<iterator, bool> insert(const T& value)
+		{
+			std::size_t pos = this->lower_bound(value) - _data;
+			if (pos != _size && !std::less<T>()(value, _data[pos]))
+			{
+				return std::make_pair(_data + pos, false);
+			}
+			if (_size == _capacity)
+			{
+				this->grow(2*_capacity);
+			}
+			std::copy_backward(_data + pos, _data + _size, _data + _size + 1);
+			_data[pos] = value;
+			++_size;
+			return std::make_pair(_data + pos, true);
+		};
+
+		size_type erase(const T& value)
+		{
+			const_iterator it = this->find(value);
+			if (it == this->end())
+			{
+				return 0;
+			}
+			this->erase(it);
+			return 1;
+		};
+
+		iterator erase(const_iterator it)
+		{
+			T* pos = _data + (it - _data);
+			std::copy(pos + 1, _data + _size, pos);
+			--_size;
+			return pos;
+		};
+
+		void clear() { _size = 0;};
+
+	protected:
+		const_iterator lower_bound(const T& value) const
+		{
+			return std::lower_bound(this->begin(), this->end(), value, std::less<T>());
+		};
+
+		void assign(const_iterator first, const_iterator last)
+		{
+			// 'first, last' is sorted and unique
+			const std::size_t n = last - first;
+			if (n > _capacity)
+			{
+				this->grow(n);
+			}
+			std::copy(first, last, _data);
+			_size = static_cast<std::uint32_t>(n);
+		};
+
+		void grow(std::size_t capacity)
+		{
+			T* data = new T[capacity];
+			std::copy(_data, _data + _size, data);
+			if (_data != _inline)
+			{
+				delete[] _data;
+			}
+			_data = data;
+			_capacity = static_cast<std::uint32_t>(capacity);
+		};
+
+	protected:
+		T* _data;
+		std::uint32_t _size, _capacity; // a vertex with 4G edges would not fit in memory anyway
+		T _inline[N];
+};
+
+
+/*************
+*   SELECTION
+*************/
+template <class Selector, class T>
+struct edge_set_gen;
+
+template <class T>
+struct edge_set_gen<ordered_edge_set, T>
+{
+	typedef std::set<T> type;
+};
+
+template <std::size_t N, class T>
+struct edge_set_gen<flat_edge_set<N>, T>
+{
+	typedef small_flat_set<T, N> type;
+};
+
+/*! Heap bytes held by an edge set besides the object itself (for 'chart_metrics'),
+    estimated for std::set: a node is the value and three pointers plus the color.
+*/
+template <class T, std::size_t N>
+std::size_t heap_bytes(const small_flat_set<T, N>& set)
+{
+	return (set.capacity() > N) ? set.capacity()*sizeof(T) : 0;
+}
+
+template <class T>
+std::size_t heap_bytes(const std::set<T>& set)
+{
+	return set.size()*(sizeof(T) + 4*sizeof(void*));
+}
+
+}
+}}
@@ -0,0 +1,184 @@
+
+#pragma once
+
+#include <vector>
+#include <type_traits>
+#include <boost/graph/graph_traits.hpp>
+
+#include "components.hpp"
+
+namespace core { namespace graph {
+
+/*! Immutable compressed-sparse-row (CSR) snapshot of a chart.
+
+    Vertices and edges keep the dense indices they have in the chart when it is frozen
+    ('chart::get_vertex_index', 'get_edge_index'), so vectors keyed by dense index
+    (components, BFS distances...) work with both. Adjacency is stored in a couple of flat
+    arrays: out_offsets[v]..out_offsets[v+1] delimits the outgoing edges of 'v' inside
+    'out_edges' (same for incoming). Traversing a frozen chart never touches the boost::listS
+    nodes nor the shared_ptr properties of the original chart.
+
+    The snapshot exposes the same query API as 'chart' (get_edges_outgoing, get_source,...)
+    using dense 'vertex_id' and 'edge_id': like the chart, it has no incoming edges for
+    DIRECTED charts. For UNDIRECTED ones incoming and outgoing edges are the same, so the
+    incoming arrays are the outgoing ones, not a copy. It keeps the mapping back to the ids of the chart it was built from.
+    Later modifications of the chart are not reflected here: call 'chart::freeze()' again.
+*/
+template <class Chart>
+class frozen_chart
+{
+	public:
+		typedef typename Chart::vertex_type vertex_type;
+		typedef typename Chart::edge_type edge_type;
+		typedef typename Chart::vertex_type_ptr vertex_type_ptr;
+		typedef typename Chart::edge_type_ptr edge_type_ptr;
+
+		typedef std::size_t vertex_id;
+		typedef std::size_t edge_id;
+
+		typedef typename Chart::vertex_id chart_vertex_id;
+		typedef typename Chart::edge_id chart_edge_id;
+
+		typedef std::vector<std::size_t> _t_offsets;
+		typedef std::vector<edge_id> _t_adjacency;
+
+	public:
+		explicit frozen_chart(const Chart& chart)
+		{
+			const typename Chart::_t_graph& graph = chart._graph;
+			const std::size_t n_vertices = chart.num_vertices();
+			const std::size_t n_edges = chart.num_edges();
+
+			_vertex_ids.reserve(n_vertices);
+			_vertices.reserve(n_vertices);
+			for (std::size_t v = 0; v < n_vertices; ++v)
+			{
+				_vertex_ids.push_back(chart.get_vertex_at(v));
+				_vertices.push_back(graph[_vertex_ids.back()]);
+			}
+
+			_edge_ids.reserve(n_edges);
+			_edges.reserve(n_edges);
+			_sources.reserve(n_edges);
+			_targets.reserve(n_edges);
+			for (std::size_t e = 0; e < n_edges; ++e)
+			{
+				_edge_ids.push_back(chart.get_edge_at(e));
+				_edges.push_back(graph[_edge_ids.back()]);
+				_sources.push_back(chart.get_vertex_index(boost::source(_edge_ids.back(), graph)));
+				_targets.push_back(chart.get_vertex_index(boost::target(_edge_ids.back(), graph)));
+			}
+
+			/* For UNDIRECTED charts there is no source nor target, every edge is
+			   both outgoing and incoming for its two vertices.
+			*/
+			build_csr(_sources, is_undirected::value ? &_targets : 0, _out_offsets, _out_edges);
+			if (!is_directed::value && !is_undirected::value)
+			{
+				build_csr(_targets, is_undirected::value ? &_sources : 0, _in_offsets, _in_edges);
+			}
+		};
+
+		std::size_t num_vertices() const { return _vertex_ids.size();};
+		std::size_t num_edges() const { return _edge_ids.size();};
+
+		void get_edges_outgoing(const vertex_id& vertex, std::vector<edge_id>& edges) const
+		{
+			edges.insert(edges.end(), _out_edges.begin() + _out_offsets[vertex], _out_edges.begin() + _out_offsets[vertex+1]);
+		};
+
+		void get_edges_incoming(const vertex_id& vertex, std::vector<edge_id>& edges) const
+		{
+			static_assert(!is_directed::value, "incoming edges are not available for DIRECTED charts");
+			const _t_offsets& offsets = this->in_offsets();
+			const _t_adjacency& adjacency = this->in_adjacency();
+			edges.insert(edges.end(), adjacency.begin() + offsets[vertex], adjacency.begin() + offsets[vertex+1]);
+		};
+
+		vertex_id get_source(const edge_id& edge) const { return _sources[edge];};
+		vertex_id get_target(const edge_id& edge) const { return _targets[edge];};
+
+		std::pair<vertex_id, vertex_id> get_connected(const edge_id& edge) const
+		{
+			return std::make_pair(_sources[edge], _targets[edge]);
+		};
+
+		vertex_type_ptr get_vertex(const vertex_id& id) const { return _vertices[id];};
+		edge_type_ptr get_edge(const edge_id& id) const { return _edges[id];};
+
+		// All the elements, indexed by (dense) id
+		const std::vector<vertex_type_ptr>& get_vertices() const { return _vertices;};
+		const std::vector<edge_type_ptr>& get_edges() const { return _edges;};
+
+		// Mapping to the ids of the original chart, back through 'chart.get_vertex_index'
+		const chart_vertex_id& get_chart_vertex_id(const vertex_id& id) const { return _vertex_ids[id];};
+		const chart_edge_id& get_chart_edge_id(const edge_id& id) const { return _edge_ids[id];};
+
+		std::size_t connected_components(std::vector<std::size_t>& component, unsigned n_threads = 0) const
+		{
+			/*! Multi-threaded connected components, 'component' is indexed by (frozen) vertex_id.
+			    See 'detail::parallel_connected_components'.
+			*/
+			return detail::parallel_connected_components(_vertex_ids.size(), _edge_ids.size(), [this](std::size_t e)
+			{
+				return std::make_pair(_sources[e], _targets[e]);
+			}, component, n_threads);
+		};
+
+		// Raw CSR arrays
+		const _t_offsets& get_out_offsets() const { return _out_offsets;};
+		const _t_adjacency& get_out_edges() const { return _out_edges;};
+		const _t_offsets& get_in_offsets() const { static_assert(!is_directed::value, "incoming edges are not available for DIRECTED charts"); return this->in_offsets();};
+		const _t_adjacency& get_in_edges() const { static_assert(!is_directed::value, "incoming edges are not available for DIRECTED charts"); return this->in_adjacency();};
+
+	protected:
+		typedef std::is_same<typename Chart::behaviour, boost::undirectedS> is_undirected;
+		typedef std::is_same<typename Chart::behaviour, boost::directedS> is_directed;
+
+		// Incoming CSR, the outgoing one for UNDIRECTED charts
+		const _t_offsets& in_offsets() const { return is_undirected::value ? _out_offsets : _in_offsets;};
+		const _t_adjacency& in_adjacency() const { return is_undirected::value ? _out_edges : _in_edges;};
+
+		void build_csr(const std::vector<vertex_id>& key, const std::vector<vertex_id>* other_key, _t_offsets& offsets, _t_adjacency& adjacency) const
+		{
+			// Counting sort of edges by vertex
+			offsets.assign(_vertex_ids.size() + 1, 0);
+			for (std::size_t e = 0; e < key.size(); ++e)
+			{
+				++offsets[key[e]+1];
+				if (other_key && (*other_key)[e] != key[e])
+				{
+					++offsets[(*other_key)[e]+1];
+				}
+			}
+			for (std::size_t v = 0; v < _vertex_ids.size(); ++v)
+			{
+				offsets[v+1] += offsets[v];
+			}
+
+			adjacency.resize(offsets.back());
+			_t_offsets cursor(offsets.begin(), offsets.end() - 1);
+			for (std::size_t e = 0; e < key.size(); ++e)
+			{
+				adjacency[cursor[key[e]]++] = e;
+				if (other_key && (*other_key)[e] != key[e])
+				{
+					adjacency[cursor[(*other_key)[e]]++] = e;
+				}
+			}
+		};
+
+	protected:
+		// Topology
+		_t_offsets _out_offsets, _in_offsets; // '_in_*' are empty unless BIDIRECTIONAL
+		_t_adjacency _out_edges, _in_edges;
+		std::vector<vertex_id> _sources, _targets;
+
+		// Payload and mapping back to the chart
+		std::vector<vertex_type_ptr> _vertices;
+		std::vector<edge_type_ptr> _edges;
+		std::vector<chart_vertex_id> _vertex_ids;
+		std::vector<chart_edge_id> _edge_ids;
+};
+
+}}
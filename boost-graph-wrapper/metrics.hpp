@@ -0,0 +1,226 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace core { namespace graph {
+
+/*! Compile-time switch of the instrumentation of all the charts of the given types:
+    specialize it with 'enabled = true' to make them count calls and measure the latency of
+    their operations (see 'chart_impl::get_metrics'). Disabled charts carry no counters and
+    their operations are not timed at all. By default there is none.
+*/
+template <class VertexType, class EdgeType, int Behaviour>
+struct chart_instrumentation
+{
+	static const bool enabled = false;
+};
+
+/*! Snapshot of the metrics of a chart (see 'chart_impl::get_metrics').
+
+    Latencies go to log2 histograms: bucket 'b' counts the calls that took [2^b, 2^(b+1))
+    nanoseconds (bucket 0 also those under 1ns). Memory is what the chart holds besides
+    the elements themselves, estimated for node-based containers; the arena does not tell
+    graph nodes from the elements it also holds, so 'arena_bytes' counts both.
+*/
+struct chart_metrics
+{
+	enum _e_operation { ADD_VERTEX, REMOVE_VERTEX, ADD_EDGE, REMOVE_EDGE, LOOKUP, CONNECTED_COMPONENTS, N_OPERATIONS };
+	static const std::size_t n_buckets = 40;
+
+	struct operation
+	{
+		std::uint64_t calls;
+		std::uint64_t total_ns;
+		std::uint64_t histogram[n_buckets];
+
+		double mean_ns() const { return calls ? static_cast<double>(total_ns)/calls : 0.0;};
+
+		std::uint64_t percentile_ns(double p) const
+		{
+			// Upper bound of the bucket holding the given fraction of the calls
+			const double target = p*calls;
+			std::uint64_t seen = 0;
+			for (std::size_t b = 0; b < n_buckets; ++b)
+			{
+				seen += histogram[b];
+				if (seen > 0 && seen >= target)
+				{
+					return std::uint64_t(2) << b;
+				}
+			}
+			return 0;
+		};
+	};
+
+	static const char* operation_name(_e_operation op)
+	{
+		static const char* names[N_OPERATIONS] = {"add_vertex", "remove_vertex", "add_edge", "remove_edge", "lookup", "connected_components"};
+		return names[op];
+	};
+
+	bool enabled; // operations are only counted if the chart is instrumented
+	operation operations[N_OPERATIONS];
+
+	std::size_t vertices, edges;
+	std::size_t max_degree; // now
+	std::size_t peak_degree; // highest degree reached by any vertex (when instrumented)
+
+	std::size_t vertex_index_bytes, edge_index_bytes; // '_vertices'/'_edges' and the dense indices
+	std::size_t arena_bytes; // carved from the arena: boost edge nodes, and the elements made by 'create_vertex'/'create_edge' (not the boost vertex nodes)
+	std::size_t edge_set_bytes; // heap held by the edge sets of the vertices, summed over all of them
+};
+
+namespace detail {
+
+class metrics_collector
+{
+	/*! Counters of an instrumented chart. Operations may be recorded from several threads
+	    (lookups are const): every thread writes to one of 'n_shards' sets of counters with
+	    relaxed atomics, they are only added up by 'collect'.
+	*/
+	public:
+		static const bool enabled = true;
+		static const std::size_t n_shards = 16;
+
+		class scope
+		{
+			// Times an operation from construction to destruction
+			public:
+				scope(metrics_collector& metrics, chart_metrics::_e_operation op) : _metrics(metrics), _op(op), _start(std::chrono::steady_clock::now()) {};
+				~scope()
+				{
+					_metrics.record(_op, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+				};
+
+			protected:
+				metrics_collector& _metrics;
+				chart_metrics::_e_operation _op;
+				std::chrono::steady_clock::time_point _start;
+		};
+
+	public:
+		metrics_collector() : _peak_degree(0)
+		{
+			this->reset();
+		};
+
+		void record(chart_metrics::_e_operation op, std::int64_t ns)
+		{
+			const std::uint64_t elapsed = ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+			std::size_t bucket = 0;
+			while (bucket + 1 < chart_metrics::n_buckets && (elapsed >> (bucket + 1)))
+			{
+				++bucket;
+			}
+			counters& shard = _shards[metrics_collector::shard_index()].operations[op];
+			shard.calls.fetch_add(1, std::memory_order_relaxed);
+			shard.total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+			shard.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+		};
+
+		void observe_degree(std::size_t degree)
+		{
+			std::size_t peak = _peak_degree.load(std::memory_order_relaxed);
+			while (degree > peak && !_peak_degree.compare_exchange_weak(peak, degree, std::memory_order_relaxed)) {}
+		};
+
+		void collect(chart_metrics& metrics) const
+		{
+			metrics.enabled = true;
+			for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+			{
+				chart_metrics::operation& total = metrics.operations[op];
+				total.calls = total.total_ns = 0;
+				for (std::size_t b = 0; b < chart_metrics::n_buckets; ++b)
+				{
+					total.histogram[b] = 0;
+				}
+				for (std::size_t s = 0; s < n_shards; ++s)
+				{
+					const counters& shard = _shards[s].operations[op];
+					total.calls += shard.calls.load(std::memory_order_relaxed);
+					total.total_ns += shard.total_ns.load(std::memory_order_relaxed);
+					for (std::size_t b = 0; b < chart_metrics::n_buckets; ++b)
+					{
+						total.histogram[b] += shard.histogram[b].load(std::memory_order_relaxed);
+					}
+				}
+			}
+			metrics.peak_degree = _peak_degree.load(std::memory_order_relaxed);
+		};
+
+		void reset()
+		{
+			// Operations only, the peak degree is kept
+			for (std::size_t s = 0; s < n_shards; ++s)
+			{
+				for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+				{
+					counters& shard = _shards[s].operations[op];
+					shard.calls.store(0, std::memory_order_relaxed);
+					shard.total_ns.store(0, std::memory_order_relaxed);
+					for (std::size_t b = 0; b < chart_metrics::n_buckets; ++b)
+					{
+						shard.histogram[b].store(0, std::memory_order_relaxed);
+					}
+				}
+			}
+		};
+
+	protected:
+		static std::size_t shard_index()
+		{
+			// Threads are spread over the shards in order of arrival
+			static std::atomic<std::size_t> next(0);
+			static thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % n_shards;
+			return index;
+		};
+
+		struct counters
+		{
+			std::atomic<std::uint64_t> calls;
+			std::atomic<std::uint64_t> total_ns;
+			std::atomic<std::uint64_t> histogram[chart_metrics::n_buckets];
+		};
+
+		struct shard
+		{
+			counters operations[chart_metrics::N_OPERATIONS];
+			char padding[64]; // keep neighbouring shards in different cache lines
+		};
+
+	protected:
+		shard _shards[n_shards];
+		std::atomic<std::size_t> _peak_degree;
+};
+
+struct no_metrics_collector
+{
+	// Not instrumented: nothing is stored and nothing is timed
+	static const bool enabled = false;
+
+	class scope
+	{
+		public:
+			scope(no_metrics_collector&, chart_metrics::_e_operation) {};
+	};
+
+	void observe_degree(std::size_t) {};
+	void collect(chart_metrics& metrics) const
+	{
+		metrics.enabled = false;
+		metrics.peak_degree = 0;
+		for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+		{
+			metrics.operations[op] = chart_metrics::operation();
+		}
+	};
+	void reset() {};
+};
+
+}
+}}
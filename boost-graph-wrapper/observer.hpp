@@ -0,0 +1,303 @@
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <cassert>
+
+namespace core { namespace graph {
+
+/*! Mutation of a chart as seen by its listeners. Only the element is given, ids of removed
+    elements are not valid anymore (and by delivery time those of added ones may have
+    been reused): use 'chart::get_vertex_id'/'get_edge_id' if needed.
+*/
+template <class Chart>
+struct chart_event
+{
+	enum _e_kind { VERTEX_ADDED, VERTEX_REMOVED, EDGE_ADDED, EDGE_REMOVED };
+
+	_e_kind kind;
+	typename Chart::vertex_type_ptr vertex; // VERTEX_* events
+	typename Chart::edge_type_ptr edge; // EDGE_* events
+};
+
+/*! Run-time listener (see 'chart_impl::enable_events'), it receives the events in batches
+    and in the order they happened.
+*/
+template <class Chart>
+class chart_listener
+{
+	public:
+		virtual ~chart_listener() {};
+		virtual void on_events(const std::vector<chart_event<Chart> >& events, Chart& chart) = 0;
+};
+
+/*! Compile-time listener of all the charts of the given types: specialize it with
+    'enabled = true' and an 'on_events' function like the one of 'chart_listener'. Those
+    charts enable events on construction and call it statically before the run-time
+    listeners. By default there is none.
+*/
+template <class VertexType, class EdgeType, int Behaviour>
+struct static_listener
+{
+	static const bool enabled = false;
+
+	template <class Chart>
+	static void on_events(const std::vector<chart_event<Chart> >&, Chart&) {};
+};
+
+namespace detail {
+
+/*! Queue of the events of a chart and their delivery to listeners.
+
+    Mutations only push events into a ring buffer (a couple of shared_ptr copies, no lock)
+    and listeners take them in batches: when 'flush' is called, when the ring is full, or
+    periodically from a dispatcher thread ('start_dispatcher').
+
+    The ring has a single producer, the thread modifying the chart (charts are not thread
+    safe anyway), and deliveries are serialized. With a dispatcher thread listeners run
+    concurrently with further mutations: they should not query the chart without their
+    own synchronization. Events keep their elements alive until delivered, but the
+    dispatcher thread never destroys them: it hands delivered batches back to the chart
+    thread, that releases them on its next mutation (destroying an edge modifies its
+    vertices).
+
+    Listeners may register or unregister listeners from 'on_events', and, when delivered
+    from the chart thread ('flush' or a full ring), modify the chart: the events they cause
+    are delivered after the current batch, within the same 'flush' (the ring grows if it
+    fills up meanwhile). Listeners registered during a delivery receive the next batches,
+    those unregistered still receive the current one. Delivered from the dispatcher thread
+    they must not modify the chart (asserted), and no listener may disable the events.
+*/
+template <class Chart, class StaticListener>
+class chart_observer
+{
+	public:
+		typedef chart_event<Chart> event_type;
+		typedef chart_listener<Chart> listener_type;
+
+	public:
+		chart_observer(Chart& chart, std::size_t capacity) : _chart(chart), _head(0), _tail(0), _delivering(std::thread::id()), _from_dispatcher(false), _has_spent(false), _running(false)
+		{
+			std::size_t size = 2;
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+			_ring.resize(size);
+		};
+
+		~chart_observer()
+		{
+			this->stop_dispatcher();
+			this->flush();
+			this->release_spent();
+		};
+
+		void add_listener(const std::shared_ptr<listener_type>& listener)
+		{
+			std::unique_lock<std::mutex> lock(_delivery, std::defer_lock);
+			if (!this->is_delivering())
+			{
+				lock.lock(); // else called from 'on_events', the lock is already ours
+			}
+			_listeners.push_back(listener);
+		};
+
+		void remove_listener(const std::shared_ptr<listener_type>& listener)
+		{
+			std::unique_lock<std::mutex> lock(_delivery, std::defer_lock);
+			if (!this->is_delivering())
+			{
+				lock.lock();
+			}
+			_listeners.erase(std::remove(_listeners.begin(), _listeners.end(), listener), _listeners.end());
+		};
+
+		std::size_t pending() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);};
+
+		void push(typename event_type::_e_kind kind, const typename Chart::vertex_type_ptr& vertex, const typename Chart::edge_type_ptr& edge)
+		{
+			assert(!this->is_delivering() || !_from_dispatcher); // listeners run by the dispatcher cannot modify the chart
+			std::size_t tail = _tail.load(std::memory_order_relaxed);
+			if (tail - _head.load(std::memory_order_acquire) == _ring.size())
+			{
+				if (this->is_delivering())
+				{
+					this->grow(); // a listener modifying the chart, its delivery is not over
+				}
+				else
+				{
+					this->drain(false); // full, deliver from here
+				}
+			}
+			event_type& slot = _ring[tail & (_ring.size() - 1)];
+			slot.kind = kind;
+			slot.vertex = vertex;
+			slot.edge = edge;
+			_tail.store(tail + 1, std::memory_order_release);
+
+			if (_has_spent.load(std::memory_order_relaxed))
+			{
+				this->release_spent();
+			}
+			if (_running.load(std::memory_order_relaxed) && tail + 1 - _head.load(std::memory_order_relaxed) == _ring.size()/2)
+			{
+				_wake.notify_one(); // do not wait for the period when the ring is filling up
+			}
+		};
+
+		void flush()
+		{
+			// Delivers all the pending events now, from the calling thread (the one modifying the chart)
+			this->drain(false);
+		};
+
+		void start_dispatcher(std::chrono::milliseconds period = std::chrono::milliseconds(10))
+		{
+			if (_running.exchange(true))
+			{
+				return;
+			}
+			_dispatcher = std::thread([this, period]
+			{
+				std::unique_lock<std::mutex> lock(_wake_mutex);
+				while (_running.load())
+				{
+					_wake.wait_for(lock, period);
+					lock.unlock();
+					this->drain(true);
+					lock.lock();
+				}
+			});
+		};
+
+		void stop_dispatcher()
+		{
+			// Pending events are not delivered, 'flush' afterwards if needed
+			if (!_running.exchange(false))
+			{
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(_wake_mutex);
+				_wake.notify_one();
+			}
+			_dispatcher.join();
+			this->release_spent();
+		};
+
+	protected:
+		bool is_delivering() const { return _delivering.load(std::memory_order_relaxed) == std::this_thread::get_id();};
+
+		void drain(bool from_dispatcher)
+		{
+			if (this->is_delivering())
+			{
+				return; // called from 'on_events', the delivery in progress takes the new events
+			}
+			std::lock_guard<std::mutex> lock(_delivery);
+			delivering_guard guard(_delivering);
+			_from_dispatcher = from_dispatcher;
+			for (;;)
+			{
+				std::size_t head = _head.load(std::memory_order_relaxed);
+				const std::size_t tail = _tail.load(std::memory_order_acquire);
+				if (head == tail)
+				{
+					return;
+				}
+				_batch.reserve(tail - head);
+				for (; head != tail; ++head)
+				{
+					_batch.push_back(std::move(_ring[head & (_ring.size() - 1)]));
+				}
+				_head.store(head, std::memory_order_release);
+
+				// Listeners may (un)register listeners meanwhile
+				const std::vector<std::shared_ptr<listener_type> > listeners(_listeners);
+				if (StaticListener::enabled)
+				{
+					StaticListener::on_events(_batch, _chart);
+				}
+				for (typename std::vector<std::shared_ptr<listener_type> >::const_iterator it = listeners.begin(); it != listeners.end(); ++it)
+				{
+					(*it)->on_events(_batch, _chart);
+				}
+
+				if (from_dispatcher)
+				{
+					std::lock_guard<std::mutex> spent_lock(_spent_mutex);
+					std::move(_batch.begin(), _batch.end(), std::back_inserter(_spent));
+					_has_spent.store(true, std::memory_order_relaxed);
+				}
+				_batch.clear();
+			}
+		};
+
+		void grow()
+		{
+			// Only while the calling thread delivers: nobody else reads the ring meanwhile
+			std::vector<event_type> ring(2*_ring.size());
+			const std::size_t tail = _tail.load(std::memory_order_relaxed);
+			for (std::size_t i = _head.load(std::memory_order_relaxed); i != tail; ++i)
+			{
+				ring[i & (ring.size() - 1)] = std::move(_ring[i & (_ring.size() - 1)]);
+			}
+			_ring.swap(ring);
+		};
+
+		struct delivering_guard
+		{
+			// Marks the calling thread as the one delivering, until the end of the scope (or an exception)
+			explicit delivering_guard(std::atomic<std::thread::id>& id) : _id(id) { _id.store(std::this_thread::get_id(), std::memory_order_relaxed);};
+			~delivering_guard() { _id.store(std::thread::id(), std::memory_order_relaxed);};
+			std::atomic<std::thread::id>& _id;
+		};
+
+		void release_spent()
+		{
+			std::vector<event_type> spent;
+			{
+				std::lock_guard<std::mutex> lock(_spent_mutex);
+				spent.swap(_spent);
+				_has_spent.store(false, std::memory_order_relaxed);
+			}
+		};
+
+	protected:
+		Chart& _chart;
+
+		// Ring buffer, '_head' and '_tail' only grow (positions are taken modulo the size, a power of 2)
+		std::vector<event_type> _ring;
+		std::atomic<std::size_t> _head, _tail;
+
+		// Delivery
+		std::mutex _delivery; // one delivery at a time, also guards '_listeners'
+		std::vector<std::shared_ptr<listener_type> > _listeners;
+		std::vector<event_type> _batch;
+		std::atomic<std::thread::id> _delivering; // thread holding '_delivery' to deliver, if any
+		bool _from_dispatcher; // of the delivery in progress
+
+		// Delivered by the dispatcher, to be released by the chart thread
+		std::mutex _spent_mutex;
+		std::vector<event_type> _spent;
+		std::atomic<bool> _has_spent;
+
+		// Dispatcher thread
+		std::thread _dispatcher;
+		std::mutex _wake_mutex;
+		std::condition_variable _wake;
+		std::atomic<bool> _running;
+};
+
+}
+}}
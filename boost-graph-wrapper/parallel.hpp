@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstddef>
+
+namespace core { namespace graph { namespace detail {
+
+/*! Number of threads to use for a given request: '0' means as many as the hardware
+    supports, and there is no point in spawning more threads than items.
+*/
+inline unsigned resolve_threads(unsigned n_threads, std::size_t n_items)
+{
+	if (n_threads == 0)
+	{
+		n_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	return static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(n_threads, n_items)));
+}
+
+/*! Splits [0, n) in 'n_threads' contiguous chunks and calls 'f(thread, begin, end)'
+    for each of them in its own thread (the calling thread takes the first chunk).
+    Returns once all the chunks are done.
+*/
+template <class Function>
+void parallel_for(std::size_t n, unsigned n_threads, Function f)
+{
+	n_threads = resolve_threads(n_threads, n);
+	const std::size_t chunk = (n + n_threads - 1)/n_threads;
+
+	std::vector<std::thread> threads;
+	threads.reserve(n_threads - 1);
+	for (unsigned t = 1; t < n_threads; ++t)
+	{
+		const std::size_t begin = std::min(n, t*chunk);
+		const std::size_t end = std::min(n, begin + chunk);
+		threads.push_back(std::thread(f, t, begin, end));
+	}
+	f(0u, std::size_t(0), std::min(n, chunk));
+
+	for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+	{
+		it->join();
+	}
+}
+
+/*! Reusable barrier for a fixed number of threads: 'wait' blocks until all of them
+    have called it, then they are all released and the barrier is ready again.
+*/
+class barrier
+{
+	public:
+		explicit barrier(unsigned n_threads) : _n_threads(n_threads), _waiting(0), _generation(0) {};
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			const std::size_t generation = _generation;
+			if (++_waiting == _n_threads)
+			{
+				_waiting = 0;
+				++_generation;
+				_condition.notify_all();
+			}
+			else
+			{
+				_condition.wait(lock, [this, generation] { return _generation != generation;});
+			}
+		};
+
+	protected:
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		const unsigned _n_threads;
+		unsigned _waiting;
+		std::size_t _generation;
+};
+
+}}}
@@ -0,0 +1,226 @@
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "parallel.hpp"
+
+namespace core { namespace graph { namespace detail {
+
+inline unsigned lowest_bit(std::uint64_t bits)
+{
+	// Index of the lowest bit set, 'bits' cannot be 0
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+}
+
+/*! Set of dense vertex indices [0, n), one bit each. Bits can be set concurrently. */
+class frontier_bitmap
+{
+	public:
+		explicit frontier_bitmap(std::size_t n) : _words((n + 63)/64)
+		{
+			this->clear(0, _words.size());
+		};
+
+		std::size_t num_words() const { return _words.size();};
+
+		std::uint64_t word(std::size_t w) const { return _words[w].load(std::memory_order_relaxed);};
+
+		bool test(std::size_t i) const { return (this->word(i >> 6) >> (i & 63)) & 1;};
+
+		void set(std::size_t i) { _words[i >> 6].fetch_or(std::uint64_t(1) << (i & 63), std::memory_order_relaxed);};
+
+		void clear(std::size_t begin_word, std::size_t end_word)
+		{
+			for (std::size_t w = begin_word; w < end_word; ++w)
+			{
+				_words[w].store(0, std::memory_order_relaxed);
+			}
+		};
+
+	protected:
+		std::vector<std::atomic<std::uint64_t> > _words;
+};
+
+
+/*! Level-synchronous, direction-optimizing breadth-first search (Beamer et al.) over dense
+    vertex indices [0, n_vertices), 'n_edges' of them in total:
+      - 'out_degree(v)' returns the number of outgoing edges of 'v'.
+      - 'for_each_out(v, f)' calls 'f(u)' for the target 'u' of every outgoing edge of 'v'.
+      - 'for_each_in(v, f)' calls 'f(u)' for the source 'u' of every incoming edge of 'v'
+        and stops as soon as 'f' returns true.
+
+    Every level is expanded either top-down (from the frontier through the outgoing edges)
+    or bottom-up (every unvisited vertex looks for a parent in the frontier through its
+    incoming edges, stopping at the first one), whichever is expected to touch fewer
+    edges: bottom-up pays off once the frontier is large. Both frontiers are bitmaps and
+    the threads claim chunks of them dynamically, so that high degree vertices do not
+    leave the other threads idle.
+
+    On return 'distance[v]' is the number of edges from 'source' to 'v' and 'parent[v]'
+    the previous vertex in one shortest path ('source' for itself), both are size_t(-1)
+    for unreachable vertices. Distances are exact whatever the number of threads, parents
+    may differ between runs. Returns the number of vertices reached.
+*/
+template <class OutDegree, class ForEachOut, class ForEachIn>
+std::size_t parallel_direction_optimizing_bfs(std::size_t n_vertices, std::size_t n_edges, std::size_t source,
+                                              OutDegree out_degree, ForEachOut for_each_out, ForEachIn for_each_in,
+                                              std::vector<std::size_t>& distance, std::vector<std::size_t>& parent, unsigned n_threads = 0)
+{
+	static const std::size_t unreached = std::size_t(-1);
+	static const std::size_t chunk_words = 16; // 1024 vertices claimed at once
+	static const std::size_t alpha = 14, beta = 24; // switching thresholds from the paper
+
+	distance.assign(n_vertices, unreached);
+	parent.assign(n_vertices, unreached);
+	if (source >= n_vertices)
+	{
+		return 0;
+	}
+
+	std::vector<std::atomic<std::size_t> > parent_of(n_vertices);
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		parent_of[v].store(unreached, std::memory_order_relaxed);
+	}
+	frontier_bitmap frontier_a(n_vertices), frontier_b(n_vertices);
+
+	struct level_stats
+	{
+		std::size_t vertices, edges; // found for the next level and their out-degree
+		char padding[64 - 2*sizeof(std::size_t)];
+	};
+
+	// Shared state, only modified by thread 0 between the two barriers of every level
+	n_threads = resolve_threads(n_threads, (n_vertices + 64*chunk_words - 1)/(64*chunk_words));
+	std::vector<level_stats> stats(n_threads);
+	std::atomic<std::size_t> next_chunk(0);
+	frontier_bitmap* current = &frontier_a;
+	frontier_bitmap* next = &frontier_b;
+	bool bottom_up = false, done = false;
+	std::size_t level = 0, frontier_vertices = 1, frontier_edges = out_degree(source);
+	std::size_t unexplored_edges = n_edges - frontier_edges, reached = 1;
+	barrier sync(n_threads);
+
+	parent_of[source].store(source, std::memory_order_relaxed);
+	distance[source] = 0;
+	current->set(source);
+
+	const std::size_t n_words = current->num_words();
+	const std::size_t n_chunks = (n_words + chunk_words - 1)/chunk_words;
+	parallel_for(n_threads, n_threads, [&](unsigned thread, std::size_t, std::size_t)
+	{
+		level_stats& mine = stats[thread];
+		while (true)
+		{
+			mine.vertices = mine.edges = 0;
+			for (std::size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed); chunk < n_chunks; chunk = next_chunk.fetch_add(1, std::memory_order_relaxed))
+			{
+				const std::size_t end_word = std::min(n_words, (chunk + 1)*chunk_words);
+				for (std::size_t w = chunk*chunk_words; w < end_word; ++w)
+				{
+					if (!bottom_up)
+					{
+						// Top-down: claim the unvisited targets of the frontier
+						for (std::uint64_t bits = current->word(w); bits; bits &= bits - 1)
+						{
+							const std::size_t v = 64*w + lowest_bit(bits);
+							for_each_out(v, [&](std::size_t u)
+							{
+								std::size_t expected = unreached;
+								if (parent_of[u].load(std::memory_order_relaxed) == unreached && parent_of[u].compare_exchange_strong(expected, v, std::memory_order_relaxed))
+								{
+									distance[u] = level + 1;
+									next->set(u);
+									++mine.vertices;
+									mine.edges += out_degree(u);
+								}
+							});
+						}
+					}
+					else
+					{
+						// Bottom-up: unvisited vertices of this chunk look for a parent in the frontier
+						const std::size_t end = std::min(n_vertices, 64*(w + 1));
+						for (std::size_t v = 64*w; v < end; ++v)
+						{
+							if (parent_of[v].load(std::memory_order_relaxed) != unreached)
+							{
+								continue;
+							}
+							for_each_in(v, [&](std::size_t u)
+							{
+								if (!current->test(u))
+								{
+									return false;
+								}
+								parent_of[v].store(u, std::memory_order_relaxed);
+								distance[v] = level + 1;
+								next->set(v);
+								++mine.vertices;
+								mine.edges += out_degree(v);
+								return true;
+							});
+						}
+					}
+				}
+			}
+			sync.wait();
+
+			if (thread == 0)
+			{
+				frontier_vertices = frontier_edges = 0;
+				for (std::size_t t = 0; t < stats.size(); ++t)
+				{
+					frontier_vertices += stats[t].vertices;
+					frontier_edges += stats[t].edges;
+				}
+				reached += frontier_vertices;
+				unexplored_edges -= frontier_edges;
+				done = (frontier_vertices == 0);
+				if (!bottom_up)
+				{
+					bottom_up = (frontier_edges > unexplored_edges/alpha);
+				}
+				else
+				{
+					bottom_up = (frontier_vertices >= n_vertices/beta);
+				}
+				std::swap(current, next);
+				next_chunk.store(0, std::memory_order_relaxed);
+				++level;
+			}
+			sync.wait();
+
+			if (done)
+			{
+				break;
+			}
+			// The old frontier is the next one now, every thread clears its part before going on
+			const std::size_t slice = (n_words + n_threads - 1)/n_threads;
+			next->clear(std::min(n_words, thread*slice), std::min(n_words, (thread + 1)*slice));
+			sync.wait();
+		}
+	});
+
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		parent[v] = parent_of[v].load(std::memory_order_relaxed);
+	}
+	return reached;
+}
+
+}}}
@@ -0,0 +1,283 @@
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/graph/graph_traits.hpp>
+
+#include "traits.hpp"
+#include "vertex_traits.hpp"
+#include "edge_traits.hpp"
+
+namespace core { namespace graph {
+
+namespace detail { template <class VertexType, class EdgeType, int Behaviour> class chart_impl; }
+
+/*! Base class for the visitors of 'search', it does nothing. Derive from it and redefine
+    (hide) the functions of interest: they are called statically, nothing is virtual.
+*/
+template <class Chart>
+class search_visitor
+{
+	public:
+		typedef typename Chart::vertex_id vertex_id;
+		typedef typename Chart::edge_id edge_id;
+		typedef detail::edge_visitable::_e_visitor_labels edge_label;
+
+	public:
+		void discover_vertex(const vertex_id&) {}; // first time the vertex is reached
+		void examine_edge(const edge_id&, edge_label) {}; // every edge leaving a discovered vertex, classified
+		void finish_vertex(const vertex_id&) {}; // all the edges of the vertex have been examined
+};
+
+namespace _impl
+{
+	// Stepping along the edges of a vertex in the direction of the search
+	template <class Graph>
+	struct search_forwards
+	{
+		typedef typename boost::graph_traits<Graph>::out_edge_iterator edge_iterator;
+		static std::pair<edge_iterator, edge_iterator> edges(const typename Graph::vertex_descriptor& v, const Graph& g) { return boost::out_edges(v, g);};
+		static typename Graph::vertex_descriptor next(const typename Graph::edge_descriptor& e, const Graph& g) { return boost::target(e, g);};
+	};
+
+	template <class Graph>
+	struct search_backwards
+	{
+		typedef typename boost::graph_traits<Graph>::in_edge_iterator edge_iterator;
+		static std::pair<edge_iterator, edge_iterator> edges(const typename Graph::vertex_descriptor& v, const Graph& g) { return boost::in_edges(v, g);};
+		static typename Graph::vertex_descriptor next(const typename Graph::edge_descriptor& e, const Graph& g) { return boost::source(e, g);};
+	};
+}
+
+/*! Breadth-first and depth-first traversals over a chart (or a view of it, see 'filtered_chart').
+
+    Visitation state lives in the 'search' object (a color per dense vertex index, see
+    'chart_impl::get_vertex_index'), not in the vertices: any number of searches can run
+    at the same time on the same chart, each thread with its own 'search', as long as
+    nobody modifies the chart meanwhile. The in-object labels of 'vertex_visitable' and
+    'edge_visitable' are not used (nor modified).
+
+    Direction follows '_e_direction': FORWARDS walks outgoing edges and BACKWARDS incoming
+    ones. It makes no difference for UNDIRECTED charts, and DIRECTED charts can only be
+    searched FORWARDS.
+
+    Edges are classified as in boost: TREE_EDGE, BACK_EDGE and FORWARD_OR_CROSS_EDGE for
+    depth-first search, TREE_EDGE and NON_TREE_EDGE for breadth-first search. On UNDIRECTED
+    charts depth-first search reports every edge once (TREE_EDGE or BACK_EDGE) whereas
+    breadth-first search examines them from both ends.
+
+    Successive searches from different sources share the state, so vertices reached by a
+    previous search are not visited again (e.g. to cover all the graph with a DFS forest)
+    until 'reset' is called. Depth-first search is iterative: no recursion limits.
+*/
+template <class Chart>
+class search
+{
+	public:
+		typedef typename Chart::vertex_id vertex_id;
+		typedef typename Chart::edge_id edge_id;
+		typedef typename Chart::_t_graph _t_graph;
+		typedef detail::vertex_visitable::_e_visitor_labels vertex_label;
+		typedef detail::edge_visitable::_e_visitor_labels edge_label;
+
+	public:
+		explicit search(const Chart& chart) : _chart(chart), _graph(search::graph_of(chart)), _labels(chart.num_vertices(), detail::vertex_visitable::UNDISCOVERED) {};
+
+		template <class Visitor>
+		void breadth_first(const vertex_id& source, Visitor& visitor, _e_direction direction = FORWARDS)
+		{
+			this->dispatch<true>(source, visitor, direction, typename boost::graph_traits<_t_graph>::directed_category());
+		};
+
+		template <class Visitor>
+		void depth_first(const vertex_id& source, Visitor& visitor, _e_direction direction = FORWARDS)
+		{
+			this->dispatch<false>(source, visitor, direction, typename boost::graph_traits<_t_graph>::directed_category());
+		};
+
+		vertex_label get_label(const vertex_id& v) const { return static_cast<vertex_label>(_labels[_chart.get_vertex_index(v)]);};
+		bool is_discovered(const vertex_id& v) const { return _labels[_chart.get_vertex_index(v)] != detail::vertex_visitable::UNDISCOVERED;};
+
+		void reset()
+		{
+			// Only the vertices reached since the last reset are cleared
+			for (typename std::vector<std::size_t>::const_iterator it = _reached.begin(); it != _reached.end(); ++it)
+			{
+				_labels[*it] = detail::vertex_visitable::UNDISCOVERED;
+			}
+			_reached.clear();
+		};
+
+	protected:
+		template <class VertexType, class EdgeType, int Behaviour>
+		static const _t_graph& graph_of(const detail::chart_impl<VertexType, EdgeType, Behaviour>& chart) { return chart._graph;};
+
+		template <class View>
+		static const _t_graph& graph_of(const View& view, decltype(&View::get_graph) = 0) { return view.get_graph();}; // views, see 'filtered_chart'
+
+		template <bool BreadthFirst, class Visitor>
+		void dispatch(const vertex_id& source, Visitor& visitor, _e_direction, boost::undirected_tag)
+		{
+			this->run<BreadthFirst, _impl::search_forwards<_t_graph> >(source, visitor, true);
+		};
+
+		template <bool BreadthFirst, class Visitor>
+		void dispatch(const vertex_id& source, Visitor& visitor, _e_direction direction, boost::bidirectional_tag)
+		{
+			if (direction == FORWARDS)
+			{
+				this->run<BreadthFirst, _impl::search_forwards<_t_graph> >(source, visitor, false);
+			}
+			else
+			{
+				this->run<BreadthFirst, _impl::search_backwards<_t_graph> >(source, visitor, false);
+			}
+		};
+
+		template <bool BreadthFirst, class Visitor>
+		void dispatch(const vertex_id& source, Visitor& visitor, _e_direction direction, boost::directed_tag)
+		{
+			if (direction != FORWARDS)
+			{
+				throw std::runtime_error("DIRECTED charts can only be searched FORWARDS");
+			}
+			this->run<BreadthFirst, _impl::search_forwards<_t_graph> >(source, visitor, false);
+		};
+
+		template <bool BreadthFirst, class Step, class Visitor>
+		void run(const vertex_id& source, Visitor& visitor, bool undirected)
+		{
+			if (this->is_discovered(source))
+			{
+				return;
+			}
+			if (BreadthFirst)
+			{
+				this->breadth_first_impl<Step>(source, visitor);
+			}
+			else
+			{
+				this->depth_first_impl<Step>(source, visitor, undirected);
+			}
+		};
+
+		template <class Step, class Visitor>
+		void breadth_first_impl(const vertex_id& source, Visitor& visitor)
+		{
+			std::vector<vertex_id> queue(1, source);
+			this->discover(source, visitor);
+			for (std::size_t head = 0; head < queue.size(); ++head)
+			{
+				const vertex_id v = queue[head];
+				typename Step::edge_iterator it, it_end;
+				for (boost::tie(it, it_end) = Step::edges(v, _graph); it != it_end; ++it)
+				{
+					const vertex_id next = Step::next(*it, _graph);
+					if (this->is_discovered(next))
+					{
+						visitor.examine_edge(*it, detail::edge_visitable::NON_TREE_EDGE);
+					}
+					else
+					{
+						visitor.examine_edge(*it, detail::edge_visitable::TREE_EDGE);
+						this->discover(next, visitor);
+						queue.push_back(next);
+					}
+				}
+				this->finish(v, visitor);
+			}
+		};
+
+		template <class Step, class Visitor>
+		void depth_first_impl(const vertex_id& source, Visitor& visitor, bool undirected)
+		{
+			struct frame
+			{
+				vertex_id vertex;
+				typename Step::edge_iterator it, it_end;
+				edge_id tree_edge; // edge the vertex was reached through (if 'has_tree_edge')
+				bool has_tree_edge;
+			};
+
+			std::vector<frame> stack;
+			std::vector<edge_id> loops; // UNDIRECTED self-loops seen once: they are listed twice among the edges of their vertex
+			frame first; first.vertex = source; first.has_tree_edge = false;
+			boost::tie(first.it, first.it_end) = Step::edges(source, _graph);
+			stack.push_back(first);
+			this->discover(source, visitor);
+			while (!stack.empty())
+			{
+				frame& top = stack.back();
+				if (top.it == top.it_end)
+				{
+					this->finish(top.vertex, visitor);
+					stack.pop_back();
+					continue;
+				}
+
+				const edge_id e = *top.it++;
+				if (undirected && top.has_tree_edge && e == top.tree_edge)
+				{
+					continue; // going back through the tree edge is not a back edge
+				}
+				const vertex_id next = Step::next(e, _graph);
+				switch (_labels[_chart.get_vertex_index(next)])
+				{
+					case detail::vertex_visitable::UNDISCOVERED:
+					{
+						visitor.examine_edge(e, detail::edge_visitable::TREE_EDGE);
+						frame child; child.vertex = next; child.tree_edge = e; child.has_tree_edge = true;
+						boost::tie(child.it, child.it_end) = Step::edges(next, _graph);
+						this->discover(next, visitor);
+						stack.push_back(child); // 'top' is invalidated
+						break;
+					}
+					case detail::vertex_visitable::DISCOVERED:
+						if (undirected && next == top.vertex)
+						{
+							const typename std::vector<edge_id>::iterator loop = std::find(loops.begin(), loops.end(), e);
+							if (loop != loops.end())
+							{
+								loops.erase(loop);
+								break;
+							}
+							loops.push_back(e);
+						}
+						visitor.examine_edge(e, detail::edge_visitable::BACK_EDGE);
+						break;
+					default:
+						if (!undirected) // else it was already reported as a BACK_EDGE from 'next'
+						{
+							visitor.examine_edge(e, detail::edge_visitable::FORWARD_OR_CROSS_EDGE);
+						}
+						break;
+				}
+			}
+		};
+
+		template <class Visitor>
+		void discover(const vertex_id& v, Visitor& visitor)
+		{
+			const std::size_t index = _chart.get_vertex_index(v);
+			_labels[index] = detail::vertex_visitable::DISCOVERED;
+			_reached.push_back(index);
+			visitor.discover_vertex(v);
+		};
+
+		template <class Visitor>
+		void finish(const vertex_id& v, Visitor& visitor)
+		{
+			_labels[_chart.get_vertex_index(v)] = detail::vertex_visitable::EXPLORED;
+			visitor.finish_vertex(v);
+		};
+
+	protected:
+		const Chart& _chart;
+		const _t_graph& _graph;
+		std::vector<unsigned char> _labels; // vertex_label by dense vertex index
+		std::vector<std::size_t> _reached;
+};
+
+}}
@@ -0,0 +1,436 @@
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <exception>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+namespace core { namespace graph { namespace detail {
+
+/*! Min-heap of dense indices [0, n) ordered by 'key[index]', with decrease-key. Every node
+    has 'Arity' children stored contiguously: with 4 they share a cache line and the tree is
+    half as deep as a binary one.
+*/
+template <class Key, std::size_t Arity = 4>
+class d_ary_heap
+{
+	public:
+		d_ary_heap(const std::vector<Key>& key) : _key(key), _position(key.size(), npos) {};
+
+		bool empty() const { return _heap.empty();};
+
+		void push_or_decrease(std::size_t index)
+		{
+			// 'key[index]' is new or has been decreased
+			std::size_t pos = _position[index];
+			if (pos == npos)
+			{
+				pos = _heap.size();
+				_heap.push_back(index);
+			}
+			this->sift_up(pos);
+		};
+
+		std::size_t pop()
+		{
+			const std::size_t top = _heap.front();
+			_position[top] = npos;
+			_heap.front() = _heap.back();
+			_heap.pop_back();
+			if (!_heap.empty())
+			{
+				this->sift_down(0);
+			}
+			return top;
+		};
+
+	protected:
+		void sift_up(std::size_t pos)
+		{
+			const std::size_t index = _heap[pos];
+			while (pos > 0)
+			{
+				const std::size_t parent = (pos - 1)/Arity;
+				if (!(_key[index] < _key[_heap[parent]]))
+				{
+					break;
+				}
+				this->place(_heap[parent], pos);
+				pos = parent;
+			}
+			this->place(index, pos);
+		};
+
+		void sift_down(std::size_t pos)
+		{
+			const std::size_t index = _heap[pos];
+			while (true)
+			{
+				const std::size_t first = Arity*pos + 1;
+				if (first >= _heap.size())
+				{
+					break;
+				}
+				const std::size_t last = std::min(first + Arity, _heap.size());
+				std::size_t child = first;
+				for (std::size_t c = first + 1; c < last; ++c)
+				{
+					if (_key[_heap[c]] < _key[_heap[child]])
+					{
+						child = c;
+					}
+				}
+				if (!(_key[_heap[child]] < _key[index]))
+				{
+					break;
+				}
+				this->place(_heap[child], pos);
+				pos = child;
+			}
+			this->place(index, pos);
+		};
+
+		void place(std::size_t index, std::size_t pos)
+		{
+			_heap[pos] = index;
+			_position[index] = pos;
+		};
+
+	protected:
+		static const std::size_t npos = std::size_t(-1);
+		const std::vector<Key>& _key;
+		std::vector<std::size_t> _heap;
+		std::vector<std::size_t> _position; // in '_heap', 'npos' if not there
+};
+
+template <class Key, std::size_t Arity>
+const std::size_t d_ary_heap<Key, Arity>::npos;
+
+
+/*! Single-source shortest paths over dense vertex indices [0, n_vertices), where
+    'for_each_out(v, f)' calls 'f(u, weight)' for every outgoing edge of 'v'. Weights
+    cannot be negative (std::runtime_error).
+
+    On return 'distance[v]' is the length of the shortest path from 'source' to 'v' and
+    'parent[v]' the previous vertex in it ('source' for itself), they are
+    numeric_limits<Distance>::max() and size_t(-1) for unreachable vertices. Returns the
+    number of vertices reached.
+*/
+template <class Distance, class ForEachOut>
+std::size_t dijkstra_shortest_paths(std::size_t n_vertices, std::size_t source, ForEachOut for_each_out,
+                                    std::vector<Distance>& distance, std::vector<std::size_t>& parent)
+{
+	distance.assign(n_vertices, std::numeric_limits<Distance>::max());
+	parent.assign(n_vertices, std::size_t(-1));
+	if (source >= n_vertices)
+	{
+		return 0;
+	}
+
+	d_ary_heap<Distance> queue(distance);
+	distance[source] = Distance();
+	parent[source] = source;
+	queue.push_or_decrease(source);
+	std::size_t reached = 0;
+	while (!queue.empty())
+	{
+		const std::size_t v = queue.pop();
+		++reached;
+		for_each_out(v, [&](std::size_t u, const Distance& weight)
+		{
+			if (weight < Distance())
+			{
+				throw std::runtime_error("Negative edge weight");
+			}
+			const Distance candidate = distance[v] + weight;
+			if (candidate < distance[u])
+			{
+				distance[u] = candidate;
+				parent[u] = v;
+				queue.push_or_decrease(u);
+			}
+		});
+	}
+	return reached;
+}
+
+
+/*! Cyclic array of buckets of dense indices: bucket 'b' lives in slot 'b % size'. Only the
+    buckets in ['first', 'first' + size) are held, so drained buckets give their storage
+    (and its capacity) to the following ones. Relaxing an edge reaches at most
+    'max_weight/delta' buckets ahead of the lowest one, which bounds the size, and the
+    ring never grows beyond 'max_slots': buckets further ahead wait in an unordered
+    'far' list until the ring gets close to them. So a tiny 'delta' against large weights
+    costs neither unbounded memory nor a scan of every bucket in between.
+*/
+class bucket_ring
+{
+	public:
+		enum { max_slots = 1024 }; // an enum: no definition needed out of the class (std::min takes references)
+
+	public:
+		bucket_ring() : _first(0), _far_min(std::size_t(-1)) {};
+
+		void push(std::size_t bucket, std::size_t index)
+		{
+			// 'bucket' >= 'first'
+			const std::size_t ahead = bucket - _first;
+			if (ahead >= _slots.size() && _slots.size() < max_slots)
+			{
+				this->grow(ahead + 1);
+			}
+			if (ahead < _slots.size())
+			{
+				_slots[bucket % _slots.size()].push_back(index);
+			}
+			else
+			{
+				_far.push_back(std::make_pair(bucket, index));
+				_far_min = std::min(_far_min, bucket);
+			}
+		};
+
+		std::vector<std::size_t>& operator[](std::size_t bucket)
+		{
+			// 'bucket' held by the ring: 'count(bucket)' > 0
+			return _slots[bucket % _slots.size()];
+		};
+
+		std::size_t count(std::size_t bucket) const
+		{
+			return (bucket >= _first && bucket - _first < _slots.size()) ? _slots[bucket % _slots.size()].size() : 0;
+		};
+
+		std::size_t lowest(std::size_t none) const
+		{
+			// Lowest non-empty bucket, a scan of at most 'max_slots'
+			for (std::size_t b = _first; b < _first + _slots.size(); ++b)
+			{
+				if (!_slots[b % _slots.size()].empty())
+				{
+					return b;
+				}
+			}
+			return _far.empty() ? none : _far_min;
+		};
+
+		void drop_below(std::size_t bucket)
+		{
+			/* Buckets below 'bucket' are empty and will not be filled again: the ring moves
+			   forwards, taking the buckets of the far list it reaches.
+			*/
+			_first = std::max(_first, bucket);
+			if (_far.empty() || _far_min - _first >= _slots.size())
+			{
+				return;
+			}
+			std::size_t kept = 0;
+			_far_min = std::size_t(-1);
+			for (std::size_t i = 0; i < _far.size(); ++i)
+			{
+				if (_far[i].first - _first < _slots.size())
+				{
+					_slots[_far[i].first % _slots.size()].push_back(_far[i].second);
+				}
+				else
+				{
+					_far_min = std::min(_far_min, _far[i].first);
+					_far[kept++] = _far[i];
+				}
+			}
+			_far.resize(kept);
+		};
+
+	protected:
+		void grow(std::size_t n)
+		{
+			std::vector<std::vector<std::size_t> > slots(std::min<std::size_t>(max_slots, std::max(n, 2*_slots.size())));
+			for (std::size_t b = _first; b < _first + _slots.size(); ++b)
+			{
+				slots[b % slots.size()].swap(_slots[b % _slots.size()]);
+			}
+			_slots.swap(slots);
+		};
+
+	protected:
+		std::vector<std::vector<std::size_t> > _slots;
+		std::size_t _first;
+		std::vector<std::pair<std::size_t, std::size_t> > _far; // (bucket, index) beyond the ring
+		std::size_t _far_min;
+};
+
+
+/*! Multi-threaded delta-stepping ('n_threads' = 0 uses all the cores), same interface and
+    results as 'dijkstra_shortest_paths' (parents may differ when there are several
+    shortest paths).
+
+    Vertices are kept in buckets of width 'delta' by tentative distance. All the vertices of
+    the lowest bucket are relaxed in parallel, those improved go back to the bucket of their
+    new distance (possibly the same one) until it empties, then the next bucket is taken.
+    A small 'delta' does little redundant work but exposes little parallelism; the average
+    edge weight is a reasonable start. Every thread holds about 'max_weight/delta' buckets
+    at a time, at most 'bucket_ring::max_slots' (see 'bucket_ring'), not one per bucket
+    ever reached.
+
+    An exception thrown by 'for_each_out' (the weight function) stops all the threads and
+    is rethrown here.
+*/
+template <class Distance, class ForEachOut>
+std::size_t delta_stepping_shortest_paths(std::size_t n_vertices, std::size_t source, ForEachOut for_each_out, const Distance& delta,
+                                          std::vector<Distance>& distance, std::vector<std::size_t>& parent, unsigned n_threads = 0)
+{
+	static const std::size_t no_bucket = std::size_t(-1);
+	static const std::size_t chunk = 64; // vertices of the bucket claimed at once
+	static const std::size_t n_locks = 4096;
+
+	if (!(Distance() < delta))
+	{
+		throw std::runtime_error("'delta' must be positive");
+	}
+	distance.assign(n_vertices, std::numeric_limits<Distance>::max());
+	parent.assign(n_vertices, std::size_t(-1));
+	if (source >= n_vertices)
+	{
+		return 0;
+	}
+
+	// Distances are read without locking to discard most of the relaxations early, but a
+	// distance and its parent are only written together, with the vertex locked.
+	std::vector<std::atomic<Distance> > tentative(n_vertices);
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		tentative[v].store(std::numeric_limits<Distance>::max(), std::memory_order_relaxed);
+	}
+	std::vector<std::atomic<bool> > locks(n_locks);
+	for (std::size_t l = 0; l < n_locks; ++l)
+	{
+		locks[l].store(false, std::memory_order_relaxed);
+	}
+
+	n_threads = resolve_threads(n_threads, n_vertices);
+	std::vector<bucket_ring> buckets(n_threads); // of every thread
+	std::vector<std::size_t> lowest(n_threads), offset(n_threads + 1);
+	std::vector<std::size_t> frontier(1, source);
+	std::atomic<std::size_t> next(0);
+	std::atomic<bool> negative(false), failed(false);
+	std::vector<std::exception_ptr> errors(n_threads);
+	std::size_t current = 0;
+	barrier sync(n_threads);
+
+	tentative[source].store(Distance(), std::memory_order_relaxed);
+	parent[source] = source;
+
+	parallel_for(n_threads, n_threads, [&](unsigned thread, std::size_t, std::size_t)
+	{
+		bucket_ring& mine = buckets[thread];
+		while (true)
+		{
+			try
+			{
+				for (std::size_t begin = next.fetch_add(chunk, std::memory_order_relaxed); begin < frontier.size() && !failed.load(std::memory_order_relaxed); begin = next.fetch_add(chunk, std::memory_order_relaxed))
+				{
+					const std::size_t end = std::min(frontier.size(), begin + chunk);
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						const std::size_t v = frontier[i];
+						const Distance from = tentative[v].load(std::memory_order_relaxed);
+						if (static_cast<std::size_t>(from/delta) < current)
+						{
+							continue; // improved since it was queued, already relaxed from a lower bucket
+						}
+						for_each_out(v, [&](std::size_t u, const Distance& weight)
+						{
+							if (weight < Distance())
+							{
+								negative.store(true, std::memory_order_relaxed);
+								return;
+							}
+							const Distance candidate = from + weight;
+							if (!(candidate < tentative[u].load(std::memory_order_relaxed)))
+							{
+								return;
+							}
+							std::atomic<bool>& lock = locks[u % n_locks];
+							while (lock.exchange(true, std::memory_order_acquire)) {}
+							const bool improved = (candidate < tentative[u].load(std::memory_order_relaxed));
+							if (improved)
+							{
+								tentative[u].store(candidate, std::memory_order_relaxed);
+								parent[u] = v;
+							}
+							lock.store(false, std::memory_order_release);
+							if (improved)
+							{
+								mine.push(static_cast<std::size_t>(candidate/delta), u);
+							}
+						});
+					}
+				}
+			}
+			catch (...)
+			{
+				// The other threads stop at their next chunk, everybody leaves at the next phase
+				errors[thread] = std::current_exception();
+				failed.store(true, std::memory_order_relaxed);
+			}
+			lowest[thread] = mine.lowest(no_bucket);
+			sync.wait();
+
+			if (thread == 0)
+			{
+				current = failed.load(std::memory_order_relaxed) ? no_bucket : *std::min_element(lowest.begin(), lowest.end());
+				if (current != no_bucket)
+				{
+					// Buckets below 'current' cannot be filled anymore: distances only grow from there
+					for (std::size_t t = 0; t < n_threads; ++t)
+					{
+						buckets[t].drop_below(current);
+						offset[t + 1] = offset[t] + buckets[t].count(current);
+					}
+					frontier.resize(offset[n_threads]);
+					next.store(0, std::memory_order_relaxed);
+				}
+			}
+			sync.wait();
+
+			if (current == no_bucket)
+			{
+				break;
+			}
+			if (mine.count(current))
+			{
+				std::copy(mine[current].begin(), mine[current].end(), frontier.begin() + offset[thread]);
+				mine[current].clear();
+			}
+			sync.wait();
+		}
+	});
+
+	for (unsigned t = 0; t < n_threads; ++t)
+	{
+		if (errors[t])
+		{
+			std::rethrow_exception(errors[t]);
+		}
+	}
+	if (negative.load())
+	{
+		throw std::runtime_error("Negative edge weight");
+	}
+	std::size_t reached = 0;
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		distance[v] = tentative[v].load(std::memory_order_relaxed);
+		reached += (parent[v] != std::size_t(-1));
+	}
+	return reached;
+}
+
+}}}
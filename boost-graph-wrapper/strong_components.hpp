@@ -0,0 +1,500 @@
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+namespace core { namespace graph { namespace detail {
+
+/*! Outgoing adjacency of the dense vertex indices [0, n) in compressed-sparse-row form:
+    the targets of the edges of 'v' are 'targets[offsets[v]]'..'targets[offsets[v + 1]]'.
+    It is built from 'for_each_out(v, f)', calling 'f(u)' for the target of every outgoing
+    edge of 'v' (see 'parallel_direction_optimizing_bfs'), so that algorithms can stop and
+    resume the iteration over the edges of a vertex.
+*/
+struct dense_adjacency
+{
+	std::vector<std::size_t> offsets;
+	std::vector<std::size_t> targets;
+
+	std::size_t num_vertices() const { return offsets.empty() ? 0 : offsets.size() - 1;};
+	const std::size_t* begin(std::size_t v) const { return targets.data() + offsets[v];};
+	const std::size_t* end(std::size_t v) const { return targets.data() + offsets[v + 1];};
+
+	template <class ForEachOut>
+	void build(std::size_t n_vertices, ForEachOut for_each_out, unsigned n_threads = 1)
+	{
+		offsets.assign(n_vertices + 1, 0);
+		parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+		{
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				std::size_t degree = 0;
+				for_each_out(v, [&degree](std::size_t) { ++degree;});
+				offsets[v + 1] = degree;
+			}
+		});
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		targets.resize(offsets.back());
+		parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+		{
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				std::size_t position = offsets[v];
+				for_each_out(v, [&](std::size_t u) { targets[position++] = u;});
+			}
+		});
+	};
+
+	dense_adjacency transposed(unsigned n_threads = 1) const
+	{
+		// Incoming adjacency, sources in any order
+		const std::size_t n_vertices = this->num_vertices();
+		std::vector<std::atomic<std::size_t> > cursor(n_vertices + 1);
+		for (std::size_t v = 0; v <= n_vertices; ++v)
+		{
+			cursor[v].store(0, std::memory_order_relaxed);
+		}
+		parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+		{
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				for (const std::size_t* u = this->begin(v); u != this->end(v); ++u)
+				{
+					cursor[*u + 1].fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+
+		dense_adjacency result;
+		result.offsets.resize(n_vertices + 1);
+		result.offsets[0] = 0;
+		for (std::size_t v = 0; v < n_vertices; ++v)
+		{
+			result.offsets[v + 1] = result.offsets[v] + cursor[v + 1].load(std::memory_order_relaxed);
+			cursor[v].store(result.offsets[v], std::memory_order_relaxed);
+		}
+
+		result.targets.resize(targets.size());
+		parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+		{
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				for (const std::size_t* u = this->begin(v); u != this->end(v); ++u)
+				{
+					result.targets[cursor[*u].fetch_add(1, std::memory_order_relaxed)] = v;
+				}
+			}
+		});
+		return result;
+	};
+};
+
+
+/*! Tarjan's strongly connected components over 'graph', ignoring the vertices for which
+    'skip(v)' is true (and the edges to them). The depth-first search keeps its own stack
+    of (vertex, next edge), so deep graphs cannot overflow the call stack.
+
+    'emit(begin, end)' is called with the vertices of every component as soon as it is
+    complete, which happens in reverse topological order: when an edge goes from a component
+    to another one, the second is emitted first.
+*/
+template <class Skip, class Emit>
+void tarjan_components(const dense_adjacency& graph, Skip skip, Emit emit)
+{
+	static const std::size_t unvisited = std::size_t(-1);
+	const std::size_t n_vertices = graph.num_vertices();
+	std::vector<std::size_t> index(n_vertices, unvisited), low(n_vertices);
+	std::vector<char> on_stack(n_vertices, 0);
+	std::vector<std::size_t> stack; // vertices of the components not yet complete
+	std::vector<std::pair<std::size_t, const std::size_t*> > path; // depth-first search: vertex and its next edge
+	std::size_t next_index = 0;
+
+	for (std::size_t root = 0; root < n_vertices; ++root)
+	{
+		if (index[root] != unvisited || skip(root))
+		{
+			continue;
+		}
+
+		index[root] = low[root] = next_index++;
+		stack.push_back(root);
+		on_stack[root] = 1;
+		path.push_back(std::make_pair(root, graph.begin(root)));
+		while (!path.empty())
+		{
+			const std::size_t v = path.back().first;
+			if (path.back().second != graph.end(v))
+			{
+				const std::size_t u = *path.back().second++;
+				if (index[u] == unvisited)
+				{
+					if (!skip(u))
+					{
+						index[u] = low[u] = next_index++;
+						stack.push_back(u);
+						on_stack[u] = 1;
+						path.push_back(std::make_pair(u, graph.begin(u)));
+					}
+				}
+				else if (on_stack[u])
+				{
+					low[v] = std::min(low[v], index[u]);
+				}
+				continue;
+			}
+
+			path.pop_back();
+			if (!path.empty())
+			{
+				const std::size_t parent = path.back().first;
+				low[parent] = std::min(low[parent], low[v]);
+			}
+			if (low[v] == index[v])
+			{
+				// 'v' is the root of a component: everything above it in the stack
+				std::size_t first = stack.size();
+				do
+				{
+					on_stack[stack[--first]] = 0;
+				} while (stack[first] != v);
+				emit(stack.data() + first, stack.data() + stack.size());
+				stack.resize(first);
+			}
+		}
+	}
+}
+
+/*! Strongly connected components of the dense vertex indices [0, n_vertices), see
+    'dense_adjacency' for 'for_each_out' (the adjacency is copied there first). On return
+    'component[v]' is the component of 'v', numbered in reverse topological order: an edge
+    between two components goes from the higher number to the lower one. Returns the number
+    of components.
+*/
+template <class ForEachOut>
+std::size_t strong_components(std::size_t n_vertices, ForEachOut for_each_out, std::vector<std::size_t>& component)
+{
+	dense_adjacency graph;
+	graph.build(n_vertices, for_each_out);
+	component.assign(n_vertices, 0);
+	std::size_t n_components = 0;
+	tarjan_components(graph, [](std::size_t) { return false;}, [&](const std::size_t* begin, const std::size_t* end)
+	{
+		for (const std::size_t* v = begin; v != end; ++v)
+		{
+			component[*v] = n_components;
+		}
+		++n_components;
+	});
+	return n_components;
+}
+
+/*! Topological order of the dense vertex indices [0, n_vertices) (Kahn): every edge goes
+    from a vertex to a later one. The result is the same for every run. Returns false if
+    there are cycles, then 'order' only holds the vertices that are neither in a cycle nor
+    reachable from one.
+*/
+template <class ForEachOut>
+bool topological_order(std::size_t n_vertices, ForEachOut for_each_out, std::vector<std::size_t>& order)
+{
+	std::vector<std::size_t> in_degree(n_vertices, 0);
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		for_each_out(v, [&in_degree](std::size_t u) { ++in_degree[u];});
+	}
+
+	order.clear();
+	order.reserve(n_vertices);
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		if (in_degree[v] == 0)
+		{
+			order.push_back(v);
+		}
+	}
+	for (std::size_t head = 0; head < order.size(); ++head)
+	{
+		const std::size_t v = order[head];
+		for_each_out(v, [&](std::size_t u)
+		{
+			if (--in_degree[u] == 0)
+			{
+				order.push_back(u);
+			}
+		});
+	}
+	return order.size() == n_vertices;
+}
+
+
+/*! Level-synchronous expansion of 'frontier': 'visit(v, push)' is called once for every
+    vertex of a level and 'push(u)' adds 'u' to the next one ('visit' must claim 'u' first,
+    so that it is only pushed once). Small levels are run by the calling thread: long paths
+    do not pay a round of threads per vertex.
+*/
+template <class Visit>
+void parallel_expand(std::vector<std::size_t>& frontier, unsigned n_threads, Visit visit)
+{
+	static const std::size_t min_parallel_level = 1024;
+	std::vector<std::size_t> next;
+	while (!frontier.empty())
+	{
+		if (frontier.size() < min_parallel_level || resolve_threads(n_threads, frontier.size()) == 1)
+		{
+			next.clear();
+			for (std::size_t i = 0; i < frontier.size(); ++i)
+			{
+				visit(frontier[i], [&next](std::size_t u) { next.push_back(u);});
+			}
+			frontier.swap(next);
+			continue;
+		}
+
+		std::vector<std::vector<std::size_t> > found(resolve_threads(n_threads, frontier.size()));
+		parallel_for(frontier.size(), static_cast<unsigned>(found.size()), [&](unsigned thread, std::size_t begin, std::size_t end)
+		{
+			std::vector<std::size_t>& mine = found[thread];
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				visit(frontier[i], [&mine](std::size_t u) { mine.push_back(u);});
+			}
+		});
+		frontier.clear();
+		for (std::size_t t = 0; t < found.size(); ++t)
+		{
+			frontier.insert(frontier.end(), found[t].begin(), found[t].end());
+		}
+	}
+}
+
+/*! Multi-threaded strongly connected components ('n_threads' = 0 uses all the cores), in
+    the steps of Multistep (Slota, Rajamanickam and Madduri, IPDPS 2014):
+      1. Trimming: vertices with no incoming or no outgoing edge left are components by
+         themselves, removing them may expose more.
+      2. Forward-backward from the vertex with the highest in*out degree: the vertices it
+         reaches that also reach it are its component, usually the giant one.
+      3. Coloring: every vertex takes the highest index that reaches it, each vertex whose
+         color is its own index collects its component backwards through its color. Rounds
+         go on while they make progress.
+      4. Whatever is left (less than 'serial_threshold' vertices or a round removing too
+         few) goes to Tarjan, see 'tarjan_components'.
+    See 'dense_adjacency' for 'for_each_out', the incoming adjacency is built from it.
+
+    The components are the same as those of 'strong_components' but numbered in order of
+    their first vertex (as 'parallel_connected_components'), whatever the number of
+    threads. Returns the number of components.
+*/
+template <class ForEachOut>
+std::size_t parallel_strong_components(std::size_t n_vertices, ForEachOut for_each_out, std::vector<std::size_t>& component, unsigned n_threads = 0)
+{
+	static const std::size_t unassigned = std::size_t(-1);
+	static const std::size_t serial_threshold = 100000;
+	n_threads = resolve_threads(n_threads, n_vertices);
+
+	dense_adjacency forwards;
+	forwards.build(n_vertices, for_each_out, n_threads);
+	const dense_adjacency backwards = forwards.transposed(n_threads);
+
+	// Representative of the component of every vertex, 'unassigned' while it is still in the graph
+	std::vector<std::atomic<std::size_t> > label(n_vertices);
+	std::vector<std::atomic<std::size_t> > in_count(n_vertices), out_count(n_vertices); // edges from/to other vertices still in the graph
+	std::vector<std::atomic<unsigned char> > mark(n_vertices);
+	std::vector<std::atomic<std::size_t> > color(n_vertices); // highest vertex reaching each one (coloring)
+	auto claim = [&label](std::size_t v, std::size_t representative)
+	{
+		std::size_t expected = unassigned;
+		return label[v].compare_exchange_strong(expected, representative, std::memory_order_relaxed);
+	};
+	auto alive = [&label](std::size_t v) { return label[v].load(std::memory_order_relaxed) == unassigned;};
+	auto gather = [&](auto select)
+	{
+		// Vertices satisfying 'select', in index order
+		std::vector<std::vector<std::size_t> > found(n_threads);
+		parallel_for(n_vertices, n_threads, [&](unsigned thread, std::size_t begin, std::size_t end)
+		{
+			for (std::size_t v = begin; v < end; ++v)
+			{
+				if (select(v))
+				{
+					found[thread].push_back(v);
+				}
+			}
+		});
+		std::vector<std::size_t> result;
+		for (unsigned t = 0; t < n_threads; ++t)
+		{
+			result.insert(result.end(), found[t].begin(), found[t].end());
+		}
+		return result;
+	};
+
+	// 1. Trimming
+	parallel_for(n_vertices, n_threads, [&](unsigned, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t v = begin; v < end; ++v)
+		{
+			label[v].store(unassigned, std::memory_order_relaxed);
+			mark[v].store(0, std::memory_order_relaxed);
+			color[v].store(v, std::memory_order_relaxed);
+			in_count[v].store(std::count_if(backwards.begin(v), backwards.end(v), [v](std::size_t u) { return u != v;}), std::memory_order_relaxed);
+			out_count[v].store(std::count_if(forwards.begin(v), forwards.end(v), [v](std::size_t u) { return u != v;}), std::memory_order_relaxed);
+		}
+	});
+	std::vector<std::size_t> frontier = gather([&](std::size_t v)
+	{
+		return (in_count[v].load(std::memory_order_relaxed) == 0 || out_count[v].load(std::memory_order_relaxed) == 0) && claim(v, v);
+	});
+	parallel_expand(frontier, n_threads, [&](std::size_t v, auto push)
+	{
+		for (const std::size_t* u = forwards.begin(v); u != forwards.end(v); ++u)
+		{
+			if (*u != v && in_count[*u].fetch_sub(1, std::memory_order_relaxed) == 1 && claim(*u, *u))
+			{
+				push(*u);
+			}
+		}
+		for (const std::size_t* u = backwards.begin(v); u != backwards.end(v); ++u)
+		{
+			if (*u != v && out_count[*u].fetch_sub(1, std::memory_order_relaxed) == 1 && claim(*u, *u))
+			{
+				push(*u);
+			}
+		}
+	});
+
+	// 2. Forward-backward from the pivot
+	std::vector<std::size_t> remaining = gather(alive);
+	if (!remaining.empty())
+	{
+		std::size_t pivot = remaining.front(), best = 0;
+		for (std::vector<std::size_t>::const_iterator v = remaining.begin(); v != remaining.end(); ++v)
+		{
+			const std::size_t score = in_count[*v].load(std::memory_order_relaxed)*out_count[*v].load(std::memory_order_relaxed);
+			if (score > best)
+			{
+				best = score;
+				pivot = *v;
+			}
+		}
+
+		mark[pivot].store(1, std::memory_order_relaxed);
+		frontier.assign(1, pivot);
+		parallel_expand(frontier, n_threads, [&](std::size_t v, auto push)
+		{
+			for (const std::size_t* u = forwards.begin(v); u != forwards.end(v); ++u)
+			{
+				if (alive(*u) && mark[*u].exchange(1, std::memory_order_relaxed) == 0)
+				{
+					push(*u);
+				}
+			}
+		});
+
+		// The vertices of the component reach the pivot through vertices of the component
+		claim(pivot, pivot);
+		frontier.assign(1, pivot);
+		parallel_expand(frontier, n_threads, [&](std::size_t v, auto push)
+		{
+			for (const std::size_t* u = backwards.begin(v); u != backwards.end(v); ++u)
+			{
+				if (mark[*u].load(std::memory_order_relaxed) && claim(*u, pivot))
+				{
+					push(*u);
+				}
+			}
+		});
+		remaining = gather(alive);
+	}
+
+	// 3. Coloring
+	while (remaining.size() > serial_threshold)
+	{
+		for (std::vector<std::size_t>::const_iterator v = remaining.begin(); v != remaining.end(); ++v)
+		{
+			color[*v].store(*v);
+			mark[*v].store(1); // queued
+		}
+
+		// Highest colors flow forwards; 'v' is queued again whenever its color grows after it was read
+		frontier = remaining;
+		parallel_expand(frontier, n_threads, [&](std::size_t v, auto push)
+		{
+			mark[v].store(0);
+			const std::size_t c = color[v].load();
+			for (const std::size_t* u = forwards.begin(v); u != forwards.end(v); ++u)
+			{
+				if (!alive(*u))
+				{
+					continue;
+				}
+				std::size_t current = color[*u].load();
+				while (current < c && !color[*u].compare_exchange_weak(current, c)) {}
+				if (current < c && mark[*u].exchange(1) == 0)
+				{
+					push(*u);
+				}
+			}
+		});
+
+		// Every root collects backwards the vertices of its color that reach it
+		frontier.clear();
+		for (std::vector<std::size_t>::const_iterator v = remaining.begin(); v != remaining.end(); ++v)
+		{
+			if (color[*v].load(std::memory_order_relaxed) == *v && claim(*v, *v))
+			{
+				frontier.push_back(*v);
+			}
+		}
+		parallel_expand(frontier, n_threads, [&](std::size_t v, auto push)
+		{
+			const std::size_t c = color[v].load(std::memory_order_relaxed);
+			for (const std::size_t* u = backwards.begin(v); u != backwards.end(v); ++u)
+			{
+				if (color[*u].load(std::memory_order_relaxed) == c && claim(*u, c))
+				{
+					push(*u);
+				}
+			}
+		});
+
+		const std::size_t before = remaining.size();
+		remaining = gather(alive);
+		if (16*(before - remaining.size()) < before)
+		{
+			break; // too little progress (long chains of components), Tarjan does it in one pass
+		}
+	}
+
+	// 4. The rest
+	tarjan_components(forwards, [&](std::size_t v) { return !alive(v);}, [&](const std::size_t* begin, const std::size_t* end)
+	{
+		for (const std::size_t* v = begin; v != end; ++v)
+		{
+			label[*v].store(*begin, std::memory_order_relaxed);
+		}
+	});
+
+	// Number components in order of their first vertex
+	std::vector<std::size_t> number(n_vertices, unassigned);
+	std::size_t n_components = 0;
+	component.resize(n_vertices);
+	for (std::size_t v = 0; v < n_vertices; ++v)
+	{
+		std::size_t& label_number = number[label[v].load(std::memory_order_relaxed)];
+		if (label_number == unassigned)
+		{
+			label_number = n_components++;
+		}
+		component[v] = label_number;
+	}
+	return n_components;
+}
+
+}}}
@@ -1,6 +1,15 @@
 
 #pragma once
 
+/*! Empty base optimization for every empty base class, MSVC only applies it to the first
+    one by default.
+*/
+#if defined(_MSC_VER)
+#define CORE_GRAPH_EMPTY_BASES __declspec(empty_bases)
+#else
+#define CORE_GRAPH_EMPTY_BASES
+#endif
+
 namespace core { namespace graph {
 
     /*! Behavoiour policies define the way vertex and edges can be assembled:
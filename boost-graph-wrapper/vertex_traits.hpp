@@ -7,6 +7,7 @@
 
 #include "traits.hpp"
 #include "edge_traits.hpp"
+#include "flat_set.hpp"
 
 namespace core { namespace graph { namespace detail {
 
@@ -15,19 +16,19 @@ namespace core { namespace graph { namespace detail {
 *************/
 namespace _impl
 {
-	template <class EdgeType>
+	template <class EdgeType, class EdgeSet>
 	class vertex_connected
 	{
+		/*! Edges are stored according to the 'EdgeSet' policy (see flat_set.hpp).
+
+		    'append_*' and 'erase_*' are not virtual: 'edge_connected' calls them through
+		    the concrete vertex type it is templated on, so they are resolved statically
+		    (and inlined) by every behaviour below. There is no CRTP base on purpose: the
+		    edge already names the concrete type, a 'Derived' parameter here would only
+		    repeat it in every vertex.
+		*/
 		public:
-			typedef typename std::set<EdgeType*> _t_edges;
-			virtual ~vertex_connected() {};
-
-		protected:
-			virtual void erase_incoming(EdgeType* ptr) = 0;
-			virtual void erase_outgoing(EdgeType* ptr) = 0;
-
-			virtual void append_incoming(EdgeType* ptr) = 0;
-			virtual void append_outgoing(EdgeType* ptr) = 0;
+			typedef typename edge_set_gen<EdgeSet, EdgeType*>::type _t_edges;
 
 		protected:
 			//static const int IsVertexConnected;
@@ -35,18 +36,19 @@ namespace _impl
 
 }
 
-template <class EdgeType, int Behaviour>
+template <class EdgeType, int Behaviour, class EdgeSet=ordered_edge_set>
 class vertex_connected;
 
-template <class EdgeType>
-class vertex_connected<EdgeType, UNDIRECTED> : public _impl::vertex_connected<EdgeType>
+template <class EdgeType, class EdgeSet>
+class vertex_connected<EdgeType, UNDIRECTED, EdgeSet> : public _impl::vertex_connected<EdgeType, EdgeSet>
 {
 		template<class V, class E> friend class _impl::edge_connected; // C++11 standard compliant
 	public:
+		typedef typename _impl::vertex_connected<EdgeType, EdgeSet>::_t_edges _t_edges;
 		static const int IsVertexConnected = UNDIRECTED;
 
 	public:
-		virtual ~vertex_connected()
+		~vertex_connected()
 		{
 			/*! \todo TODO: weird memory problem
 			while(_edges.size())
@@ -57,24 +59,25 @@ class vertex_connected<EdgeType, UNDIRECTED> : public _impl::vertex_connected<Ed
 		};
 
 		const _t_edges& get_edges() const {return _edges;};
+		std::size_t get_edges_heap_bytes() const { return heap_bytes(_edges);};
 
 	protected:
-		virtual void erase_incoming(EdgeType* ptr)
+		void erase_incoming(EdgeType* ptr)
 		{
 			_edges.erase(ptr);
 		};
 
-		virtual void erase_outgoing(EdgeType* ptr)
+		void erase_outgoing(EdgeType* ptr)
 		{
 			_edges.erase(ptr);
 		};
 
-		virtual void append_incoming(EdgeType* ptr)
+		void append_incoming(EdgeType* ptr)
 		{
 			_edges.insert(ptr);
 		};
 
-		virtual void append_outgoing(EdgeType* ptr)
+		void append_outgoing(EdgeType* ptr)
 		{
 			_edges.insert(ptr);
 		};
@@ -84,15 +87,16 @@ class vertex_connected<EdgeType, UNDIRECTED> : public _impl::vertex_connected<Ed
 };
 
 
-template <class EdgeType>
-class vertex_connected<EdgeType, DIRECTED> : public _impl::vertex_connected<EdgeType>
+template <class EdgeType, class EdgeSet>
+class vertex_connected<EdgeType, DIRECTED, EdgeSet> : public _impl::vertex_connected<EdgeType, EdgeSet>
 {
 		template<class V, class E> friend class _impl::edge_connected; // C++11 standard compliant
 	public:
+		typedef typename _impl::vertex_connected<EdgeType, EdgeSet>::_t_edges _t_edges;
 		static const int IsVertexConnected = DIRECTED;
 
 	public:
-		virtual ~vertex_connected()
+		~vertex_connected()
 		{
 			/*! \todo TODO: weird memory problem
 			while(_out_edges.size())
@@ -103,34 +107,47 @@ class vertex_connected<EdgeType, DIRECTED> : public _impl::vertex_connected<Edge
 		};
 
 		const _t_edges& get_outgoing() const {return _out_edges;};
+		// Not part of the DIRECTED chart API: lets 'remove_vertex' find the incoming edges without a scan
+		const _t_edges& get_incoming() const {return _in_edges;};
+		std::size_t get_edges_heap_bytes() const { return heap_bytes(_in_edges) + heap_bytes(_out_edges);};
 
 	protected:
-		virtual void erase_incoming(EdgeType* ptr) { /* not for DIRECTED graphs */ };
-		virtual void erase_outgoing(EdgeType* ptr)
+		void erase_incoming(EdgeType* ptr)
+		{
+			_in_edges.erase(ptr);
+		};
+
+		void erase_outgoing(EdgeType* ptr)
 		{
 			_out_edges.erase(ptr);
 		};
 
-		virtual void append_incoming(EdgeType* ptr) { /* not for DIRECTED graphs */ };
-		virtual void append_outgoing(EdgeType* ptr)
+		void append_incoming(EdgeType* ptr)
+		{
+			_in_edges.insert(ptr);
+		};
+
+		void append_outgoing(EdgeType* ptr)
 		{
 			_out_edges.insert(ptr);
 		};
 
 	protected:
+		_t_edges _in_edges;
 		_t_edges _out_edges;
 };
 
 
-template <class EdgeType>
-class vertex_connected<EdgeType, BIDIRECTIONAL> : public _impl::vertex_connected<EdgeType>
+template <class EdgeType, class EdgeSet>
+class vertex_connected<EdgeType, BIDIRECTIONAL, EdgeSet> : public _impl::vertex_connected<EdgeType, EdgeSet>
 {
 		template<class V, class E> friend class _impl::edge_connected; // C++11 standard compliant
 	public:
+		typedef typename _impl::vertex_connected<EdgeType, EdgeSet>::_t_edges _t_edges;
 		static const int IsVertexConnected = BIDIRECTIONAL;
 
 	public:
-		virtual ~vertex_connected()
+		~vertex_connected()
 		{
 			/*! \todo TODO: weird memory problem
 			while(_out_edges.size())
@@ -146,13 +163,14 @@ class vertex_connected<EdgeType, BIDIRECTIONAL> : public _impl::vertex_connected
 
 		const _t_edges& get_incoming() const {return _in_edges;};
 		const _t_edges& get_outgoing() const {return _out_edges;};
+		std::size_t get_edges_heap_bytes() const { return heap_bytes(_in_edges) + heap_bytes(_out_edges);};
 
 	protected:
-		virtual void erase_incoming(EdgeType* ptr) { _in_edges.erase(ptr);};
-		virtual void erase_outgoing(EdgeType* ptr) { _out_edges.erase(ptr);};
+		void erase_incoming(EdgeType* ptr) { _in_edges.erase(ptr);};
+		void erase_outgoing(EdgeType* ptr) { _out_edges.erase(ptr);};
 
-		virtual void append_incoming(EdgeType* ptr) { _in_edges.insert(ptr);};
-		virtual void append_outgoing(EdgeType* ptr) { _out_edges.insert(ptr);};
+		void append_incoming(EdgeType* ptr) { _in_edges.insert(ptr);};
+		void append_outgoing(EdgeType* ptr) { _out_edges.insert(ptr);};
 
 	protected:
 		_t_edges _in_edges, _out_edges;
@@ -183,8 +201,6 @@ struct test_type_connection
 /*************
 *   MULTICHART
 *************/
-class chart_base;
-
 template <class Chart>
 class vertex_multichart
 {
@@ -194,14 +210,17 @@ class vertex_multichart
 		const _t_charts& get_charts() const { return _charts;};
 
 	protected:
-		void insert_chart(chart_base* chart)
+		// 'chart' is the most derived 'core::graph::chart', 'Chart' is either the same or derived from it
+		template <class ChartType>
+		void insert_chart(ChartType* chart)
 		{
-			_charts.insert(dynamic_cast<Chart*>(chart));
+			_charts.insert(static_cast<Chart*>(chart));
 		};
 
-		void erase_chart(chart_base* chart)
+		template <class ChartType>
+		void erase_chart(ChartType* chart)
 		{
-			_charts.erase(dynamic_cast<Chart*>(chart));
+			_charts.erase(static_cast<Chart*>(chart));
 		};
 
 	protected:
@@ -210,7 +229,14 @@ class vertex_multichart
 };
 
 template <>
-class vertex_multichart<void> {};
+class vertex_multichart<void>
+{
+	// Vertices that do not keep track of their charts
+		template <class VertexType, class EdgeType, int Behaviour> friend class chart_impl;
+	protected:
+		template <class ChartType> void insert_chart(ChartType*) {};
+		template <class ChartType> void erase_chart(ChartType*) {};
+};
 
 // SFINAE test for vertex_multichart
 template <typename T> struct is_vertex_multichart
@@ -302,33 +328,101 @@ class vertex_visitable
 		_e_visitor_labels _label;
 };
 
+template <bool Enabled>
+class optional_vertex_visitable : public vertex_visitable {};
+
+template <>
+class optional_vertex_visitable<false> {};
+
 
 /*************
 *   VERTEX
 *************/            
-template <class EdgeType, int Behaviour, class Graph=void, class Inner=void>
-class vertex : public detail::vertex_connected<EdgeType, Behaviour>,
+template <class EdgeType, int Behaviour, class Graph=void, class Inner=void, class EdgeSet=ordered_edge_set>
+class vertex : public detail::vertex_connected<EdgeType, Behaviour, EdgeSet>,
                public detail::vertex_multichart<Graph>,
                public detail::vertex_inner<Inner>,
                public detail::vertex_visitable
 {
 	public:
-		vertex(inner_type_ptr obj) : detail::vertex_inner<Inner>(obj) {};
+		vertex(typename detail::vertex_inner<Inner>::inner_type_ptr obj) : detail::vertex_inner<Inner>(obj) {};
 		virtual ~vertex() {};
 
 };
 
 // Specialization not requesting 'inner' instance on constructor
-template <class EdgeType, int Behaviour, class Graph>
-class vertex<EdgeType, Behaviour, Graph, void> : public detail::vertex_connected<EdgeType, Behaviour>,
-                                                 public detail::vertex_multichart<Graph>,
-                                                 public detail::vertex_inner<void>, // void impl
-                                                 public detail::vertex_visitable
+template <class EdgeType, int Behaviour, class Graph, class EdgeSet>
+class vertex<EdgeType, Behaviour, Graph, void, EdgeSet> : public detail::vertex_connected<EdgeType, Behaviour, EdgeSet>,
+                                                          public detail::vertex_multichart<Graph>,
+                                                          public detail::vertex_inner<void>, // void impl
+                                                          public detail::vertex_visitable
 {
 	public:
 		vertex() {};
 		virtual ~vertex() {};
 };
 
+
+/*************
+*   COMPACT VERTEX
+*************/
+/*! Policy-based alternative to 'vertex' for big charts: every feature costs nothing unless
+    it is selected, there is no vtable and edges are stored in a 'flat_edge_set' by default.
+      - Graph: chart type to keep track of the charts of the vertex (std::set), 'void' for none.
+      - Inner: inner object (shared_ptr), 'void' for none.
+      - EdgeSet: storage policy for the edges of the vertex (see flat_set.hpp).
+      - Visitable: in-object visitation label (see 'vertex_visitable').
+    Unused features are empty base classes, so they take no room (EBO). The destructor is not
+    virtual: vertices are owned through shared_ptr created for the concrete type.
+*/
+template <class EdgeType, int Behaviour, class Graph=void, class Inner=void, class EdgeSet=flat_edge_set<2>, bool Visitable=false>
+class CORE_GRAPH_EMPTY_BASES compact_vertex : public detail::vertex_connected<EdgeType, Behaviour, EdgeSet>,
+                                              public detail::vertex_multichart<Graph>,
+                                              public detail::vertex_inner<Inner>,
+                                              public detail::optional_vertex_visitable<Visitable>
+{
+	public:
+		compact_vertex(typename detail::vertex_inner<Inner>::inner_type_ptr obj) : detail::vertex_inner<Inner>(obj) {};
+};
+
+// Specialization not requesting 'inner' instance on constructor
+template <class EdgeType, int Behaviour, class Graph, class EdgeSet, bool Visitable>
+class CORE_GRAPH_EMPTY_BASES compact_vertex<EdgeType, Behaviour, Graph, void, EdgeSet, Visitable> : public detail::vertex_connected<EdgeType, Behaviour, EdgeSet>,
+                                                                                                     public detail::vertex_multichart<Graph>,
+                                                                                                     public detail::vertex_inner<void>,
+                                                                                                     public detail::optional_vertex_visitable<Visitable>
+{
+	public:
+		compact_vertex() {};
+};
+
+
+/*************
+*   SIZE BUDGETS
+*************/
+namespace _impl { namespace budget
+{
+	/*! Memory taken by the smallest vertices and edges, checked at compile time so that
+	    a change in any of the mixins does not silently grow every element of a chart.
+	*/
+	struct edge;
+	struct vertex : compact_vertex<edge, DIRECTED, void, void, flat_edge_set<1> > {};
+	struct edge : compact_edge<vertex, edge, DIRECTED> {};
+
+	struct chart;
+	struct chart_edge;
+	struct chart_vertex : compact_vertex<chart_edge, BIDIRECTIONAL, void, void, flat_edge_set<2> > {};
+	struct chart_edge : compact_edge<chart_vertex, chart_edge, BIDIRECTIONAL, chart> {};
+
+	// Flat edge set: data pointer, size and capacity (32 bits each), inline slots
+	static_assert(sizeof(small_flat_set<edge*, 1>) == 2*sizeof(void*) + 8, "small_flat_set<T*, 1> exceeds its budget");
+	static_assert(sizeof(vertex) == 2*sizeof(small_flat_set<edge*, 1>), "compact_vertex<DIRECTED> must only hold its incoming and outgoing edges");
+	static_assert(sizeof(chart_vertex) == 2*sizeof(small_flat_set<chart_edge*, 2>), "compact_vertex<BIDIRECTIONAL> must only hold its incoming and outgoing edges");
+
+	// Source and target, plus chart pointer and index when the edge knows its chart
+	static_assert(sizeof(edge) == 2*sizeof(void*), "compact_edge must only hold its source and target");
+	static_assert(sizeof(chart_edge) == 3*sizeof(void*) + sizeof(std::size_t), "compact_edge with chart exceeds its budget");
+}}
+
 }}}
 
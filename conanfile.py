@@ -12,11 +12,13 @@ class BoostGraphWrapperConan(ConanFile):
     options = {"shared": [True, False]}
     default_options = "shared=False"
     generators = "cmake"
-    exports = "conanfile.py", "CMakeLists.txt", "boost-graph-wrapper/*", "tests/*"
+    exports = "conanfile.py", "CMakeLists.txt", "boost-graph-wrapper/*", "tests/*", "bench/*"
 
     def requirements(self):
         self.requires.add("Boost/1.60.0@lasote/stable")
         self.requires.add("spdlog/0.9.0@memsharded/stable")
+        if self.scope.BUILD_BENCH:
+            self.requires.add("benchmark/1.7.1")
 
     def imports(self):
         self.copy("*.dll", dst="bin", src="bin") # From bin to bin
@@ -26,8 +28,9 @@ class BoostGraphWrapperConan(ConanFile):
         cmake = CMake(self.settings)
         shared = "-DBUILD_SHARED_LIBS=ON" if self.options.shared else ""
         build_tests = "-DBUILD_TEST:BOOL=ON" if self.scope.BUILD_TEST else ""
+        build_bench = "-DBUILD_BENCH:BOOL=ON" if self.scope.BUILD_BENCH else ""
 
-        self.run('cmake "%s" %s %s %s' % (self.conanfile_directory, cmake.command_line, build_tests, build_tests))
+        self.run('cmake "%s" %s %s %s %s' % (self.conanfile_directory, cmake.command_line, build_tests, build_tests, build_bench))
         self.run("cmake --build . %s" % cmake.build_config)
         if build_tests:
             self.run("ctest -C {}".format(self.settings.build_type))
@@ -0,0 +1,297 @@
+#define BOOST_TEST_MODULE batch_construction
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <boost/range/adaptor/transformed.hpp>
+
+#include "chart_impl.hpp"
+#include "chart_io.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	typedef detail::chart_impl<node, link, Behaviour> impl_type;
+	typedef typename chart_type::event_type event_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	struct listener : chart_type::listener_type
+	{
+		// Events as delivered, and the size of the chart when each batch arrives
+		void on_events(const std::vector<event_type>& batch, impl_type& chart)
+		{
+			events.insert(events.end(), batch.begin(), batch.end());
+			sizes.push_back(std::make_pair(chart.num_vertices(), chart.num_edges()));
+		};
+
+		std::vector<event_type> events;
+		std::vector<std::pair<std::size_t, std::size_t> > sizes;
+	};
+
+	// Edges attached to the vertex elements, UNDIRECTED vertices have a single set
+	template <class Node>
+	static const typename Node::_t_edges& outgoing(const Node& v, std::true_type) { return v.get_edges();};
+	template <class Node>
+	static const typename Node::_t_edges& outgoing(const Node& v, std::false_type) { return v.get_outgoing();};
+	template <class Node>
+	static const typename Node::_t_edges& incoming(const Node& v, std::true_type) { return v.get_edges();};
+	template <class Node>
+	static const typename Node::_t_edges& incoming(const Node& v, std::false_type) { return v.get_incoming();};
+
+	static bool attached(const node& source, const node& target, const link* edge)
+	{
+		typedef std::integral_constant<bool, Behaviour == UNDIRECTED> undirected;
+		const typename node::_t_edges& out = outgoing(source, undirected());
+		const typename node::_t_edges& in = incoming(target, undirected());
+		return std::find(out.begin(), out.end(), edge) != out.end() && std::find(in.begin(), in.end(), edge) != in.end();
+	};
+
+	static bool detached(const node& v, const link* edge)
+	{
+		typedef std::integral_constant<bool, Behaviour == UNDIRECTED> undirected;
+		const typename node::_t_edges& out = outgoing(v, undirected());
+		const typename node::_t_edges& in = incoming(v, undirected());
+		return std::find(out.begin(), out.end(), edge) == out.end() && std::find(in.begin(), in.end(), edge) == in.end();
+	};
+
+	static std::vector<std::shared_ptr<node> > make_vertices(std::size_t n)
+	{
+		std::vector<std::shared_ptr<node> > vertices;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			vertices.push_back(std::make_shared<node>());
+		}
+		return vertices;
+	};
+
+	static std::vector<typename chart_type::edge_entry> make_edges(const std::vector<typename chart_type::vertex_id>& ids, std::size_t n, unsigned seed)
+	{
+		// Self-loops and parallel edges included
+		std::mt19937 rng(seed);
+		std::vector<typename chart_type::edge_entry> edges;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			edges.push_back(typename chart_type::edge_entry(std::make_shared<link>(), ids[rng() % ids.size()], ids[rng() % ids.size()]));
+		}
+		return edges;
+	};
+};
+
+struct fail_at
+{
+	// Passes the elements through, throws on the 'n'-th call (counted across copies)
+	template <class T>
+	const T& operator()(const T& item) const
+	{
+		if ((*calls)++ == n)
+		{
+			throw std::runtime_error("range failed");
+		}
+		return item;
+	};
+
+	std::size_t n;
+	std::shared_ptr<std::size_t> calls;
+};
+
+template <class Range>
+boost::range_detail::transformed_range<fail_at, const Range> failing(const Range& range, std::size_t n)
+{
+	fail_at f = {n, std::make_shared<std::size_t>(0)};
+	return boost::adaptors::transform(range, f);
+}
+
+template <int Behaviour>
+void check_ids()
+{
+	typedef graph<Behaviour> g;
+	typename g::chart_type chart;
+	const std::vector<std::shared_ptr<typename g::node> > first = g::make_vertices(5), second = g::make_vertices(5);
+	const typename g::chart_type::vertex_id existing = chart.add_vertex(first[2]).first;
+
+	// In the input order, elements already in the chart (or repeated) keep their id
+	std::vector<std::shared_ptr<typename g::node> > input(first);
+	input.push_back(first[0]);
+	const std::vector<typename g::chart_type::vertex_id> ids = chart.add_vertices(input);
+	BOOST_REQUIRE_EQUAL(ids.size(), input.size());
+	BOOST_CHECK_EQUAL(chart.num_vertices(), 5u);
+	BOOST_CHECK(ids[2] == existing);
+	BOOST_CHECK(ids[5] == ids[0]);
+	for (std::size_t i = 0; i < input.size(); ++i)
+	{
+		BOOST_CHECK(chart.get_vertex(ids[i]) == input[i]);
+		BOOST_CHECK(chart.get_vertex_id(input[i]) == ids[i]);
+	}
+
+	// New ones take the next dense indices in order
+	const std::vector<typename g::chart_type::vertex_id> more = chart.add_vertices(second);
+	for (std::size_t i = 0; i < second.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(chart.get_vertex_index(more[i]), 5 + i);
+	}
+
+	const std::vector<typename g::chart_type::edge_entry> edges = g::make_edges(ids, 50, Behaviour);
+	const std::vector<typename g::chart_type::edge_id> edge_ids = chart.add_edges(edges);
+	BOOST_REQUIRE_EQUAL(edge_ids.size(), edges.size());
+	BOOST_CHECK_EQUAL(chart.num_edges(), edges.size());
+	detail::edge_endpoints<typename g::impl_type> endpoints(chart);
+	for (std::size_t i = 0; i < edges.size(); ++i)
+	{
+		const std::size_t index = chart.get_edge_index(edge_ids[i]);
+		BOOST_CHECK_EQUAL(index, i);
+		BOOST_CHECK(chart.get_edge(edge_ids[i]) == std::get<0>(edges[i]));
+		BOOST_CHECK(chart.get_edge_id(std::get<0>(edges[i])) == edge_ids[i]);
+		BOOST_CHECK_EQUAL(endpoints.source(index), chart.get_vertex_index(std::get<1>(edges[i])));
+		BOOST_CHECK_EQUAL(endpoints.target(index), chart.get_vertex_index(std::get<2>(edges[i])));
+		BOOST_CHECK(g::attached(*chart.get_vertex(std::get<1>(edges[i])), *chart.get_vertex(std::get<2>(edges[i])), std::get<0>(edges[i]).get()));
+	}
+
+	// Empty batches do nothing
+	BOOST_CHECK(chart.add_vertices(std::vector<std::shared_ptr<typename g::node> >()).empty());
+	BOOST_CHECK(chart.add_edges(std::vector<typename g::chart_type::edge_entry>()).empty());
+	BOOST_CHECK_EQUAL(chart.num_vertices(), 10u);
+}
+
+template <int Behaviour>
+void check_notification()
+{
+	// Listeners get the added elements once the whole batch is in, even if the ring fills up meanwhile
+	typedef graph<Behaviour> g;
+	typename g::chart_type chart;
+	const std::vector<std::shared_ptr<typename g::node> > vertices = g::make_vertices(20);
+	chart.add_vertex(vertices[3]);
+	std::shared_ptr<typename g::listener> listener = std::make_shared<typename g::listener>();
+	chart.enable_events(4).add_listener(listener);
+
+	const std::vector<typename g::chart_type::vertex_id> ids = chart.add_vertices(vertices);
+	chart.get_observer()->flush();
+	BOOST_REQUIRE_EQUAL(listener->events.size(), 19u); // not the one already in the chart
+	for (std::size_t i = 0, j = 0; i < vertices.size(); ++i)
+	{
+		if (i != 3)
+		{
+			BOOST_CHECK(listener->events[j].kind == g::event_type::VERTEX_ADDED && listener->events[j].vertex == vertices[i]);
+			++j;
+		}
+	}
+	for (std::size_t i = 0; i < listener->sizes.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(listener->sizes[i].first, 20u);
+	}
+
+	listener->events.clear();
+	listener->sizes.clear();
+	const std::vector<typename g::chart_type::edge_entry> edges = g::make_edges(ids, 30, 1);
+	chart.add_edges(edges);
+	chart.get_observer()->flush();
+	BOOST_REQUIRE_EQUAL(listener->events.size(), edges.size());
+	for (std::size_t i = 0; i < edges.size(); ++i)
+	{
+		BOOST_CHECK(listener->events[i].kind == g::event_type::EDGE_ADDED && listener->events[i].edge == std::get<0>(edges[i]));
+	}
+	for (std::size_t i = 0; i < listener->sizes.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(listener->sizes[i].second, edges.size());
+	}
+}
+
+template <int Behaviour>
+void check_rollback()
+{
+	typedef graph<Behaviour> g;
+	typename g::chart_type chart;
+	chart.enable_component_tracking();
+	std::shared_ptr<typename g::listener> listener = std::make_shared<typename g::listener>();
+	chart.enable_events().add_listener(listener);
+	const std::vector<typename g::chart_type::vertex_id> ids = chart.add_vertices(g::make_vertices(10));
+	const std::vector<typename g::chart_type::edge_entry> initial = g::make_edges(ids, 5, 2);
+	chart.add_edges(initial);
+	chart.get_observer()->flush();
+	listener->events.clear();
+	const std::size_t components = chart.num_components();
+
+	// A range failing midway leaves the chart as it was, nobody notified
+	const std::vector<std::shared_ptr<typename g::node> > vertices = g::make_vertices(8);
+	BOOST_CHECK_THROW(chart.add_vertices(failing(vertices, 5)), std::runtime_error);
+	BOOST_CHECK_EQUAL(chart.num_vertices(), 10u);
+	for (std::size_t i = 0; i < ids.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(chart.get_vertex_index(ids[i]), i);
+	}
+	for (const std::shared_ptr<typename g::node>& v : vertices)
+	{
+		BOOST_CHECK(v->get_charts().empty());
+	}
+	BOOST_CHECK_EQUAL(chart.num_components(), components);
+
+	// Edges: every edge is checked first (the whole range is walked once before anything is added)
+	const std::vector<typename g::chart_type::edge_entry> edges = g::make_edges(ids, 8, 3);
+	std::vector<typename g::chart_type::edge_entry> connected(edges);
+	connected.push_back(initial[0]);
+	BOOST_CHECK_THROW(chart.add_edges(connected), std::runtime_error);
+	BOOST_CHECK_THROW(chart.add_edges(failing(edges, 8 + 5)), std::runtime_error);
+	BOOST_CHECK_EQUAL(chart.num_edges(), initial.size());
+	for (std::size_t i = 0; i < initial.size(); ++i)
+	{
+		BOOST_CHECK(chart.get_edge(chart.get_edge_at(i)) == std::get<0>(initial[i]));
+	}
+	for (const typename g::chart_type::edge_entry& e : edges)
+	{
+		BOOST_CHECK(!std::get<0>(e)->is_connected());
+	}
+	std::size_t listed = 0;
+	for (const typename g::chart_type::vertex_id& v : ids)
+	{
+		listed += boost::size(chart.out_edges(v));
+		for (const typename g::chart_type::edge_entry& e : edges)
+		{
+			BOOST_CHECK(g::detached(*chart.get_vertex(v), std::get<0>(e).get()));
+		}
+	}
+	BOOST_CHECK_EQUAL(listed, (Behaviour == UNDIRECTED ? 2 : 1)*initial.size()); // UNDIRECTED edges are listed from both ends
+	BOOST_CHECK_EQUAL(chart.num_components(), components);
+	chart.get_observer()->flush();
+	BOOST_CHECK(listener->events.empty());
+
+	// The same elements can be added afterwards
+	chart.add_vertices(vertices);
+	chart.add_edges(edges);
+	BOOST_CHECK_EQUAL(chart.num_vertices(), 18u);
+	BOOST_CHECK_EQUAL(chart.num_edges(), initial.size() + edges.size());
+	chart.get_observer()->flush();
+	BOOST_CHECK_EQUAL(listener->events.size(), vertices.size() + edges.size());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(ids)
+{
+	check_ids<DIRECTED>();
+	check_ids<UNDIRECTED>();
+	check_ids<BIDIRECTIONAL>();
+}
+
+BOOST_AUTO_TEST_CASE(single_notification)
+{
+	check_notification<DIRECTED>();
+	check_notification<UNDIRECTED>();
+	check_notification<BIDIRECTIONAL>();
+}
+
+BOOST_AUTO_TEST_CASE(rollback)
+{
+	check_rollback<DIRECTED>();
+	check_rollback<UNDIRECTED>();
+	check_rollback<BIDIRECTIONAL>();
+}
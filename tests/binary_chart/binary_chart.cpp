@@ -0,0 +1,306 @@
+#define BOOST_TEST_MODULE binary_chart
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <boost/filesystem.hpp>
+
+#include "chart_impl.hpp"
+#include "binary_chart.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct city { std::string name;};
+struct road { double km;};
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	struct node : detail::vertex<link, Behaviour, chart_type, city>
+	{
+		node(const std::string& name) : detail::vertex<link, Behaviour, chart_type, city>(std::make_shared<city>(city{name})) {};
+	};
+	struct link : detail::edge<node, link, Behaviour, chart_type, road>
+	{
+		link(double km) : detail::edge<node, link, Behaviour, chart_type, road>(std::make_shared<road>(road{km})) {};
+	};
+
+	static void make_random(chart_type& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		// Self-loops, parallel edges and isolated vertices, some removals to reshuffle the dense indices
+		std::mt19937 rng(seed);
+		for (std::size_t i = 0; i < n_vertices; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>(i % 5 ? "city " + std::to_string(i) : std::string()));
+		}
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			chart.add_edge(std::make_shared<link>(0.5*i), chart.get_vertex_at(rng() % n_vertices), chart.get_vertex_at(rng() % n_vertices));
+		}
+		for (std::size_t i = 0; i < n_vertices/10; ++i)
+		{
+			chart.remove_vertex(chart.get_vertex_at(rng() % chart.num_vertices()));
+		}
+	};
+
+	static void save(const chart_type& chart, const std::string& path)
+	{
+		save_binary(chart, path,
+			[](const node& v, std::vector<char>& bytes) { bytes.insert(bytes.end(), v.get_obj().name.begin(), v.get_obj().name.end());},
+			[](const link& e, std::vector<char>& bytes)
+			{
+				const char* km = reinterpret_cast<const char*>(&e.get_obj().km);
+				bytes.insert(bytes.end(), km, km + sizeof(double));
+			});
+	};
+
+	static std::size_t mismatches(const chart_type& chart, const mapped_chart& mapped)
+	{
+		// Same ids, adjacency and payloads as a snapshot of the chart
+		const auto frozen = chart.freeze();
+		std::size_t errors = (mapped.num_vertices() != frozen.num_vertices()) + (mapped.num_edges() != frozen.num_edges()) + (mapped.behaviour() != Behaviour);
+		for (std::size_t v = 0; v < frozen.num_vertices(); ++v)
+		{
+			std::vector<std::size_t> expected;
+			std::vector<mapped_chart::edge_id> edges;
+			frozen.get_edges_outgoing(v, expected);
+			mapped.get_edges_outgoing(v, edges);
+			errors += !std::is_permutation(expected.begin(), expected.end(), edges.begin(), edges.end());
+			errors += !std::is_sorted(edges.begin(), edges.end());
+
+			expected.clear();
+			edges.clear();
+			incoming(frozen, v, expected, std::integral_constant<bool, Behaviour != DIRECTED>());
+			mapped.get_edges_incoming(v, edges);
+			errors += !std::is_permutation(expected.begin(), expected.end(), edges.begin(), edges.end());
+
+			const mapped_chart::payload_range name = mapped.get_vertex_payload(v);
+			errors += (std::string(name.begin(), name.end()) != frozen.get_vertex(v)->get_obj().name);
+		}
+		for (std::size_t e = 0; e < frozen.num_edges(); ++e)
+		{
+			errors += (mapped.get_source(e) != frozen.get_source(e)) + (mapped.get_target(e) != frozen.get_target(e));
+			const mapped_chart::payload_range km = mapped.get_edge_payload(e);
+			double value = -1;
+			if (km.size() == sizeof(double))
+			{
+				std::memcpy(&value, km.begin(), sizeof(double));
+			}
+			errors += (value != frozen.get_edge(e)->get_obj().km);
+		}
+		return errors;
+	};
+
+	template <class Frozen>
+	static void incoming(const Frozen& frozen, std::size_t v, std::vector<std::size_t>& edges, std::true_type) { frozen.get_edges_incoming(v, edges);};
+	template <class Frozen>
+	static void incoming(const Frozen&, std::size_t, std::vector<std::size_t>&, std::false_type) {};
+};
+
+struct temporary_file
+{
+	temporary_file() : path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("chart-%%%%-%%%%.bin")).string()) {};
+	~temporary_file() { boost::system::error_code ignored; boost::filesystem::remove(path, ignored);};
+	std::string path;
+};
+
+std::vector<char> read_bytes(const std::string& path)
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write_bytes(const std::string& path, const std::vector<char>& bytes)
+{
+	std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+	file.write(bytes.data(), bytes.size());
+}
+
+binary_format::header header_of(const std::vector<char>& bytes)
+{
+	binary_format::header header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	return header;
+}
+
+void put_word(std::vector<char>& bytes, std::uint64_t offset, std::uint64_t word)
+{
+	std::memcpy(bytes.data() + offset, &word, sizeof(word));
+}
+
+struct corrupt_file
+{
+	// A valid file of a small BIDIRECTIONAL chart, to be damaged by every test
+	corrupt_file()
+	{
+		graph<BIDIRECTIONAL>::chart_type chart;
+		graph<BIDIRECTIONAL>::make_random(chart, 100, 400, 9);
+		graph<BIDIRECTIONAL>::save(chart, original.path);
+		bytes = read_bytes(original.path);
+		header = header_of(bytes);
+	};
+
+	bool loads(bool verify)
+	{
+		write_bytes(damaged.path, bytes);
+		try
+		{
+			mapped_chart mapped(damaged.path, verify);
+			return true;
+		}
+		catch (std::runtime_error&)
+		{
+			return false;
+		}
+	};
+
+	temporary_file original, damaged;
+	std::vector<char> bytes;
+	binary_format::header header;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(round_trip)
+{
+	temporary_file file;
+	{
+		graph<BIDIRECTIONAL>::chart_type chart;
+		graph<BIDIRECTIONAL>::make_random(chart, 1000, 4000, 1);
+		graph<BIDIRECTIONAL>::save(chart, file.path);
+		BOOST_CHECK_EQUAL(graph<BIDIRECTIONAL>::mismatches(chart, mapped_chart(file.path)), 0u);
+		BOOST_CHECK_EQUAL(graph<BIDIRECTIONAL>::mismatches(chart, mapped_chart(file.path, true)), 0u);
+	}
+	{
+		graph<UNDIRECTED>::chart_type chart;
+		graph<UNDIRECTED>::make_random(chart, 1000, 4000, 2);
+		graph<UNDIRECTED>::save(chart, file.path);
+		BOOST_CHECK_EQUAL(graph<UNDIRECTED>::mismatches(chart, mapped_chart(file.path)), 0u);
+		BOOST_CHECK_EQUAL(graph<UNDIRECTED>::mismatches(chart, mapped_chart(file.path, true)), 0u);
+	}
+	{
+		graph<DIRECTED>::chart_type chart;
+		graph<DIRECTED>::make_random(chart, 1000, 4000, 3);
+		graph<DIRECTED>::save(chart, file.path);
+		const mapped_chart mapped(file.path, true);
+		BOOST_CHECK_EQUAL(graph<DIRECTED>::mismatches(chart, mapped), 0u);
+		BOOST_CHECK(mapped.in_edges(0).empty());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(without_payloads)
+{
+	temporary_file file;
+	graph<BIDIRECTIONAL>::chart_type chart;
+	graph<BIDIRECTIONAL>::make_random(chart, 100, 300, 4);
+	save_binary(chart, file.path);
+	const mapped_chart mapped(file.path, true);
+	BOOST_CHECK_EQUAL(mapped.num_edges(), chart.num_edges());
+	BOOST_CHECK(mapped.get_vertex_payload(0).empty());
+	BOOST_CHECK(mapped.get_edge_payload(0).empty());
+}
+
+BOOST_AUTO_TEST_CASE(empty_chart)
+{
+	temporary_file file;
+	graph<UNDIRECTED>::chart_type chart;
+	graph<UNDIRECTED>::save(chart, file.path);
+	const mapped_chart mapped(file.path, true);
+	BOOST_CHECK_EQUAL(mapped.num_vertices(), 0u);
+	BOOST_CHECK_EQUAL(mapped.num_edges(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(missing_or_not_a_chart)
+{
+	BOOST_CHECK_THROW(mapped_chart("/nonexistent/chart.bin"), std::runtime_error);
+	temporary_file file;
+	write_bytes(file.path, std::vector<char>(10, 'x'));
+	BOOST_CHECK_THROW(mapped_chart(file.path), std::runtime_error);
+}
+
+BOOST_FIXTURE_TEST_CASE(bad_magic, corrupt_file)
+{
+	BOOST_REQUIRE(this->loads(true));
+	bytes[0] = 'X';
+	BOOST_CHECK(!this->loads(false));
+}
+
+BOOST_FIXTURE_TEST_CASE(bad_version, corrupt_file)
+{
+	header.version = binary_format::version + 1;
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	BOOST_CHECK(!this->loads(false));
+}
+
+BOOST_FIXTURE_TEST_CASE(truncated, corrupt_file)
+{
+	for (std::size_t size : {bytes.size() - 1, bytes.size()/2, sizeof(binary_format::header)})
+	{
+		bytes.resize(size);
+		BOOST_CHECK(!this->loads(false));
+		BOOST_CHECK(!this->loads(true));
+	}
+}
+
+BOOST_FIXTURE_TEST_CASE(huge_counts, corrupt_file)
+{
+	// 8*(n_vertices + 1) wraps to 0: empty offset sections would match, then be read far out of the mapping
+	header.n_vertices = (std::uint64_t(1) << 61) - 1;
+	header.sections[binary_format::OUT_OFFSETS].size = 0;
+	header.sections[binary_format::IN_OFFSETS].size = 0;
+	header.sections[binary_format::VERTEX_PAYLOAD_OFFSETS].size = 0;
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	// offsets[n_vertices] wraps to the word before the section: make it match the payload size
+	put_word(bytes, header.sections[binary_format::VERTEX_PAYLOAD_OFFSETS].offset - 8, header.sections[binary_format::VERTEX_PAYLOAD].size);
+	BOOST_CHECK(!this->loads(false));
+
+	header = header_of(read_bytes(original.path));
+	header.n_edges = std::uint64_t(-1)/2;
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	BOOST_CHECK(!this->loads(false));
+}
+
+BOOST_FIXTURE_TEST_CASE(section_out_of_the_file, corrupt_file)
+{
+	header.sections[binary_format::EDGE_PAYLOAD].size = bytes.size();
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	BOOST_CHECK(!this->loads(false));
+}
+
+BOOST_FIXTURE_TEST_CASE(edge_id_out_of_range, corrupt_file)
+{
+	// Only the header is checked by default: 'verify' finds it
+	put_word(bytes, header.sections[binary_format::OUT_EDGES].offset, std::uint64_t(-1));
+	BOOST_CHECK(this->loads(false));
+	BOOST_CHECK(!this->loads(true));
+}
+
+BOOST_FIXTURE_TEST_CASE(offsets_decreasing, corrupt_file)
+{
+	put_word(bytes, header.sections[binary_format::IN_OFFSETS].offset + 8*(header.n_vertices/2), header.n_edges + 1);
+	BOOST_CHECK(this->loads(false));
+	BOOST_CHECK(!this->loads(true));
+}
+
+BOOST_FIXTURE_TEST_CASE(payload_offsets_decreasing, corrupt_file)
+{
+	put_word(bytes, header.sections[binary_format::EDGE_PAYLOAD_OFFSETS].offset + 8, header.sections[binary_format::EDGE_PAYLOAD].size + 8);
+	BOOST_CHECK(this->loads(false));
+	BOOST_CHECK(!this->loads(true));
+}
+
+BOOST_FIXTURE_TEST_CASE(vertex_id_out_of_range, corrupt_file)
+{
+	put_word(bytes, header.sections[binary_format::TARGETS].offset, header.n_vertices);
+	BOOST_CHECK(this->loads(false));
+	BOOST_CHECK(!this->loads(true));
+}
@@ -0,0 +1,296 @@
+#define BOOST_TEST_MODULE chart_index
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <vector>
+#include <random>
+#include <memory>
+#include <stdexcept>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct probe_index : detail::hashed_index<std::shared_ptr<int>, int>
+{
+	// Exposes the table to place keys in chosen slots and check the probing invariant
+	std::size_t capacity() const { return _slots.size();};
+	std::size_t ideal(const int* ptr) const { return hash(ptr) & (_slots.size() - 1);};
+
+	std::size_t slot_of(const int* ptr) const
+	{
+		for (std::size_t pos = 0; pos < _slots.size(); ++pos)
+		{
+			if (_slots[pos].first.get() == ptr)
+			{
+				return pos;
+			}
+		}
+		return std::size_t(-1);
+	};
+
+	std::size_t broken_clusters() const
+	{
+		// Every element must be reachable from its ideal slot without crossing an empty one
+		const std::size_t mask = _slots.size() - 1;
+		std::size_t errors = 0, occupied = 0;
+		for (std::size_t pos = 0; pos < _slots.size(); ++pos)
+		{
+			if (_slots[pos].first)
+			{
+				++occupied;
+				for (std::size_t p = this->ideal(_slots[pos].first.get()); p != pos; p = (p + 1) & mask)
+				{
+					errors += !_slots[p].first;
+				}
+			}
+		}
+		return errors + (occupied != _size);
+	};
+};
+
+struct pool
+{
+	// Keys are non-owning pointers into a big array, so their hashes can be chosen
+	explicit pool(std::size_t n) : items(n) {};
+
+	std::shared_ptr<int> key(std::size_t i) { return std::shared_ptr<int>(std::shared_ptr<int>(), &items[i]);};
+
+	std::vector<std::shared_ptr<int> > with_ideal(const probe_index& index, std::size_t slot, std::size_t n, std::size_t& next)
+	{
+		// 'n' unused keys whose ideal slot in 'index' is 'slot'
+		std::vector<std::shared_ptr<int> > keys;
+		for (; keys.size() < n; ++next)
+		{
+			BOOST_REQUIRE(next < items.size());
+			if (index.ideal(&items[next]) == slot)
+			{
+				keys.push_back(this->key(next));
+			}
+		}
+		return keys;
+	};
+
+	std::vector<int> items;
+};
+
+std::size_t missing(const probe_index& index, const std::vector<std::shared_ptr<int> >& present, const std::vector<std::shared_ptr<int> >& absent)
+{
+	std::size_t errors = 0;
+	for (const std::shared_ptr<int>& key : present)
+	{
+		const probe_index::const_iterator it = index.find(key);
+		errors += (it == index.end() || it->first != key || it->second != *key);
+	}
+	for (const std::shared_ptr<int>& key : absent)
+	{
+		errors += (index.find(key) != index.end());
+	}
+	return errors;
+}
+
+struct indexed : detail::intrusive_indexed {};
+typedef detail::intrusive_index<std::shared_ptr<indexed>, int> intrusive_type;
+
+}
+
+BOOST_AUTO_TEST_CASE(erase_inside_a_cluster)
+{
+	// Keys sharing an ideal slot form a cluster, erasing one in the middle shifts the rest back
+	pool keys(100000);
+	probe_index index;
+	index.reserve(12);
+	BOOST_REQUIRE_EQUAL(index.capacity(), 16u);
+
+	std::size_t next = 0;
+	std::vector<std::shared_ptr<int> > cluster = keys.with_ideal(index, 3, 5, next); // slots 3..7
+	const std::vector<std::shared_ptr<int> > neighbours = keys.with_ideal(index, 4, 2, next); // pushed to 8, 9
+	const std::vector<std::shared_ptr<int> > later = keys.with_ideal(index, 9, 1, next); // pushed to 10
+	std::vector<std::shared_ptr<int> > all(cluster);
+	all.insert(all.end(), neighbours.begin(), neighbours.end());
+	all.insert(all.end(), later.begin(), later.end());
+	for (std::size_t i = 0; i < all.size(); ++i)
+	{
+		*all[i] = static_cast<int>(i);
+		BOOST_CHECK(index.insert(std::make_pair(all[i], *all[i])).second);
+		BOOST_CHECK_EQUAL(index.slot_of(all[i].get()), 3 + i);
+	}
+	BOOST_CHECK(!index.insert(std::make_pair(all[2], -1)).second);
+	BOOST_CHECK_EQUAL(index.size(), all.size());
+
+	// Erasing slot 4: the rest of its cluster and the displaced neighbours move back one slot,
+	// the key of slot 10 goes back to 9 (its ideal one) but not further
+	index.erase(index.find(all[1]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[2].get()), 4u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[6].get()), 8u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[7].get()), 9u);
+	BOOST_CHECK_EQUAL(missing(index, {all[0], all[2], all[3], all[4], all[5], all[6], all[7]}, {all[1]}), 0u);
+
+	// Now the key of slot 9 is at its ideal slot, erasing before it leaves it there
+	index.erase(index.find(all[3]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[7].get()), 9u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[6].get()), 7u);
+	BOOST_CHECK_EQUAL(missing(index, {all[0], all[2], all[4], all[5], all[6], all[7]}, {all[1], all[3]}), 0u);
+
+	// Head and tail of the cluster
+	index.erase(index.find(all[0]));
+	index.erase(index.find(all[7]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(missing(index, {all[2], all[4], all[5], all[6]}, {all[0], all[1], all[3], all[7]}), 0u);
+	BOOST_CHECK_EQUAL(index.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(erase_across_the_end)
+{
+	// A cluster starting at the last slots wraps to the first ones
+	pool keys(100000);
+	probe_index index;
+	index.reserve(12);
+	BOOST_REQUIRE_EQUAL(index.capacity(), 16u);
+
+	std::size_t next = 0;
+	std::vector<std::shared_ptr<int> > all = keys.with_ideal(index, 14, 4, next); // slots 14, 15, 0, 1
+	const std::vector<std::shared_ptr<int> > first = keys.with_ideal(index, 0, 2, next); // pushed to 2, 3
+	const std::vector<std::shared_ptr<int> > second = keys.with_ideal(index, 3, 1, next); // pushed to 4
+	all.insert(all.end(), first.begin(), first.end());
+	all.insert(all.end(), second.begin(), second.end());
+	const std::size_t expected[] = {14, 15, 0, 1, 2, 3, 4};
+	for (std::size_t i = 0; i < all.size(); ++i)
+	{
+		*all[i] = static_cast<int>(i);
+		BOOST_CHECK(index.insert(std::make_pair(all[i], *all[i])).second);
+		BOOST_CHECK_EQUAL(index.slot_of(all[i].get()), expected[i]);
+	}
+
+	// The hole at 15 is filled from slot 0, and so on across the end of the table
+	index.erase(index.find(all[1]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[2].get()), 15u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[3].get()), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[4].get()), 1u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[5].get()), 2u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[6].get()), 3u);
+
+	// Erasing at 15 pulls back the last key of ideal slot 14 and the keys of ideal slot 0 behind it;
+	// erasing it again, keys of ideal slot 0 cannot move back into slot 15
+	index.erase(index.find(all[2]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[3].get()), 15u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[4].get()), 0u);
+	index.erase(index.find(all[3]));
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+	BOOST_CHECK_EQUAL(index.slot_of(all[4].get()), 0u); // its ideal slot, slot 15 stays empty
+	BOOST_CHECK_EQUAL(missing(index, {all[0], all[4], all[5], all[6]}, {all[1], all[2], all[3]}), 0u);
+
+	// Iteration visits every element once, wrapped or not
+	std::set<int*> seen;
+	for (probe_index::iterator it = index.begin(); it != index.end(); ++it)
+	{
+		BOOST_CHECK(seen.insert(it->first.get()).second);
+	}
+	BOOST_CHECK_EQUAL(seen.size(), index.size());
+}
+
+BOOST_AUTO_TEST_CASE(interleaved_inserts_and_erases)
+{
+	// Random inserts and erases through several rehashes, against a std::set
+	pool keys(20000);
+	probe_index index;
+	std::set<std::size_t> model;
+	std::mt19937 rng(7);
+	std::size_t capacity = 0, rehashes = 0, errors = 0;
+	for (std::size_t step = 0; step < 60000; ++step)
+	{
+		const std::size_t i = rng() % (step < 30000 ? 20000 : 2000); // later on, mostly hits
+		const std::shared_ptr<int> key = keys.key(i);
+		if (rng() % 3)
+		{
+			*key = static_cast<int>(i);
+			errors += (index.insert(std::make_pair(key, static_cast<int>(i))).second != model.insert(i).second);
+		}
+		else
+		{
+			const probe_index::iterator it = index.find(key);
+			errors += ((it != index.end()) != (model.erase(i) == 1));
+			if (it != index.end())
+			{
+				index.erase(it);
+			}
+		}
+		rehashes += (index.capacity() != capacity);
+		capacity = index.capacity();
+		if (step % 1000 == 0)
+		{
+			errors += index.broken_clusters();
+		}
+	}
+	BOOST_CHECK_EQUAL(errors, 0u);
+	BOOST_CHECK_GT(rehashes, 5u);
+	BOOST_CHECK_EQUAL(index.size(), model.size());
+	BOOST_CHECK_EQUAL(index.broken_clusters(), 0u);
+
+	std::set<std::size_t> listed;
+	for (probe_index::const_iterator it = index.begin(); it != index.end(); ++it)
+	{
+		listed.insert(static_cast<std::size_t>(it->first.get() - &keys.items[0]));
+		errors += (it->second != *it->first);
+	}
+	BOOST_CHECK(listed == model);
+	BOOST_CHECK_EQUAL(errors, 0u);
+
+	index.clear();
+	BOOST_CHECK(index.empty() && index.begin() == index.end());
+	BOOST_CHECK(index.find(keys.key(0)) == index.end());
+	BOOST_CHECK_EQUAL(index.heap_bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(intrusive_index)
+{
+	std::vector<std::shared_ptr<indexed> > items;
+	intrusive_type index;
+	for (int i = 0; i < 6; ++i)
+	{
+		items.push_back(std::make_shared<indexed>());
+		const std::pair<intrusive_type::iterator, bool> inserted = index.insert(std::make_pair(items.back(), i));
+		BOOST_CHECK(inserted.second && inserted.first->second == i);
+	}
+	BOOST_CHECK(!index.insert(std::make_pair(items[2], 100)).second);
+	BOOST_CHECK_EQUAL(index.find(items[2])->second, 2);
+	BOOST_CHECK_EQUAL(index.size(), 6u);
+
+	// Erasing in the middle moves the last one into the hole, which must still be found
+	index.erase(index.find(items[1]));
+	BOOST_CHECK(index.find(items[1]) == index.end());
+	BOOST_CHECK(index.find(items[5]) == index.begin() + 1);
+	for (int i : {0, 2, 3, 4, 5})
+	{
+		BOOST_CHECK(index.find(items[i])->first == items[i] && index.find(items[i])->second == i);
+	}
+	index.erase(index.find(items[4])); // the last one
+	index.erase(index.find(items[0])); // the first one
+	for (int i : {2, 3, 5})
+	{
+		BOOST_CHECK(index.find(items[i])->first == items[i] && index.find(items[i])->second == i);
+	}
+	BOOST_CHECK_EQUAL(index.size(), 3u);
+
+	// One index at a time: another one refuses it, until it is erased or the owner cleared
+	intrusive_type other;
+	BOOST_CHECK_THROW(other.insert(std::make_pair(items[2], 0)), std::runtime_error);
+	BOOST_CHECK(other.find(items[2]) == other.end());
+	BOOST_CHECK(other.insert(std::make_pair(items[1], 1)).second);
+	index.clear();
+	BOOST_CHECK(index.find(items[2]) == index.end());
+	BOOST_CHECK(other.insert(std::make_pair(items[2], 2)).second);
+	BOOST_CHECK_EQUAL(other.find(items[2])->second, 2);
+
+	// Copies of an element are not indexed
+	const std::shared_ptr<indexed> copy = std::make_shared<indexed>(*items[2]);
+	BOOST_CHECK(other.find(copy) == other.end());
+	BOOST_CHECK(other.insert(std::make_pair(copy, 3)).second);
+	BOOST_CHECK_EQUAL(other.size(), 3u);
+}
@@ -0,0 +1,194 @@
+#define BOOST_TEST_MODULE chart_io
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+
+#include "chart_impl.hpp"
+#include "chart_io.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct tag { std::string text;};
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type, tag>
+	{
+		link(const std::string& text) : detail::edge<node, link, Behaviour, chart_type, tag>(std::make_shared<tag>(tag{text})) {};
+	};
+
+	struct tag_label
+	{
+		void operator()(const link& e, std::string& label) const { label += e.get_obj().text;};
+	};
+
+	static void make_random(chart_type& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		// Labels with blanks and quotes, some empty; isolated vertices
+		std::mt19937 rng(seed);
+		for (std::size_t i = 0; i < n_vertices; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>());
+		}
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			const std::string text = (i % 4) ? "road \"" + std::to_string(i) + "\" km" : std::string();
+			chart.add_edge(std::make_shared<link>(text), chart.get_vertex_at(rng() % (n_vertices/2)), chart.get_vertex_at(rng() % (n_vertices/2)));
+		}
+	};
+
+	static std::vector<typename chart_type::vertex_id> read(const std::string& text, chart_type& chart, unsigned n_threads, std::size_t chunk_size)
+	{
+		std::istringstream in(text);
+		return read_edge_list(in, chart,
+			[](std::size_t) { return std::make_shared<node>();},
+			[](const char* begin, const char* end) { return std::make_shared<link>(std::string(begin, end));},
+			n_threads, chunk_size);
+	};
+
+	static std::string edge_list(const chart_type& chart)
+	{
+		std::ostringstream out;
+		write_edge_list(out, chart, tag_label());
+		return out.str();
+	};
+};
+
+typedef graph<DIRECTED> directed;
+typedef graph<UNDIRECTED> undirected;
+
+}
+
+BOOST_AUTO_TEST_CASE(edge_list_round_trip)
+{
+	directed::chart_type chart;
+	directed::make_random(chart, 400, 1500, 1);
+	const std::string text = directed::edge_list(chart);
+
+	for (std::size_t chunk_size : {std::size_t(64), std::size_t(1000), std::size_t(1) << 20})
+	{
+		for (unsigned n_threads : {1u, 4u})
+		{
+			directed::chart_type copy;
+			const std::vector<directed::chart_type::vertex_id> vertices = directed::read(text, copy, n_threads, chunk_size);
+			BOOST_REQUIRE_EQUAL(copy.num_vertices(), chart.num_vertices());
+			BOOST_REQUIRE_EQUAL(vertices.size(), chart.num_vertices());
+			BOOST_CHECK_EQUAL(copy.num_edges(), chart.num_edges());
+			// Vertices are created in order of appearance: compare through the numbers of the file
+			std::vector<std::size_t> number_of(copy.num_vertices());
+			for (std::size_t number = 0; number < vertices.size(); ++number)
+			{
+				number_of[copy.get_vertex_index(vertices[number])] = number;
+			}
+			const detail::edge_endpoints<directed::chart_type> original(chart), read(copy);
+			std::size_t wrong = 0;
+			for (std::size_t e = 0; e < chart.num_edges(); ++e)
+			{
+				wrong += (number_of[read.source(e)] != original.source(e)) + (number_of[read.target(e)] != original.target(e));
+				wrong += (copy.get_edge(copy.get_edge_at(e))->get_obj().text != chart.get_edge(chart.get_edge_at(e))->get_obj().text);
+			}
+			BOOST_CHECK_EQUAL(wrong, 0u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(crlf_comments_and_blanks)
+{
+	const std::string text =
+		"# a comment\r\n"
+		"\r\n"
+		"0 1 first label\r\n"
+		"   # an indented comment\n"
+		"\t1\t2\n"
+		"3\r\n"
+		"2 0 last, without line break";
+	undirected::chart_type chart;
+	const std::vector<undirected::chart_type::vertex_id> vertices = undirected::read(text, chart, 2, 8);
+	BOOST_REQUIRE_EQUAL(vertices.size(), 4u);
+	BOOST_REQUIRE_EQUAL(chart.num_vertices(), 4u);
+	BOOST_REQUIRE_EQUAL(chart.num_edges(), 3u);
+	BOOST_CHECK_EQUAL(chart.get_edge(chart.get_edge_at(0))->get_obj().text, "first label");
+	BOOST_CHECK_EQUAL(chart.get_edge(chart.get_edge_at(1))->get_obj().text, "");
+	BOOST_CHECK_EQUAL(chart.get_edge(chart.get_edge_at(2))->get_obj().text, "last, without line break");
+	BOOST_CHECK(chart.out_edges(vertices[3]).empty());
+}
+
+BOOST_AUTO_TEST_CASE(lines_across_chunks)
+{
+	// A line split by every chunk boundary, and one longer than the chunk itself
+	const std::string long_label(1000, 'x');
+	std::string text;
+	for (std::size_t i = 0; i < 50; ++i)
+	{
+		text += std::to_string(i) + " " + std::to_string(i + 1) + " label " + std::to_string(i) + "\n";
+	}
+	text += "50 0 " + long_label + "\n";
+
+	for (std::size_t chunk_size : {std::size_t(7), std::size_t(16), std::size_t(33)})
+	{
+		directed::chart_type chart;
+		directed::read(text, chart, 3, chunk_size);
+		BOOST_REQUIRE_EQUAL(chart.num_edges(), 51u);
+		std::size_t wrong = 0;
+		for (std::size_t e = 0; e < 50; ++e)
+		{
+			wrong += (chart.get_edge(chart.get_edge_at(e))->get_obj().text != "label " + std::to_string(e));
+		}
+		BOOST_CHECK_EQUAL(wrong, 0u);
+		BOOST_CHECK(chart.get_edge(chart.get_edge_at(50))->get_obj().text == long_label);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(malformed_lines)
+{
+	for (const char* text : {"0 1\nx 2\n", "0 -1\n", "0 1x\n", "7 label but no target\n", "0 1\n2 99999999999999999999\n", "18446744073709551615 0\n"})
+	{
+		directed::chart_type chart;
+		BOOST_CHECK_THROW(directed::read(text, chart, 2, 1 << 10), std::runtime_error);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(numbers_beyond_max_vertices)
+{
+	// Would size the tables to the number: rejected before allocating
+	directed::chart_type chart;
+	std::istringstream in("0 99999999999\n");
+	BOOST_CHECK_THROW(read_edge_list(in, chart, [](std::size_t) { return std::make_shared<directed::node>();},
+		[](const char* begin, const char* end) { return std::make_shared<directed::link>(std::string(begin, end));}, 1, 1 << 10), std::runtime_error);
+
+	std::istringstream small("0 10\n");
+	BOOST_CHECK_THROW(read_edge_list(small, chart, [](std::size_t) { return std::make_shared<directed::node>();},
+		[](const char* begin, const char* end) { return std::make_shared<directed::link>(std::string(begin, end));}, 1, 1 << 10, 10), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(graphviz)
+{
+	undirected::chart_type chart;
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		chart.add_vertex(std::make_shared<undirected::node>());
+	}
+	chart.add_edge(std::make_shared<undirected::link>("say \"hi\""), chart.get_vertex_at(0), chart.get_vertex_at(1));
+	chart.add_edge(std::make_shared<undirected::link>(""), chart.get_vertex_at(1), chart.get_vertex_at(2));
+
+	std::ostringstream out;
+	write_graphviz(out, chart, no_label(), undirected::tag_label());
+	BOOST_CHECK_EQUAL(out.str(), "graph G {\n0;\n1;\n2;\n0--1 [label=\"say \\\"hi\\\"\"];\n1--2;\n}\n");
+
+	directed::chart_type digraph;
+	digraph.add_vertex(std::make_shared<directed::node>());
+	digraph.add_edge(std::make_shared<directed::link>("loop"), digraph.get_vertex_at(0), digraph.get_vertex_at(0));
+	std::ostringstream digraph_out;
+	write_graphviz(digraph_out, digraph);
+	BOOST_CHECK_EQUAL(digraph_out.str(), "digraph G {\n0;\n0->0;\n}\n");
+}
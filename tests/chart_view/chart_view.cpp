@@ -0,0 +1,105 @@
+#define BOOST_TEST_MODULE chart_view
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/breadth_first_search.hpp>
+
+#include "chart_impl.hpp"
+#include "chart_view.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct link;
+struct node;
+typedef chart<node, link, BIDIRECTIONAL> bidirectional_chart;
+struct node : detail::vertex<link, BIDIRECTIONAL, bidirectional_chart> {};
+struct link : detail::edge<node, link, BIDIRECTIONAL, bidirectional_chart> {};
+
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS> reference_graph;
+
+struct not_multiple_of_three
+{
+	// Keeps two vertices out of three, by dense index
+	const bidirectional_chart* chart;
+	bool operator()(const bidirectional_chart::vertex_id& v) const { return chart->get_vertex_index(v) % 3 != 0;};
+};
+
+void make_random(bidirectional_chart& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	for (std::size_t i = 0; i < n_vertices; ++i)
+	{
+		chart.add_vertex(std::make_shared<node>());
+	}
+	for (std::size_t i = 0; i < n_edges; ++i)
+	{
+		chart.create_edge(chart.get_vertex_at(rng() % n_vertices), chart.get_vertex_at(rng() % n_vertices));
+	}
+}
+
+template <class Keep>
+reference_graph copy_of(const bidirectional_chart& chart, Keep keep, bool reversed)
+{
+	// Edges between the vertices kept, keyed by the dense indices of the chart
+	reference_graph graph(chart.num_vertices());
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const bidirectional_chart::edge_id edge = chart.get_edge_at(e);
+		const std::size_t source = chart.get_vertex_index(chart.get_source(edge)), target = chart.get_vertex_index(chart.get_target(edge));
+		if (keep(source) && keep(target))
+		{
+			reversed ? boost::add_edge(target, source, graph) : boost::add_edge(source, target, graph);
+		}
+	}
+	return graph;
+}
+
+std::vector<std::size_t> distances(const reference_graph& graph, std::size_t source)
+{
+	std::vector<std::size_t> distance(boost::num_vertices(graph), std::size_t(-1));
+	distance[source] = 0;
+	boost::breadth_first_search(graph, source, boost::visitor(boost::make_bfs_visitor(
+		boost::record_distances(boost::make_iterator_property_map(distance.begin(), boost::get(boost::vertex_index, graph)), boost::on_tree_edge()))));
+	return distance;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(induced_breadth_first_stays_in_the_view)
+{
+	// Dense graphs: the frontier grows enough for bottom-up steps
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		bidirectional_chart chart;
+		make_random(chart, 3000, 60000, seed);
+		const auto view = chart.induced(not_multiple_of_three{&chart});
+		const std::vector<std::size_t> expected = distances(copy_of(chart, [](std::size_t v) { return v % 3 != 0;}, false), 1);
+
+		for (unsigned n_threads : {1u, 4u})
+		{
+			std::vector<std::size_t> distance, parent;
+			view.parallel_breadth_first(chart.get_vertex_at(1), distance, parent, n_threads);
+			BOOST_CHECK(distance == expected);
+			std::size_t outside = 0;
+			for (std::size_t v = 0; v < chart.num_vertices(); v += 3)
+			{
+				outside += (distance[v] != std::size_t(-1) || parent[v] != std::size_t(-1));
+			}
+			BOOST_CHECK_EQUAL(outside, 0u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(reversed_breadth_first)
+{
+	bidirectional_chart chart;
+	make_random(chart, 3000, 30000, 7);
+	const std::vector<std::size_t> expected = distances(copy_of(chart, [](std::size_t) { return true;}, true), 0);
+
+	std::vector<std::size_t> distance, parent;
+	chart.reversed().parallel_breadth_first(chart.get_vertex_at(0), distance, parent, 4);
+	BOOST_CHECK(distance == expected);
+}
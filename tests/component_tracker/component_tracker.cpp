@@ -0,0 +1,159 @@
+#define BOOST_TEST_MODULE component_tracker
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <algorithm>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	static std::size_t mismatches(chart_type& chart)
+	{
+		// Tracker against a full run (weakly connected components for directed charts)
+		std::vector<std::size_t> component;
+		const std::size_t n_components = chart.connected_components(component, 1);
+		std::size_t errors = (n_components != chart.num_components());
+
+		std::vector<std::size_t> label(n_components, std::size_t(-1));
+		for (std::size_t index = 0; index < component.size(); ++index)
+		{
+			const std::size_t l = chart.component_of(chart.get_vertex_at(index));
+			if (label[component[index]] == std::size_t(-1))
+			{
+				label[component[index]] = l;
+			}
+			errors += (label[component[index]] != l);
+		}
+		std::sort(label.begin(), label.end());
+		errors += (std::unique(label.begin(), label.end()) != label.end());
+
+		if (chart.num_vertices() > 1)
+		{
+			const std::size_t last = chart.num_vertices() - 1;
+			errors += (chart.same_component(chart.get_vertex_at(0), chart.get_vertex_at(last)) != (component[0] == component[last]));
+		}
+		return errors;
+	};
+
+	static void random_mutations(unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		chart_type chart;
+		for (std::size_t i = 0; i < 150; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>());
+		}
+		chart.enable_component_tracking();
+		BOOST_REQUIRE_EQUAL(mismatches(chart), 0u);
+
+		for (std::size_t round = 0; round < 1000; ++round)
+		{
+			switch (rng() % 6)
+			{
+				case 0:
+					chart.add_vertex(std::make_shared<node>());
+					break;
+				case 1:
+				case 2:
+				case 3:
+					if (chart.num_vertices())
+					{
+						chart.create_edge(chart.get_vertex_at(rng() % chart.num_vertices()), chart.get_vertex_at(rng() % chart.num_vertices()));
+					}
+					break;
+				case 4:
+					if (chart.num_edges())
+					{
+						chart.remove_edge(chart.get_edge_at(rng() % chart.num_edges()));
+					}
+					break;
+				default:
+					if (chart.num_vertices())
+					{
+						chart.remove_vertex(chart.get_vertex_at(rng() % chart.num_vertices()));
+					}
+			}
+			if (rng() % 4 == 0)
+			{
+				BOOST_REQUIRE_EQUAL(mismatches(chart), 0u);
+			}
+		}
+		BOOST_CHECK_EQUAL(mismatches(chart), 0u);
+
+		chart.clear();
+		BOOST_CHECK_EQUAL(chart.num_components(), 0u);
+		chart.add_vertex(std::make_shared<node>());
+		BOOST_CHECK_EQUAL(chart.num_components(), 1u);
+	};
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(undirected_matches_full_run)
+{
+	graph<UNDIRECTED>::random_mutations(1);
+	graph<UNDIRECTED>::random_mutations(2);
+}
+
+BOOST_AUTO_TEST_CASE(bidirectional_matches_full_run)
+{
+	graph<BIDIRECTIONAL>::random_mutations(1);
+	graph<BIDIRECTIONAL>::random_mutations(2);
+}
+
+BOOST_AUTO_TEST_CASE(directed_matches_full_run)
+{
+	graph<DIRECTED>::random_mutations(1);
+	graph<DIRECTED>::random_mutations(2);
+}
+
+BOOST_AUTO_TEST_CASE(split_by_removal)
+{
+	// A path cut in the middle, only the dirty component is rebuilt
+	typedef graph<UNDIRECTED>::chart_type chart_type;
+	chart_type chart;
+	chart.enable_component_tracking();
+	std::vector<chart_type::vertex_id> path;
+	for (std::size_t i = 0; i < 6; ++i)
+	{
+		path.push_back(chart.add_vertex(std::make_shared<graph<UNDIRECTED>::node>()).first);
+	}
+	std::vector<chart_type::edge_id> edges;
+	for (std::size_t i = 0; i + 1 < path.size(); ++i)
+	{
+		edges.push_back(chart.create_edge(path[i], path[i + 1]).first);
+	}
+	BOOST_CHECK_EQUAL(chart.num_components(), 1u);
+	BOOST_CHECK(chart.same_component(path[0], path[5]));
+
+	chart.remove_edge(edges[2]);
+	BOOST_CHECK_EQUAL(chart.num_components(), 2u);
+	BOOST_CHECK(chart.same_component(path[0], path[2]));
+	BOOST_CHECK(chart.same_component(path[3], path[5]));
+	BOOST_CHECK(!chart.same_component(path[2], path[3]));
+	BOOST_CHECK_NE(chart.component_of(path[0]), chart.component_of(path[5]));
+}
+
+BOOST_AUTO_TEST_CASE(queries_need_tracking)
+{
+	graph<UNDIRECTED>::chart_type chart;
+	BOOST_CHECK(!chart.is_component_tracking_enabled());
+	BOOST_CHECK_THROW(chart.num_components(), std::runtime_error);
+	chart.enable_component_tracking();
+	BOOST_CHECK_EQUAL(chart.num_components(), 0u);
+	chart.disable_component_tracking();
+	BOOST_CHECK_THROW(chart.num_components(), std::runtime_error);
+}
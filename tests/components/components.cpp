@@ -0,0 +1,85 @@
+#define BOOST_TEST_MODULE components
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include "chart_impl.hpp"
+#include "components.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct link;
+struct node;
+typedef chart<node, link, UNDIRECTED> undirected_chart;
+struct node : detail::vertex<link, UNDIRECTED, undirected_chart> {};
+struct link : detail::edge<node, link, UNDIRECTED, undirected_chart> {};
+
+void make_random(undirected_chart& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+{
+	// Sparse enough to leave many components, then a few vertices removed to reshuffle the dense indices
+	std::mt19937 rng(seed);
+	std::vector<undirected_chart::vertex_id> vertices;
+	for (std::size_t i = 0; i < n_vertices; ++i)
+	{
+		vertices.push_back(chart.add_vertex(std::make_shared<node>()).first);
+	}
+	for (std::size_t i = 0; i < n_edges; ++i)
+	{
+		chart.create_edge(vertices[rng() % n_vertices], vertices[rng() % n_vertices]);
+	}
+	for (std::size_t i = 0; i < n_vertices/20; ++i)
+	{
+		chart.remove_vertex(chart.get_vertex_at(rng() % chart.num_vertices()));
+	}
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(parallel_matches_serial)
+{
+	for (unsigned seed = 0; seed < 20; ++seed)
+	{
+		undirected_chart chart;
+		make_random(chart, 2000, 1800, seed);
+
+		undirected_chart::_t_connected_components serial;
+		const std::size_t n_serial = chart.connected_components(serial);
+		for (unsigned n_threads : {1u, 2u, 4u, 0u})
+		{
+			std::vector<std::size_t> component;
+			BOOST_CHECK_EQUAL(chart.connected_components(component, n_threads), n_serial);
+			BOOST_REQUIRE_EQUAL(component.size(), chart.num_vertices());
+			std::size_t mismatches = 0;
+			for (std::size_t index = 0; index < component.size(); ++index)
+			{
+				mismatches += (component[index] != serial[chart.get_vertex_at(index)]);
+			}
+			BOOST_CHECK_EQUAL(mismatches, 0u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(numbered_in_order_of_first_vertex)
+{
+	// Two triangles and an isolated vertex, given in an order that mixes them
+	const std::size_t endpoints[][2] = {{4, 5}, {1, 3}, {5, 6}, {3, 0}, {6, 4}, {0, 1}};
+	std::vector<std::size_t> component;
+	const std::size_t n_components = detail::parallel_connected_components(7, 6, [&](std::size_t e)
+	{
+		return std::make_pair(endpoints[e][0], endpoints[e][1]);
+	}, component, 3);
+
+	BOOST_CHECK_EQUAL(n_components, 3u);
+	const std::size_t expected[] = {0, 0, 1, 0, 2, 2, 2};
+	BOOST_CHECK_EQUAL_COLLECTIONS(component.begin(), component.end(), expected, expected + 7);
+}
+
+BOOST_AUTO_TEST_CASE(empty_chart)
+{
+	undirected_chart chart;
+	std::vector<std::size_t> component(3, 0);
+	BOOST_CHECK_EQUAL(chart.connected_components(component, 2), 0u);
+	BOOST_CHECK(component.empty());
+}
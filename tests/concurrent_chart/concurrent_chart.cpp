@@ -0,0 +1,229 @@
+#define BOOST_TEST_MODULE concurrent_chart
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+#include "chart_impl.hpp"
+#include "concurrent_chart.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct city { std::size_t number;};
+
+struct road;
+struct town;
+typedef chart<town, road, BIDIRECTIONAL> road_chart;
+struct town : detail::vertex<road, BIDIRECTIONAL, road_chart, city>
+{
+	town(std::size_t number) : detail::vertex<road, BIDIRECTIONAL, road_chart, city>(std::make_shared<city>(city{number})) {};
+};
+struct road : detail::edge<town, road, BIDIRECTIONAL, road_chart> {};
+
+typedef concurrent_chart<road_chart> shared_chart;
+
+void make_ring(road_chart& chart, std::size_t n)
+{
+	std::vector<road_chart::vertex_id> towns;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		towns.push_back(chart.add_vertex(std::make_shared<town>(i)).first);
+	}
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		chart.create_edge(towns[i], towns[(i + 1) % n]);
+	}
+}
+
+bool is_ring(const shared_chart::snapshot_type& snapshot)
+{
+	// Every published version is a single directed cycle over all the vertices
+	if (snapshot.num_vertices() != snapshot.num_edges())
+	{
+		return false;
+	}
+	std::vector<std::size_t> outgoing, incoming;
+	std::set<std::size_t> numbers;
+	std::size_t vertex = 0;
+	for (std::size_t steps = 0; steps < snapshot.num_vertices(); ++steps)
+	{
+		outgoing.clear();
+		incoming.clear();
+		snapshot.get_edges_outgoing(vertex, outgoing);
+		snapshot.get_edges_incoming(vertex, incoming);
+		if (outgoing.size() != 1 || incoming.size() != 1 || snapshot.get_source(outgoing[0]) != vertex || snapshot.get_target(incoming[0]) != vertex)
+		{
+			return false;
+		}
+		numbers.insert(snapshot.get_vertex_obj(vertex).number);
+		vertex = snapshot.get_target(outgoing[0]);
+		if (vertex == 0 && steps + 1 != snapshot.num_vertices())
+		{
+			return false;
+		}
+	}
+	return vertex == 0 && numbers.size() == snapshot.num_vertices();
+}
+
+void split_edge(road_chart& chart, std::mt19937& rng, std::size_t number)
+{
+	// Inserts the vertex 'number' in the middle of a random edge of the ring
+	const road_chart::edge_id edge = chart.get_edge_at(rng() % chart.num_edges());
+	const road_chart::vertex_id source = chart.get_source(edge), target = chart.get_target(edge);
+	chart.remove_edge(edge);
+	const road_chart::vertex_id middle = chart.add_vertex(std::make_shared<town>(number)).first;
+	chart.create_edge(source, middle);
+	chart.create_edge(middle, target);
+}
+
+void grow_or_shrink(road_chart& chart, std::mt19937& rng, std::size_t& next_number)
+{
+	// Splits a random edge of the ring, or bypasses a random vertex
+	if (chart.num_vertices() < 200 || rng() % 2)
+	{
+		split_edge(chart, rng, next_number++);
+	}
+	else
+	{
+		const road_chart::vertex_id vertex = chart.get_vertex_at(rng() % chart.num_vertices());
+		std::vector<road_chart::edge_id> incoming, outgoing;
+		chart.get_edges_incoming(vertex, incoming);
+		chart.get_edges_outgoing(vertex, outgoing);
+		const road_chart::vertex_id source = chart.get_source(incoming[0]), target = chart.get_target(outgoing[0]);
+		chart.remove_vertex(vertex);
+		chart.create_edge(source, target);
+	}
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(readers_see_whole_versions)
+{
+	// Readers walk every version they get while a writer keeps reshaping the ring
+	shared_chart chart;
+	chart.update([](road_chart& c) { make_ring(c, 100);});
+
+	std::atomic<bool> stop(false);
+	std::atomic<std::size_t> reads(0), torn(0);
+	std::vector<std::thread> readers;
+	for (unsigned r = 0; r < 4; ++r)
+	{
+		readers.emplace_back([&]
+		{
+			std::size_t last_version = 0, n = 0;
+			while (!stop.load())
+			{
+				const shared_chart::snapshot_ptr snapshot = chart.snapshot();
+				const std::size_t version = chart.version();
+				torn += (version < last_version || !is_ring(*snapshot));
+				last_version = version;
+				++n;
+			}
+			reads += n;
+		});
+	}
+
+	std::thread writer([&]
+	{
+		std::mt19937 rng(1);
+		std::size_t next_number = 100;
+		const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+		while (std::chrono::steady_clock::now() < end)
+		{
+			chart.update([&](road_chart& c) { grow_or_shrink(c, rng, next_number);});
+		}
+	});
+	writer.join();
+	stop.store(true);
+	for (std::size_t r = 0; r < readers.size(); ++r)
+	{
+		readers[r].join();
+	}
+
+	BOOST_CHECK_EQUAL(torn.load(), 0u);
+	BOOST_CHECK_GT(reads.load(), 0u);
+	BOOST_CHECK(is_ring(*chart.snapshot()));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_updates_are_all_published)
+{
+	// Several writers, each update returns once a version including it is visible
+	shared_chart chart;
+	chart.update([](road_chart& c) { make_ring(c, 10);});
+	const std::size_t first_version = chart.version();
+
+	std::atomic<std::size_t> missing(0);
+	std::vector<std::thread> writers;
+	for (unsigned w = 0; w < 4; ++w)
+	{
+		writers.emplace_back([&chart, &missing, w]
+		{
+			std::mt19937 rng(w);
+			for (std::size_t i = 0; i < 200; ++i)
+			{
+				const std::size_t number = 1000*(w + 1) + i;
+				chart.update([&](road_chart& c) { split_edge(c, rng, number);});
+
+				// Already visible, maybe through the publication of another writer
+				const shared_chart::snapshot_ptr snapshot = chart.snapshot();
+				bool found = false;
+				for (std::size_t v = 0; v < snapshot->num_vertices() && !found; ++v)
+				{
+					found = (snapshot->get_vertex_obj(v).number == number);
+				}
+				missing += !found;
+			}
+		});
+	}
+	for (std::size_t w = 0; w < writers.size(); ++w)
+	{
+		writers[w].join();
+	}
+
+	BOOST_CHECK_EQUAL(missing.load(), 0u);
+	BOOST_CHECK_EQUAL(chart.version(), first_version + 4*200);
+	BOOST_CHECK_EQUAL(chart.snapshot()->num_vertices(), 10u + 4*200);
+	BOOST_CHECK(is_ring(*chart.snapshot()));
+}
+
+BOOST_AUTO_TEST_CASE(apply_is_published_in_batches)
+{
+	shared_chart chart;
+	const shared_chart::snapshot_ptr empty = chart.snapshot();
+	BOOST_CHECK_EQUAL(chart.version(), 0u);
+
+	for (std::size_t i = 0; i < 10; ++i)
+	{
+		chart.apply([i](road_chart& c) { c.add_vertex(std::make_shared<town>(i));});
+	}
+	BOOST_CHECK_EQUAL(chart.snapshot(), empty);
+	BOOST_CHECK_EQUAL(chart.snapshot()->num_vertices(), 0u);
+
+	chart.publish();
+	const shared_chart::snapshot_ptr batch = chart.snapshot();
+	BOOST_CHECK_EQUAL(chart.version(), 10u);
+	BOOST_REQUIRE_EQUAL(batch->num_vertices(), 10u);
+	BOOST_CHECK_EQUAL(batch->get_vertex_obj(3).number, 3u);
+
+	// Nothing new: the same version is kept
+	chart.publish();
+	BOOST_CHECK_EQUAL(chart.snapshot(), batch);
+}
+
+BOOST_AUTO_TEST_CASE(failed_update_is_published)
+{
+	shared_chart chart;
+	BOOST_CHECK_THROW(chart.update([](road_chart& c)
+	{
+		c.add_vertex(std::make_shared<town>(0));
+		throw std::runtime_error("half done");
+	}), std::runtime_error);
+	BOOST_CHECK_EQUAL(chart.version(), 1u);
+	BOOST_CHECK_EQUAL(chart.snapshot()->num_vertices(), 1u);
+}
@@ -0,0 +1,184 @@
+#define BOOST_TEST_MODULE frozen_chart
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <random>
+
+#include "chart_impl.hpp"
+#include "frozen_chart.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	typedef frozen_chart<detail::chart_impl<node, link, Behaviour> > frozen_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	static void make_random(chart_type& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		// Self-loops and parallel edges included, then some removals to reshuffle the dense indices
+		std::mt19937 rng(seed);
+		for (std::size_t i = 0; i < n_vertices; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>());
+		}
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			chart.create_edge(chart.get_vertex_at(rng() % n_vertices), chart.get_vertex_at(rng() % n_vertices));
+		}
+		for (std::size_t i = 0; i < n_vertices/10; ++i)
+		{
+			chart.remove_vertex(chart.get_vertex_at(rng() % chart.num_vertices()));
+		}
+		for (std::size_t i = 0; i < n_edges/10; ++i)
+		{
+			chart.remove_edge(chart.get_edge_at(rng() % chart.num_edges()));
+		}
+	};
+
+	static std::set<std::size_t> outgoing(const chart_type& chart, std::size_t v)
+	{
+		// Dense indices of the edges boost lists as outgoing (incident for UNDIRECTED)
+		std::set<std::size_t> edges;
+		for (const typename chart_type::edge_id& e : chart.out_edges(chart.get_vertex_at(v)))
+		{
+			edges.insert(chart.get_edge_index(e));
+		}
+		return edges;
+	};
+
+	static std::set<std::size_t> outgoing(const frozen_type& frozen, std::size_t v)
+	{
+		std::vector<std::size_t> edges;
+		frozen.get_edges_outgoing(v, edges);
+		return std::set<std::size_t>(edges.begin(), edges.end());
+	};
+
+	static std::size_t common_mismatches(const chart_type& chart, const frozen_type& frozen)
+	{
+		// Same ids, elements, adjacency and components as the chart
+		std::size_t errors = (frozen.num_vertices() != chart.num_vertices()) + (frozen.num_edges() != chart.num_edges());
+		for (std::size_t v = 0; v < frozen.num_vertices(); ++v)
+		{
+			errors += (frozen.get_chart_vertex_id(v) != chart.get_vertex_at(v));
+			errors += (frozen.get_vertex(v) != chart.get_vertex(chart.get_vertex_at(v)));
+			errors += (outgoing(frozen, v) != outgoing(chart, v));
+		}
+		for (std::size_t e = 0; e < frozen.num_edges(); ++e)
+		{
+			errors += (frozen.get_chart_edge_id(e) != chart.get_edge_at(e));
+			errors += (frozen.get_edge(e) != chart.get_edge(chart.get_edge_at(e)));
+		}
+
+		std::vector<std::size_t> expected, component;
+		const std::size_t n_expected = chart.connected_components(expected, 1);
+		errors += (frozen.connected_components(component, 2) != n_expected) + (component != expected);
+		return errors;
+	};
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(directed_matches_the_chart)
+{
+	typedef graph<DIRECTED> g;
+	g::chart_type chart;
+	g::make_random(chart, 500, 2000, 1);
+	const g::frozen_type frozen = chart.freeze();
+	BOOST_CHECK_EQUAL(g::common_mismatches(chart, frozen), 0u);
+
+	// Sources and targets, from the targets boost lists for every outgoing edge
+	std::size_t errors = 0;
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		const auto edges = chart.out_edges(chart.get_vertex_at(v));
+		const auto targets = chart.adjacent_vertices(chart.get_vertex_at(v));
+		auto target = targets.begin();
+		for (auto e = edges.begin(); e != edges.end(); ++e, ++target)
+		{
+			errors += (frozen.get_source(chart.get_edge_index(*e)) != v) + (frozen.get_target(chart.get_edge_index(*e)) != chart.get_vertex_index(*target));
+		}
+	}
+	BOOST_CHECK_EQUAL(errors, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(bidirectional_matches_the_chart)
+{
+	typedef graph<BIDIRECTIONAL> g;
+	g::chart_type chart;
+	g::make_random(chart, 500, 2000, 2);
+	const g::frozen_type frozen = chart.freeze();
+	BOOST_CHECK_EQUAL(g::common_mismatches(chart, frozen), 0u);
+
+	std::size_t errors = 0;
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		std::vector<g::chart_type::edge_id> live;
+		std::vector<std::size_t> edges;
+		chart.get_edges_incoming(chart.get_vertex_at(v), live);
+		frozen.get_edges_incoming(v, edges);
+		std::set<std::size_t> expected;
+		for (std::size_t e = 0; e < live.size(); ++e)
+		{
+			expected.insert(chart.get_edge_index(live[e]));
+		}
+		errors += (std::set<std::size_t>(edges.begin(), edges.end()) != expected) + (edges.size() != live.size());
+	}
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const g::chart_type::edge_id id = chart.get_edge_at(e);
+		errors += (frozen.get_source(e) != chart.get_vertex_index(chart.get_source(id)));
+		errors += (frozen.get_target(e) != chart.get_vertex_index(chart.get_target(id)));
+	}
+	BOOST_CHECK_EQUAL(errors, 0u);
+	BOOST_CHECK_EQUAL(frozen.get_in_edges().size(), chart.num_edges());
+}
+
+BOOST_AUTO_TEST_CASE(undirected_matches_the_chart)
+{
+	typedef graph<UNDIRECTED> g;
+	g::chart_type chart;
+	g::make_random(chart, 500, 2000, 3);
+	const g::frozen_type frozen = chart.freeze();
+	BOOST_CHECK_EQUAL(g::common_mismatches(chart, frozen), 0u);
+
+	std::size_t errors = 0;
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const std::pair<g::chart_type::vertex_id, g::chart_type::vertex_id> ends = chart.get_connected(chart.get_edge_at(e));
+		const std::pair<std::size_t, std::size_t> frozen_ends = frozen.get_connected(e);
+		errors += (frozen_ends.first != chart.get_vertex_index(ends.first)) + (frozen_ends.second != chart.get_vertex_index(ends.second));
+	}
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		std::vector<std::size_t> incoming, outgoing;
+		frozen.get_edges_incoming(v, incoming);
+		frozen.get_edges_outgoing(v, outgoing);
+		errors += (incoming != outgoing);
+	}
+	BOOST_CHECK_EQUAL(errors, 0u);
+
+	// Incoming edges are the outgoing ones, not a copy
+	BOOST_CHECK_EQUAL(&frozen.get_in_edges(), &frozen.get_out_edges());
+	BOOST_CHECK_EQUAL(&frozen.get_in_offsets(), &frozen.get_out_offsets());
+}
+
+BOOST_AUTO_TEST_CASE(later_changes_are_not_reflected)
+{
+	typedef graph<BIDIRECTIONAL> g;
+	g::chart_type chart;
+	g::make_random(chart, 50, 100, 4);
+	const g::frozen_type frozen = chart.freeze();
+	const std::size_t n_edges = chart.num_edges();
+	chart.create_edge(chart.get_vertex_at(0), chart.get_vertex_at(1));
+	chart.add_vertex(std::make_shared<g::node>());
+	BOOST_CHECK_EQUAL(frozen.num_edges(), n_edges);
+	BOOST_CHECK_EQUAL(frozen.num_vertices(), chart.num_vertices() - 1);
+}
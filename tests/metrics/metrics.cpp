@@ -0,0 +1,231 @@
+#define BOOST_TEST_MODULE metrics
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <thread>
+#include <numeric>
+#include <type_traits>
+
+#include "chart_impl.hpp"
+
+namespace test_types {
+
+// Charts of these types are instrumented, see the specialization below
+struct instrumented_link;
+struct instrumented_node;
+typedef core::graph::chart<instrumented_node, instrumented_link, core::graph::BIDIRECTIONAL> instrumented_chart;
+struct instrumented_node : core::graph::detail::vertex<instrumented_link, core::graph::BIDIRECTIONAL, instrumented_chart> {};
+struct instrumented_link : core::graph::detail::edge<instrumented_node, instrumented_link, core::graph::BIDIRECTIONAL, instrumented_chart> {};
+
+struct undirected_link;
+struct undirected_node;
+typedef core::graph::chart<undirected_node, undirected_link, core::graph::UNDIRECTED> undirected_chart;
+struct undirected_node : core::graph::detail::vertex<undirected_link, core::graph::UNDIRECTED, undirected_chart> {};
+struct undirected_link : core::graph::detail::edge<undirected_node, undirected_link, core::graph::UNDIRECTED, undirected_chart> {};
+
+struct link;
+struct node;
+typedef core::graph::chart<node, link, core::graph::BIDIRECTIONAL> plain_chart;
+struct node : core::graph::detail::vertex<link, core::graph::BIDIRECTIONAL, plain_chart> {};
+struct link : core::graph::detail::edge<node, link, core::graph::BIDIRECTIONAL, plain_chart> {};
+
+}
+
+namespace core { namespace graph {
+
+template <>
+struct chart_instrumentation<test_types::instrumented_node, test_types::instrumented_link, BIDIRECTIONAL>
+{
+	static const bool enabled = true;
+};
+
+template <>
+struct chart_instrumentation<test_types::undirected_node, test_types::undirected_link, UNDIRECTED>
+{
+	static const bool enabled = true;
+};
+
+}}
+
+using namespace core::graph;
+using namespace test_types;
+
+// Disabled instrumentation stores nothing and times nothing
+static_assert(std::is_same<plain_chart::metrics_type, detail::no_metrics_collector>::value, "charts are not instrumented by default");
+static_assert(std::is_same<instrumented_chart::metrics_type, detail::metrics_collector>::value, "the specialization instruments the chart");
+static_assert(std::is_empty<detail::no_metrics_collector>::value, "no counters when disabled");
+static_assert(std::is_empty<detail::no_metrics_collector::scope>::value && std::is_trivially_destructible<detail::no_metrics_collector::scope>::value, "no clock reads when disabled");
+static_assert(sizeof(plain_chart) + sizeof(detail::metrics_collector) <= sizeof(instrumented_chart) + alignof(detail::metrics_collector), "the counters are the only difference");
+
+namespace {
+
+std::uint64_t histogram_total(const chart_metrics::operation& op)
+{
+	return std::accumulate(op.histogram, op.histogram + chart_metrics::n_buckets, std::uint64_t(0));
+}
+
+template <class Chart>
+void mutate(Chart& chart)
+{
+	// 10 vertices, 20 edges, 5 edges removed, a vertex with 3 edges removed, 2 lookups, 1 components
+	std::vector<typename Chart::vertex_id> v;
+	for (std::size_t i = 0; i < 10; ++i)
+	{
+		v.push_back(chart.add_vertex(std::make_shared<typename Chart::vertex_type>()).first);
+	}
+	std::vector<typename Chart::edge_id> e;
+	for (std::size_t i = 0; i < 20; ++i)
+	{
+		e.push_back(chart.create_edge(v[1 + i % 9], v[1 + (i + 1) % 9]).first);
+	}
+	for (std::size_t i = 0; i < 5; ++i)
+	{
+		chart.remove_edge(e[i]);
+	}
+	chart.create_edge(v[0], v[1]);
+	chart.create_edge(v[2], v[0]);
+	chart.create_edge(v[0], v[0]);
+	chart.remove_vertex(v[0]);
+	chart.get_vertex_id(chart.get_vertex(v[1]));
+	chart.get_edge_id(chart.get_edge(e[10]));
+	typename Chart::_t_connected_components components;
+	chart.connected_components(components);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(operations_are_counted)
+{
+	instrumented_chart chart;
+	mutate(chart);
+	const chart_metrics metrics = chart.get_metrics();
+	BOOST_CHECK(metrics.enabled);
+
+	const std::uint64_t expected[chart_metrics::N_OPERATIONS] = {10, 1, 23, 5 + 3, 2, 1};
+	for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+	{
+		BOOST_TEST_CONTEXT(chart_metrics::operation_name(static_cast<chart_metrics::_e_operation>(op)))
+		{
+			BOOST_CHECK_EQUAL(metrics.operations[op].calls, expected[op]);
+			BOOST_CHECK_EQUAL(histogram_total(metrics.operations[op]), expected[op]);
+			BOOST_CHECK_GT(metrics.operations[op].total_ns, 0u);
+			BOOST_CHECK_GE(metrics.operations[op].percentile_ns(1.0), metrics.operations[op].mean_ns());
+		}
+	}
+
+	BOOST_CHECK_EQUAL(metrics.vertices, 9u);
+	BOOST_CHECK_EQUAL(metrics.edges, 15u);
+	BOOST_CHECK_GE(metrics.peak_degree, metrics.max_degree);
+	BOOST_CHECK_GE(metrics.peak_degree, 6u); // v[0] with its self-loop, or the vertices of the ring
+	BOOST_CHECK_GT(metrics.vertex_index_bytes, 0u);
+	BOOST_CHECK_GT(metrics.edge_index_bytes, 0u);
+	BOOST_CHECK_GT(metrics.arena_bytes, 0u);
+
+	// Reset clears the operations, not the peak degree
+	chart.reset_metrics();
+	const chart_metrics after = chart.get_metrics();
+	for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+	{
+		BOOST_CHECK_EQUAL(after.operations[op].calls, 0u);
+		BOOST_CHECK_EQUAL(histogram_total(after.operations[op]), 0u);
+	}
+	BOOST_CHECK_EQUAL(after.peak_degree, metrics.peak_degree);
+	chart.add_vertex(std::make_shared<instrumented_node>());
+	BOOST_CHECK_EQUAL(chart.get_metrics().operations[chart_metrics::ADD_VERTEX].calls, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(self_loops_removed_once)
+{
+	// UNDIRECTED charts list self-loops twice among the edges of the vertex, they are removed once
+	undirected_chart chart;
+	const undirected_chart::vertex_id a = chart.add_vertex(std::make_shared<undirected_node>()).first;
+	const undirected_chart::vertex_id b = chart.add_vertex(std::make_shared<undirected_node>()).first;
+	chart.create_edge(a, a);
+	chart.create_edge(a, a);
+	chart.create_edge(a, b);
+	chart.remove_vertex(a);
+	BOOST_CHECK_EQUAL(chart.get_metrics().operations[chart_metrics::REMOVE_EDGE].calls, 3u);
+	BOOST_CHECK_EQUAL(chart.num_edges(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_buckets)
+{
+	// Bucket 'b' holds [2^b, 2^(b+1)) ns, under 2ns and negative durations go to bucket 0
+	detail::metrics_collector collector;
+	const std::int64_t durations[] = {-5, 0, 1, 2, 3, 4, 1023, 1024, std::int64_t(1) << 50};
+	for (std::int64_t ns : durations)
+	{
+		collector.record(chart_metrics::LOOKUP, ns);
+	}
+	chart_metrics metrics;
+	collector.collect(metrics);
+	const chart_metrics::operation& lookup = metrics.operations[chart_metrics::LOOKUP];
+	BOOST_CHECK_EQUAL(lookup.calls, 9u);
+	BOOST_CHECK_EQUAL(lookup.total_ns, 0u + 1 + 2 + 3 + 4 + 1023 + 1024 + (std::uint64_t(1) << 50));
+	BOOST_CHECK_EQUAL(lookup.histogram[0], 3u);
+	BOOST_CHECK_EQUAL(lookup.histogram[1], 2u);
+	BOOST_CHECK_EQUAL(lookup.histogram[2], 1u);
+	BOOST_CHECK_EQUAL(lookup.histogram[9], 1u);
+	BOOST_CHECK_EQUAL(lookup.histogram[10], 1u);
+	BOOST_CHECK_EQUAL(lookup.histogram[chart_metrics::n_buckets - 1], 1u); // beyond the last bucket
+	BOOST_CHECK_EQUAL(metrics.operations[chart_metrics::ADD_EDGE].calls, 0u);
+
+	// Percentiles are upper bounds of buckets
+	BOOST_CHECK_EQUAL(lookup.percentile_ns(0.3), 2u);
+	BOOST_CHECK_EQUAL(lookup.percentile_ns(0.5), 4u);
+	BOOST_CHECK_EQUAL(lookup.percentile_ns(0.8), 2048u);
+	BOOST_CHECK_EQUAL(chart_metrics::operation().percentile_ns(0.5), 0u);
+	BOOST_CHECK_EQUAL(chart_metrics::operation().mean_ns(), 0.0);
+
+	collector.observe_degree(7);
+	collector.observe_degree(3);
+	collector.collect(metrics);
+	BOOST_CHECK_EQUAL(metrics.peak_degree, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_recording)
+{
+	// Threads write to their own shards, the totals add up
+	detail::metrics_collector collector;
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < 8; ++t)
+	{
+		threads.push_back(std::thread([&collector, t]()
+		{
+			for (unsigned i = 0; i < 10000; ++i)
+			{
+				collector.record(chart_metrics::LOOKUP, i % 100);
+			}
+			collector.observe_degree(t);
+		}));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	chart_metrics metrics;
+	collector.collect(metrics);
+	BOOST_CHECK_EQUAL(metrics.operations[chart_metrics::LOOKUP].calls, 80000u);
+	BOOST_CHECK_EQUAL(histogram_total(metrics.operations[chart_metrics::LOOKUP]), 80000u);
+	BOOST_CHECK_EQUAL(metrics.operations[chart_metrics::LOOKUP].total_ns, 8u*100*4950);
+	BOOST_CHECK_EQUAL(metrics.peak_degree, 7u);
+}
+
+BOOST_AUTO_TEST_CASE(disabled_instrumentation)
+{
+	// Same operations, nothing counted, the sizes and memory are still reported
+	plain_chart chart;
+	mutate(chart);
+	const chart_metrics metrics = chart.get_metrics();
+	BOOST_CHECK(!metrics.enabled);
+	for (std::size_t op = 0; op < chart_metrics::N_OPERATIONS; ++op)
+	{
+		BOOST_CHECK_EQUAL(metrics.operations[op].calls, 0u);
+		BOOST_CHECK_EQUAL(metrics.operations[op].total_ns, 0u);
+		BOOST_CHECK_EQUAL(histogram_total(metrics.operations[op]), 0u);
+	}
+	BOOST_CHECK_EQUAL(metrics.peak_degree, 0u);
+	BOOST_CHECK_EQUAL(metrics.vertices, 9u);
+	BOOST_CHECK_EQUAL(metrics.edges, 15u);
+	BOOST_CHECK_GT(metrics.max_degree, 0u);
+}
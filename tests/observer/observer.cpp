@@ -0,0 +1,347 @@
+#define BOOST_TEST_MODULE observer
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+#include "chart_impl.hpp"
+
+namespace test_types {
+
+// Charts of these types have a compile-time listener, see the specialization below
+struct static_link;
+struct static_node;
+typedef core::graph::chart<static_node, static_link, core::graph::BIDIRECTIONAL> static_chart;
+struct static_node : core::graph::detail::vertex<static_link, core::graph::BIDIRECTIONAL, static_chart> {};
+struct static_link : core::graph::detail::edge<static_node, static_link, core::graph::BIDIRECTIONAL, static_chart> {};
+
+std::vector<std::string> deliveries; // "static" and "dynamic" in the order the listeners are called
+std::size_t static_events = 0;
+
+}
+
+namespace core { namespace graph {
+
+template <>
+struct static_listener<test_types::static_node, test_types::static_link, BIDIRECTIONAL>
+{
+	static const bool enabled = true;
+
+	template <class Chart>
+	static void on_events(const std::vector<chart_event<Chart> >& events, Chart&)
+	{
+		test_types::deliveries.push_back("static");
+		test_types::static_events += events.size();
+	};
+};
+
+}}
+
+using namespace core::graph;
+
+namespace {
+
+struct link;
+struct node;
+typedef chart<node, link, BIDIRECTIONAL> chart_type;
+struct node : detail::vertex<link, BIDIRECTIONAL, chart_type> {};
+struct link : detail::edge<node, link, BIDIRECTIONAL, chart_type> {};
+
+typedef detail::chart_impl<node, link, BIDIRECTIONAL> impl_type; // what listeners are given
+typedef chart_type::event_type event_type;
+
+struct recording_listener : chart_type::listener_type
+{
+	// Batches as delivered, guarded for the dispatcher thread
+	void on_events(const std::vector<event_type>& events, impl_type&)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		batches.push_back(events);
+		count += events.size();
+	};
+
+	std::size_t total() const { return count.load();};
+
+	std::mutex mutex;
+	std::vector<std::vector<event_type> > batches;
+	std::atomic<std::size_t> count{0};
+};
+
+std::vector<event_type> all_events(const recording_listener& listener)
+{
+	std::vector<event_type> events;
+	for (const std::vector<event_type>& batch : listener.batches)
+	{
+		events.insert(events.end(), batch.begin(), batch.end());
+	}
+	return events;
+}
+
+impl_type::vertex_id add_node(impl_type& chart)
+{
+	return chart.add_vertex(std::make_shared<node>()).first;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(registration)
+{
+	// Nothing is queued until events are enabled, listeners receive what happens once registered
+	chart_type chart;
+	add_node(chart);
+	BOOST_CHECK(chart.get_observer() == 0);
+
+	chart_type::observer_type& observer = chart.enable_events();
+	BOOST_CHECK(chart.get_observer() == &observer);
+	BOOST_CHECK(&chart.enable_events() == &observer);
+	BOOST_CHECK_EQUAL(observer.pending(), 0u);
+
+	std::shared_ptr<recording_listener> first = std::make_shared<recording_listener>(), second = std::make_shared<recording_listener>();
+	observer.add_listener(first);
+	observer.add_listener(second);
+	add_node(chart);
+	observer.flush();
+	BOOST_CHECK_EQUAL(first->total(), 1u);
+	BOOST_CHECK_EQUAL(second->total(), 1u);
+
+	observer.remove_listener(first);
+	add_node(chart);
+	observer.flush();
+	BOOST_CHECK_EQUAL(first->total(), 1u);
+	BOOST_CHECK_EQUAL(second->total(), 2u);
+
+	// Pending events are delivered when disabled
+	add_node(chart);
+	chart.disable_events();
+	BOOST_CHECK(chart.get_observer() == 0);
+	BOOST_CHECK_EQUAL(second->total(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(kinds_and_elements)
+{
+	chart_type chart;
+	chart_type::observer_type& observer = chart.enable_events();
+	std::shared_ptr<recording_listener> listener = std::make_shared<recording_listener>();
+	observer.add_listener(listener);
+
+	const chart_type::vertex_id a = add_node(chart), b = add_node(chart);
+	const chart_type::edge_id e = chart.create_edge(a, b).first;
+	const chart_type::edge_type_ptr edge = chart.get_edge(e);
+	const chart_type::vertex_type_ptr vertex = chart.get_vertex(b);
+	chart.remove_edge(e);
+	chart.remove_vertex(b);
+	BOOST_CHECK_EQUAL(listener->total(), 0u);
+	BOOST_CHECK_EQUAL(observer.pending(), 5u);
+	observer.flush();
+	BOOST_CHECK_EQUAL(observer.pending(), 0u);
+	BOOST_REQUIRE_EQUAL(listener->batches.size(), 1u);
+
+	const std::vector<event_type>& events = listener->batches[0];
+	BOOST_REQUIRE_EQUAL(events.size(), 5u);
+	BOOST_CHECK(events[0].kind == event_type::VERTEX_ADDED && events[0].vertex == chart.get_vertex(a) && !events[0].edge);
+	BOOST_CHECK(events[1].kind == event_type::VERTEX_ADDED && events[1].vertex == vertex);
+	BOOST_CHECK(events[2].kind == event_type::EDGE_ADDED && events[2].edge == edge && !events[2].vertex);
+	BOOST_CHECK(events[3].kind == event_type::EDGE_REMOVED && events[3].edge == edge);
+	BOOST_CHECK(events[4].kind == event_type::VERTEX_REMOVED && events[4].vertex == vertex);
+
+	observer.flush(); // nothing pending, nothing delivered
+	BOOST_CHECK_EQUAL(listener->batches.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(batching)
+{
+	// A full ring is delivered from the mutation that finds it full, the rest on 'flush'
+	chart_type chart;
+	chart_type::observer_type& observer = chart.enable_events(3); // rounded up to 4
+	std::shared_ptr<recording_listener> listener = std::make_shared<recording_listener>();
+	observer.add_listener(listener);
+
+	std::vector<chart_type::vertex_id> vertices;
+	for (std::size_t i = 0; i < 10; ++i)
+	{
+		vertices.push_back(add_node(chart));
+	}
+	BOOST_REQUIRE_EQUAL(listener->batches.size(), 2u);
+	BOOST_CHECK_EQUAL(listener->batches[0].size(), 4u);
+	BOOST_CHECK_EQUAL(listener->batches[1].size(), 4u);
+	BOOST_CHECK_EQUAL(observer.pending(), 2u);
+	observer.flush();
+	BOOST_REQUIRE_EQUAL(listener->batches.size(), 3u);
+	BOOST_CHECK_EQUAL(listener->batches[2].size(), 2u);
+
+	// In the order they happened
+	const std::vector<event_type> events = all_events(*listener);
+	for (std::size_t i = 0; i < vertices.size(); ++i)
+	{
+		BOOST_CHECK(events[i].vertex == chart.get_vertex(vertices[i]));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_thread)
+{
+	// Delivered periodically from the background thread, elements released by the chart thread
+	chart_type chart;
+	chart_type::observer_type& observer = chart.enable_events(64);
+	std::shared_ptr<recording_listener> listener = std::make_shared<recording_listener>();
+	observer.add_listener(listener);
+	observer.start_dispatcher(std::chrono::milliseconds(1));
+	observer.start_dispatcher(std::chrono::milliseconds(1)); // already running
+
+	std::weak_ptr<node> removed;
+	{
+		const chart_type::vertex_id v = add_node(chart);
+		removed = chart.get_vertex(v);
+		chart.remove_vertex(v);
+	}
+	const std::size_t n = 1000;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		add_node(chart);
+	}
+	for (unsigned wait = 0; wait < 5000 && listener->total() < n + 2; ++wait)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	observer.stop_dispatcher();
+	observer.stop_dispatcher(); // already stopped
+	observer.flush();
+	BOOST_CHECK_EQUAL(listener->total(), n + 2);
+
+	std::vector<event_type> events = all_events(*listener);
+	BOOST_CHECK(events[0].kind == event_type::VERTEX_ADDED && events[1].kind == event_type::VERTEX_REMOVED);
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		BOOST_CHECK(events[i + 2].vertex == chart.get_vertex(chart.get_vertex_at(i)));
+	}
+	events.clear();
+	BOOST_CHECK(!removed.expired());
+	listener->batches.clear(); // the recorded copies were the last owners, the observer kept none
+	BOOST_CHECK(removed.expired());
+
+	// Not delivered after the dispatcher is stopped, until flushed
+	add_node(chart);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	BOOST_CHECK_EQUAL(listener->total(), n + 2);
+	observer.flush();
+	BOOST_CHECK_EQUAL(listener->total(), n + 3);
+}
+
+BOOST_AUTO_TEST_CASE(static_listener_first)
+{
+	// Enabled on construction, called before the run-time listeners
+	test_types::deliveries.clear();
+	test_types::static_events = 0;
+	{
+		test_types::static_chart chart;
+		BOOST_REQUIRE(chart.get_observer() != 0);
+
+		struct dynamic_listener : test_types::static_chart::listener_type
+		{
+			void on_events(const std::vector<test_types::static_chart::event_type>&, detail::chart_impl<test_types::static_node, test_types::static_link, BIDIRECTIONAL>&) { test_types::deliveries.push_back("dynamic");};
+		};
+		chart.get_observer()->add_listener(std::make_shared<dynamic_listener>());
+
+		chart.add_vertex(std::make_shared<test_types::static_node>());
+		chart.add_vertex(std::make_shared<test_types::static_node>());
+		chart.get_observer()->flush();
+		BOOST_CHECK(test_types::deliveries == std::vector<std::string>({"static", "dynamic"}));
+		BOOST_CHECK_EQUAL(test_types::static_events, 2u);
+
+		chart.add_vertex(std::make_shared<test_types::static_node>());
+	}
+	// Pending events are delivered when the chart is destroyed
+	BOOST_CHECK_EQUAL(test_types::static_events, 3u);
+	BOOST_CHECK_EQUAL(test_types::deliveries.size(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(listeners_modifying_the_chart)
+{
+	// From 'on_events' a listener may modify the chart and (un)register listeners: no deadlock,
+	// the new events are delivered after the batch within the same flush, the ring grows if needed
+	struct growing_listener : chart_type::listener_type
+	{
+		void on_events(const std::vector<event_type>& events, impl_type& chart)
+		{
+			++calls;
+			for (const event_type& event : events)
+			{
+				if (event.kind == event_type::VERTEX_ADDED && added < 10)
+				{
+					++added;
+					add_node(chart); // more than the ring holds
+				}
+			}
+			if (calls == 1)
+			{
+				chart.get_observer()->add_listener(late);
+				chart.get_observer()->remove_listener(early);
+			}
+		};
+
+		std::size_t calls = 0, added = 0;
+		std::shared_ptr<recording_listener> early, late;
+	};
+
+	chart_type chart;
+	chart_type::observer_type& observer = chart.enable_events(2);
+	std::shared_ptr<growing_listener> growing = std::make_shared<growing_listener>();
+	growing->early = std::make_shared<recording_listener>();
+	growing->late = std::make_shared<recording_listener>();
+	observer.add_listener(growing);
+	observer.add_listener(growing->early);
+
+	add_node(chart);
+	observer.flush();
+	BOOST_CHECK_EQUAL(observer.pending(), 0u);
+	BOOST_CHECK_EQUAL(chart.num_vertices(), 11u);
+	BOOST_CHECK_EQUAL(growing->added, 10u);
+
+	// Unregistered during the first batch, it still gets it; registered then, it gets the rest
+	BOOST_CHECK_EQUAL(growing->early->total(), 1u);
+	BOOST_CHECK_EQUAL(growing->late->total(), 10u);
+	const std::vector<event_type> events = all_events(*growing->late);
+	for (std::size_t i = 0; i < events.size(); ++i)
+	{
+		BOOST_CHECK(events[i].vertex == chart.get_vertex(chart.get_vertex_at(i + 1)));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(dispatcher_listener_registering)
+{
+	// Registering from a delivery of the dispatcher thread does not deadlock either
+	struct registering_listener : chart_type::listener_type
+	{
+		void on_events(const std::vector<event_type>&, impl_type& chart)
+		{
+			if (!done.exchange(true))
+			{
+				chart.get_observer()->add_listener(late);
+			}
+		};
+
+		std::atomic<bool> done{false};
+		std::shared_ptr<recording_listener> late;
+	};
+
+	chart_type chart;
+	chart_type::observer_type& observer = chart.enable_events();
+	std::shared_ptr<registering_listener> registering = std::make_shared<registering_listener>();
+	registering->late = std::make_shared<recording_listener>();
+	observer.add_listener(registering);
+	observer.start_dispatcher(std::chrono::milliseconds(1));
+	add_node(chart);
+	for (unsigned wait = 0; wait < 5000 && !registering->done; ++wait)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	observer.stop_dispatcher();
+	BOOST_CHECK(registering->done);
+
+	add_node(chart);
+	observer.flush();
+	BOOST_CHECK_EQUAL(registering->late->total(), 1u);
+}
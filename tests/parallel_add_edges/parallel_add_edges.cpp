@@ -0,0 +1,342 @@
+#define BOOST_TEST_MODULE parallel_add_edges
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <map>
+#include <thread>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+
+#include "chart_impl.hpp"
+#include "chart_io.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	typedef detail::chart_impl<node, link, Behaviour> impl_type;
+	typedef typename chart_type::event_type event_type;
+	typedef typename chart_type::edge_entry edge_entry;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	struct listener : chart_type::listener_type
+	{
+		void on_events(const std::vector<event_type>& batch, impl_type&)
+		{
+			events.insert(events.end(), batch.begin(), batch.end());
+		};
+
+		std::vector<event_type> events;
+	};
+
+	// Edges attached to the vertex elements, UNDIRECTED vertices have a single set
+	template <class Node>
+	static const typename Node::_t_edges& outgoing(const Node& v, std::true_type) { return v.get_edges();};
+	template <class Node>
+	static const typename Node::_t_edges& outgoing(const Node& v, std::false_type) { return v.get_outgoing();};
+	template <class Node>
+	static const typename Node::_t_edges& incoming(const Node& v, std::true_type) { return v.get_edges();};
+	template <class Node>
+	static const typename Node::_t_edges& incoming(const Node& v, std::false_type) { return v.get_incoming();};
+
+	// Edge lists of the graph, by dense index
+	template <class Chart>
+	static void in_edges(const Chart& chart, const typename chart_type::vertex_id& v, std::vector<std::size_t>& out, std::true_type)
+	{
+		for (const typename chart_type::edge_id& e : chart.in_edges(v))
+		{
+			out.push_back(chart.get_edge_index(e));
+		}
+	};
+	template <class Chart>
+	static void in_edges(const Chart&, const typename chart_type::vertex_id&, std::vector<std::size_t>&, std::false_type) {};
+
+	static std::vector<std::vector<std::size_t> > layout(const chart_type& chart)
+	{
+		/* Everything but the element pointers: per vertex, the edge lists of the graph in
+		   order and the edges attached to the element; per edge, its endpoints.
+		*/
+		typedef std::integral_constant<bool, Behaviour == UNDIRECTED> undirected;
+		std::map<const link*, std::size_t> index;
+		for (std::size_t e = 0; e < chart.num_edges(); ++e)
+		{
+			index[chart.get_edge(chart.get_edge_at(e)).get()] = e;
+		}
+		std::vector<std::vector<std::size_t> > ret;
+		for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+		{
+			const typename chart_type::vertex_id id = chart.get_vertex_at(v);
+			std::vector<std::size_t> lists;
+			for (const typename chart_type::edge_id& e : chart.out_edges(id))
+			{
+				lists.push_back(chart.get_edge_index(e));
+			}
+			lists.push_back(std::size_t(-1));
+			in_edges(chart, id, lists, std::integral_constant<bool, Behaviour == BIDIRECTIONAL>());
+			ret.push_back(lists);
+
+			for (const typename node::_t_edges* attached : {&outgoing(*chart.get_vertex(id), undirected()), &incoming(*chart.get_vertex(id), undirected())})
+			{
+				std::vector<std::size_t> elements;
+				for (const link* edge : *attached)
+				{
+					elements.push_back(index.count(edge) ? index[edge] : std::size_t(-1));
+				}
+				std::sort(elements.begin(), elements.end());
+				ret.push_back(elements);
+			}
+		}
+		detail::edge_endpoints<impl_type> endpoints(chart);
+		for (std::size_t e = 0; e < chart.num_edges(); ++e)
+		{
+			const std::size_t ends[] = {endpoints.source(e), endpoints.target(e)};
+			ret.push_back(std::vector<std::size_t>(ends, ends + 2));
+		}
+		return ret;
+	};
+
+	struct fixture
+	{
+		// A chart with some vertices and edges, events and component tracking enabled
+		fixture(std::size_t n_vertices) : listener(std::make_shared<typename graph::listener>())
+		{
+			chart.enable_component_tracking();
+			chart.enable_events().add_listener(listener);
+			for (std::size_t i = 0; i < n_vertices; ++i)
+			{
+				ids.push_back(chart.add_vertex(std::make_shared<node>()).first);
+			}
+			chart.add_edges(this->make_edges(n_vertices/2, 0));
+			chart.get_observer()->flush();
+			listener->events.clear();
+		};
+
+		std::vector<edge_entry> make_edges(std::size_t n, unsigned seed) const
+		{
+			// Self-loops, parallel edges and repeated entries included
+			std::mt19937 rng(seed);
+			std::vector<edge_entry> edges;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				if (i > 3 && rng() % 8 == 0)
+				{
+					edges.push_back(edges[i - 1 - rng() % 3]);
+				}
+				else
+				{
+					edges.push_back(edge_entry(std::make_shared<link>(), ids[rng() % ids.size()], ids[rng() % ids.size()]));
+				}
+			}
+			return edges;
+		};
+
+		std::vector<std::size_t> positions(const std::vector<edge_entry>& edges) const
+		{
+			// Events by the position of their edge in the input
+			std::vector<std::size_t> ret;
+			chart.get_observer()->flush();
+			for (const event_type& event : listener->events)
+			{
+				BOOST_CHECK(event.kind == event_type::EDGE_ADDED);
+				const std::size_t i = std::find_if(edges.begin(), edges.end(), [&](const edge_entry& e) { return std::get<0>(e) == event.edge;}) - edges.begin();
+				ret.push_back(i);
+			}
+			return ret;
+		};
+
+		chart_type chart;
+		std::shared_ptr<typename graph::listener> listener;
+		std::vector<typename chart_type::vertex_id> ids;
+	};
+};
+
+template <int Behaviour>
+void check_equivalence(std::size_t n_vertices, std::size_t n_edges, unsigned n_threads)
+{
+	// Same chart, ids and notifications as 'add_edges' with the edges in order
+	typedef graph<Behaviour> g;
+	typename g::fixture serial(n_vertices), parallel(n_vertices);
+	const std::vector<typename g::edge_entry> serial_edges = serial.make_edges(n_edges, n_threads + 1);
+	const std::vector<typename g::edge_entry> parallel_edges = parallel.make_edges(n_edges, n_threads + 1);
+
+	const std::vector<typename g::chart_type::edge_id> serial_ids = serial.chart.add_edges(serial_edges);
+	const std::vector<typename g::chart_type::edge_id> parallel_ids = parallel.chart.parallel_add_edges(n_edges, [&](std::size_t i) { return parallel_edges[i];}, n_threads);
+
+	BOOST_REQUIRE_EQUAL(parallel_ids.size(), serial_ids.size());
+	BOOST_REQUIRE_EQUAL(parallel.chart.num_edges(), serial.chart.num_edges());
+	for (std::size_t i = 0; i < n_edges; ++i)
+	{
+		BOOST_CHECK_EQUAL(parallel.chart.get_edge_index(parallel_ids[i]), serial.chart.get_edge_index(serial_ids[i]));
+		BOOST_CHECK(parallel.chart.get_edge(parallel_ids[i]) == std::get<0>(parallel_edges[i]));
+		BOOST_CHECK(parallel.chart.get_edge_id(std::get<0>(parallel_edges[i])) == parallel_ids[i]);
+	}
+	BOOST_CHECK(g::layout(parallel.chart) == g::layout(serial.chart));
+	BOOST_CHECK_EQUAL(parallel.chart.num_components(), serial.chart.num_components());
+
+	const std::vector<std::size_t> serial_events = serial.positions(serial_edges), parallel_events = parallel.positions(parallel_edges);
+	BOOST_CHECK_EQUAL_COLLECTIONS(parallel_events.begin(), parallel_events.end(), serial_events.begin(), serial_events.end());
+
+	// The chart keeps working as usual afterwards
+	for (std::size_t i = 0; i < n_edges; i += 7)
+	{
+		serial.chart.remove_edge(std::get<0>(serial_edges[i]));
+		parallel.chart.remove_edge(std::get<0>(parallel_edges[i]));
+	}
+	serial.chart.add_edges(serial.make_edges(20, 99));
+	parallel.chart.add_edges(parallel.make_edges(20, 99));
+	BOOST_CHECK(g::layout(parallel.chart) == g::layout(serial.chart));
+	BOOST_CHECK_EQUAL(parallel.chart.num_components(), serial.chart.num_components());
+}
+
+template <int Behaviour>
+void check_errors(unsigned n_threads)
+{
+	// Nothing is modified if an edge is connected or the factory throws
+	typedef graph<Behaviour> g;
+	typename g::fixture f(20);
+	const std::vector<std::vector<std::size_t> > before = g::layout(f.chart);
+	const std::size_t components = f.chart.num_components();
+	const std::vector<typename g::edge_entry> edges = f.make_edges(100, 5);
+	const typename g::edge_entry connected(f.chart.get_edge(f.chart.get_edge_at(0)), f.ids[0], f.ids[1]);
+
+	BOOST_CHECK_THROW(f.chart.parallel_add_edges(edges.size(), [&](std::size_t i) { return i == 70 ? connected : edges[i];}, n_threads), std::runtime_error);
+	BOOST_CHECK_THROW(f.chart.parallel_add_edges(edges.size(), [&](std::size_t i) -> typename g::edge_entry
+	{
+		if (i == 30) throw std::logic_error("factory failed");
+		return edges[i];
+	}, n_threads), std::logic_error);
+
+	BOOST_CHECK(g::layout(f.chart) == before);
+	BOOST_CHECK_EQUAL(f.chart.num_components(), components);
+	for (const typename g::edge_entry& e : edges)
+	{
+		BOOST_CHECK(!std::get<0>(e)->is_connected());
+	}
+	BOOST_CHECK(f.positions(edges).empty());
+
+	// Empty batches do nothing
+	BOOST_CHECK(f.chart.parallel_add_edges(0, [&](std::size_t i) { return edges[i];}, n_threads).empty());
+	BOOST_CHECK(g::layout(f.chart) == before);
+}
+
+template <int Behaviour>
+void check_arena_edges(unsigned n_threads)
+{
+	// Edges created by the factory from the chart arena, in several threads
+	typedef graph<Behaviour> g;
+	typename g::fixture f(200);
+	const std::shared_ptr<detail::chart_arena> arena = f.chart.get_arena();
+	const std::size_t allocations = arena->get_allocations(), first = f.chart.num_edges();
+	std::vector<typename g::chart_type::vertex_id> ids(f.ids);
+	const std::vector<typename g::chart_type::edge_id> added = f.chart.parallel_add_edges(5000, [&](std::size_t i)
+	{
+		std::shared_ptr<typename g::link> edge = std::allocate_shared<typename g::link>(detail::arena_allocator<typename g::link>(arena));
+		return typename g::edge_entry(edge, ids[(i*7) % ids.size()], ids[(i*13 + i/ids.size()) % ids.size()]);
+	}, n_threads);
+	BOOST_CHECK_EQUAL(f.chart.num_edges(), first + 5000);
+	BOOST_CHECK_GE(arena->get_allocations(), allocations + 5000);
+	for (std::size_t i = 0; i < added.size(); ++i)
+	{
+		BOOST_CHECK_EQUAL(f.chart.get_edge_index(added[i]), first + i);
+	}
+
+	// Released memory is reused, wherever it was taken from (the events hold the edges)
+	const std::size_t reserved = arena->get_bytes_reserved();
+	for (const typename g::chart_type::edge_id& e : added)
+	{
+		f.chart.remove_edge(e);
+	}
+	f.chart.get_observer()->flush();
+	f.listener->events.clear();
+	f.chart.parallel_add_edges(5000, [&](std::size_t i)
+	{
+		std::shared_ptr<typename g::link> edge = std::allocate_shared<typename g::link>(detail::arena_allocator<typename g::link>(arena));
+		return typename g::edge_entry(edge, ids[i % ids.size()], ids[(i + 1) % ids.size()]);
+	}, n_threads);
+	BOOST_CHECK_EQUAL(arena->get_bytes_reserved(), reserved);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(equivalence)
+{
+	for (unsigned n_threads : {1u, 2u, 3u, 4u, 0u})
+	{
+		check_equivalence<DIRECTED>(30, 500, n_threads);
+		check_equivalence<UNDIRECTED>(30, 500, n_threads);
+		check_equivalence<BIDIRECTIONAL>(30, 500, n_threads);
+	}
+	// More threads than edges, and a single vertex
+	check_equivalence<DIRECTED>(1, 3, 8);
+	check_equivalence<UNDIRECTED>(1, 3, 8);
+	check_equivalence<BIDIRECTIONAL>(1, 3, 8);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+	for (unsigned n_threads : {1u, 4u})
+	{
+		check_errors<DIRECTED>(n_threads);
+		check_errors<UNDIRECTED>(n_threads);
+		check_errors<BIDIRECTIONAL>(n_threads);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(arena_edges)
+{
+	check_arena_edges<DIRECTED>(4);
+	check_arena_edges<UNDIRECTED>(4);
+	check_arena_edges<BIDIRECTIONAL>(4);
+}
+
+BOOST_AUTO_TEST_CASE(thread_cache)
+{
+	// Memory taken through a thread cache goes back to the arena, and any thread can release it
+	detail::chart_arena arena;
+	std::vector<void*> taken;
+	{
+		detail::arena_thread_cache cache(arena);
+		for (int i = 0; i < 100; ++i)
+		{
+			taken.push_back(arena.allocate(48));
+		}
+		arena.deallocate(taken.back(), 48); // into the free list of the cache
+	}
+	BOOST_CHECK_EQUAL(arena.get_allocations(), 100u);
+	BOOST_CHECK_EQUAL(arena.get_bytes_used(), 100u*48);
+	BOOST_CHECK(arena.allocate(48) == taken.back());
+
+	std::thread other([&]
+	{
+		detail::arena_thread_cache cache(arena);
+		for (int i = 0; i < 50; ++i)
+		{
+			arena.deallocate(taken[i], 48);
+		}
+		for (int i = 0; i < 50; ++i)
+		{
+			arena.allocate(48);
+		}
+	});
+	other.join();
+	for (int i = 50; i < 99; ++i)
+	{
+		arena.deallocate(taken[i], 48);
+	}
+	const std::size_t reserved = arena.get_bytes_reserved();
+	for (int i = 50; i < 99; ++i)
+	{
+		arena.allocate(48);
+	}
+	BOOST_CHECK_EQUAL(arena.get_bytes_reserved(), reserved);
+	BOOST_CHECK_EQUAL(arena.get_bytes_used(), 100u*48);
+}
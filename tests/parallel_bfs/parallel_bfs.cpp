@@ -0,0 +1,122 @@
+#define BOOST_TEST_MODULE parallel_bfs
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <algorithm>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/breadth_first_search.hpp>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct link;
+struct node;
+typedef chart<node, link, BIDIRECTIONAL> bidirectional_chart;
+struct node : detail::vertex<link, BIDIRECTIONAL, bidirectional_chart> {};
+struct link : detail::edge<node, link, BIDIRECTIONAL, bidirectional_chart> {};
+
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS> reference_graph;
+
+void make_random(bidirectional_chart& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	for (std::size_t i = 0; i < n_vertices; ++i)
+	{
+		chart.add_vertex(std::make_shared<node>());
+	}
+	for (std::size_t i = 0; i < n_edges; ++i)
+	{
+		chart.create_edge(chart.get_vertex_at(rng() % n_vertices), chart.get_vertex_at(rng() % n_vertices));
+	}
+}
+
+reference_graph copy_of(const bidirectional_chart& chart)
+{
+	// Same graph keyed by the dense indices of the chart
+	reference_graph graph(chart.num_vertices());
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const bidirectional_chart::edge_id edge = chart.get_edge_at(e);
+		boost::add_edge(chart.get_vertex_index(chart.get_source(edge)), chart.get_vertex_index(chart.get_target(edge)), graph);
+	}
+	return graph;
+}
+
+std::size_t mismatches(const bidirectional_chart& chart, std::size_t source, unsigned n_threads)
+{
+	// Distances as boost::breadth_first_search, every parent one level up and linked by an edge
+	const reference_graph graph = copy_of(chart);
+	std::vector<std::size_t> expected(chart.num_vertices(), std::size_t(-1));
+	expected[source] = 0;
+	boost::breadth_first_search(graph, source, boost::visitor(boost::make_bfs_visitor(
+		boost::record_distances(boost::make_iterator_property_map(expected.begin(), boost::get(boost::vertex_index, graph)), boost::on_tree_edge()))));
+
+	std::vector<std::size_t> distance, parent;
+	const std::size_t reached = chart.parallel_breadth_first(chart.get_vertex_at(source), distance, parent, n_threads);
+	std::size_t errors = (reached != chart.num_vertices() - std::count(expected.begin(), expected.end(), std::size_t(-1)));
+	for (std::size_t v = 0; v < chart.num_vertices(); ++v)
+	{
+		errors += (distance[v] != expected[v]);
+		if (v == source)
+		{
+			errors += (parent[v] != source);
+		}
+		else if (expected[v] == std::size_t(-1))
+		{
+			errors += (parent[v] != std::size_t(-1));
+		}
+		else
+		{
+			errors += (parent[v] >= chart.num_vertices() || distance[parent[v]] + 1 != distance[v] || !boost::edge(parent[v], v, graph).second);
+		}
+	}
+	return errors;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(sparse_random_graphs)
+{
+	// Mostly top-down steps
+	for (unsigned seed = 0; seed < 10; ++seed)
+	{
+		bidirectional_chart chart;
+		make_random(chart, 3000, 3000, seed);
+		for (unsigned n_threads : {1u, 4u})
+		{
+			BOOST_CHECK_EQUAL(mismatches(chart, seed, n_threads), 0u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(dense_random_graphs)
+{
+	// Large frontiers switch to bottom-up steps through the incoming edges
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		bidirectional_chart chart;
+		make_random(chart, 5000, 80000, seed);
+		for (unsigned n_threads : {1u, 2u, 4u, 0u})
+		{
+			BOOST_CHECK_EQUAL(mismatches(chart, seed, n_threads), 0u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(long_chain)
+{
+	bidirectional_chart chart;
+	for (std::size_t i = 0; i < 10000; ++i)
+	{
+		chart.add_vertex(std::make_shared<node>());
+	}
+	for (std::size_t i = 0; i + 1 < chart.num_vertices(); ++i)
+	{
+		chart.create_edge(chart.get_vertex_at(i), chart.get_vertex_at(i + 1));
+	}
+	BOOST_CHECK_EQUAL(mismatches(chart, 0, 4), 0u);
+	BOOST_CHECK_EQUAL(mismatches(chart, 5000, 4), 0u); // half of it unreachable
+}
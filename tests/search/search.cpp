@@ -0,0 +1,282 @@
+#define BOOST_TEST_MODULE search
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <random>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <boost/graph/depth_first_search.hpp>
+#include <boost/graph/undirected_dfs.hpp>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	static void make_random(chart_type& chart, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		// Self-loops and parallel edges included, then some removals to reshuffle the dense indices
+		std::mt19937 rng(seed);
+		for (std::size_t i = 0; i < n_vertices; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>());
+		}
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			chart.create_edge(chart.get_vertex_at(rng() % n_vertices), chart.get_vertex_at(rng() % n_vertices));
+		}
+		for (std::size_t i = 0; i < n_vertices/10; ++i)
+		{
+			chart.remove_vertex(chart.get_vertex_at(rng() % chart.num_vertices()));
+		}
+		for (std::size_t i = 0; i < n_edges/10; ++i)
+		{
+			chart.remove_edge(chart.get_edge_at(rng() % chart.num_edges()));
+		}
+	};
+};
+
+struct everything
+{
+	template <class Descriptor>
+	bool operator()(const Descriptor&) const { return true;};
+};
+
+// Events of a traversal: (kind, dense index of the vertex or of the edge)
+enum event_kind { DISCOVER, FINISH, TREE, BACK, FORWARD_OR_CROSS, NON_TREE };
+typedef std::vector<std::pair<int, std::size_t> > trace;
+
+template <class Chart>
+struct recorder : search_visitor<Chart>
+{
+	typedef search_visitor<Chart> _t_base;
+
+	recorder(const Chart& c, trace& t) : chart(c), events(t) {};
+
+	void discover_vertex(const typename _t_base::vertex_id& v) { events.push_back(std::make_pair(DISCOVER, chart.get_vertex_index(v)));};
+	void finish_vertex(const typename _t_base::vertex_id& v) { events.push_back(std::make_pair(FINISH, chart.get_vertex_index(v)));};
+	void examine_edge(const typename _t_base::edge_id& e, typename _t_base::edge_label label)
+	{
+		int kind = NON_TREE;
+		switch (label)
+		{
+			case detail::edge_visitable::TREE_EDGE: kind = TREE; break;
+			case detail::edge_visitable::BACK_EDGE: kind = BACK; break;
+			case detail::edge_visitable::FORWARD_OR_CROSS_EDGE: kind = FORWARD_OR_CROSS; break;
+			default: break;
+		}
+		events.push_back(std::make_pair(kind, chart.get_edge_index(e)));
+	};
+
+	const Chart& chart;
+	trace& events;
+};
+
+template <class View>
+struct boost_recorder : boost::default_dfs_visitor
+{
+	// Same events from the boost visitor, edges of the view mapped back to the chart
+	boost_recorder(const View& v, trace& t) : view(v), events(&t) {};
+
+	template <class Vertex, class Graph>
+	void discover_vertex(const Vertex& v, const Graph&) { events->push_back(std::make_pair(DISCOVER, view.get_vertex_index(v)));};
+	template <class Vertex, class Graph>
+	void finish_vertex(const Vertex& v, const Graph&) { events->push_back(std::make_pair(FINISH, view.get_vertex_index(v)));};
+	template <class Edge, class Graph>
+	void tree_edge(const Edge& e, const Graph&) { this->record(TREE, e);};
+	template <class Edge, class Graph>
+	void back_edge(const Edge& e, const Graph&) { this->record(BACK, e);};
+	template <class Edge, class Graph>
+	void forward_or_cross_edge(const Edge& e, const Graph&) { this->record(FORWARD_OR_CROSS, e);};
+
+	template <class Edge>
+	void record(int kind, const Edge& e) { events->push_back(std::make_pair(kind, view.get_chart().get_edge_index(view.get_chart_edge_id(e))));};
+
+	const View& view;
+	trace* events;
+};
+
+template <class Chart>
+std::vector<typename Chart::vertex_id> vertex_list(const Chart& chart)
+{
+	// Vertices in the order boost walks them (that of the graph, not the dense indices)
+	std::vector<typename Chart::vertex_id> vertices;
+	typename boost::graph_traits<typename filtered_chart<Chart, everything>::_t_graph>::vertex_iterator it, it_end;
+	const filtered_chart<Chart, everything> view(chart, everything());
+	for (boost::tie(it, it_end) = boost::vertices(view.get_graph()); it != it_end; ++it)
+	{
+		vertices.push_back(*it);
+	}
+	return vertices;
+}
+
+template <class Chart>
+trace depth_first_forest(const Chart& chart, _e_direction direction)
+{
+	// Depth-first search from every vertex, sharing the state
+	trace events;
+	recorder<Chart> visitor(chart, events);
+	search<Chart> dfs(chart);
+	for (const typename Chart::vertex_id& v : vertex_list(chart))
+	{
+		dfs.depth_first(v, visitor, direction);
+	}
+	return events;
+}
+
+template <class View>
+trace boost_depth_first_forest(const View& view, boost::directed_tag)
+{
+	trace events;
+	std::vector<boost::default_color_type> color(view.num_vertices());
+	boost::depth_first_search(view.get_graph(), boost::visitor(boost_recorder<View>(view, events))
+		.color_map(boost::make_iterator_property_map(color.begin(), view.get_vertex_index_map())));
+	return events;
+}
+
+template <class View>
+trace boost_depth_first_forest(const View& view, boost::undirected_tag)
+{
+	trace events;
+	std::vector<boost::default_color_type> color(view.num_vertices()), edge_color(view.num_edges());
+	boost::undirected_dfs(view.get_graph(), boost::visitor(boost_recorder<View>(view, events))
+		.vertex_color_map(boost::make_iterator_property_map(color.begin(), view.get_vertex_index_map()))
+		.edge_color_map(boost::make_iterator_property_map(edge_color.begin(), view.get_edge_index_map())));
+	return events;
+}
+
+template <class View>
+trace boost_depth_first_forest(const View& view)
+{
+	return boost_depth_first_forest(view, typename boost::graph_traits<typename View::_t_graph>::directed_category());
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(depth_first_classification)
+{
+	// Same discoveries, finishes and tree/back/forward-or-cross edges as boost::depth_first_search
+	for (unsigned seed = 0; seed < 10; ++seed)
+	{
+		graph<DIRECTED>::chart_type directed;
+		graph<DIRECTED>::make_random(directed, 200, 500, seed);
+		graph<BIDIRECTIONAL>::chart_type bidirectional;
+		graph<BIDIRECTIONAL>::make_random(bidirectional, 200, 500, seed);
+
+		BOOST_CHECK(depth_first_forest(directed, FORWARDS) == boost_depth_first_forest(filtered_chart<graph<DIRECTED>::chart_type, everything>(directed, everything())));
+		BOOST_CHECK(depth_first_forest(bidirectional, FORWARDS) == boost_depth_first_forest(filtered_chart<graph<BIDIRECTIONAL>::chart_type, everything>(bidirectional, everything())));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(depth_first_undirected)
+{
+	// As boost::undirected_dfs: every edge once, TREE_EDGE or BACK_EDGE, self-loops and parallel edges included
+	typedef graph<UNDIRECTED>::chart_type chart_type;
+	for (unsigned seed = 0; seed < 10; ++seed)
+	{
+		chart_type chart;
+		graph<UNDIRECTED>::make_random(chart, 200, 300, seed);
+
+		const trace events = depth_first_forest(chart, FORWARDS);
+		BOOST_CHECK(events == boost_depth_first_forest(filtered_chart<chart_type, everything>(chart, everything())));
+		BOOST_CHECK(events == depth_first_forest(chart, BACKWARDS));
+
+		std::vector<std::size_t> reported(chart.num_edges(), 0);
+		for (const std::pair<int, std::size_t>& event : events)
+		{
+			if (event.first != DISCOVER && event.first != FINISH)
+			{
+				BOOST_CHECK(event.first == TREE || event.first == BACK);
+				++reported[event.second];
+			}
+		}
+		BOOST_CHECK(std::count(reported.begin(), reported.end(), 1u) == static_cast<std::ptrdiff_t>(chart.num_edges()));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(depth_first_backwards)
+{
+	// BACKWARDS walks the incoming edges: boost::depth_first_search on the reversed chart
+	typedef graph<BIDIRECTIONAL>::chart_type chart_type;
+	for (unsigned seed = 0; seed < 10; ++seed)
+	{
+		chart_type chart;
+		graph<BIDIRECTIONAL>::make_random(chart, 200, 500, seed);
+		BOOST_CHECK(depth_first_forest(chart, BACKWARDS) == boost_depth_first_forest(reversed_chart<chart_type>(chart)));
+	}
+
+	graph<DIRECTED>::chart_type directed;
+	graph<DIRECTED>::make_random(directed, 10, 20, 0);
+	BOOST_CHECK_THROW(depth_first_forest(directed, BACKWARDS), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(breadth_first_backwards)
+{
+	// Reached vertices and tree edges follow the incoming edges
+	typedef graph<BIDIRECTIONAL>::chart_type chart_type;
+	chart_type chart;
+	std::vector<chart_type::vertex_id> v;
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		v.push_back(chart.add_vertex(std::make_shared<graph<BIDIRECTIONAL>::node>()).first);
+	}
+	const chart_type::edge_id a = chart.create_edge(v[0], v[1]).first;
+	const chart_type::edge_id b = chart.create_edge(v[1], v[2]).first;
+	chart.create_edge(v[2], v[3]);
+
+	trace forwards, backwards;
+	recorder<chart_type> forwards_visitor(chart, forwards), backwards_visitor(chart, backwards);
+	search<chart_type> bfs(chart);
+	bfs.breadth_first(v[2], backwards_visitor, BACKWARDS);
+	BOOST_CHECK(bfs.is_discovered(v[0]) && bfs.is_discovered(v[1]) && !bfs.is_discovered(v[3]));
+	const trace expected = {{DISCOVER, chart.get_vertex_index(v[2])}, {TREE, chart.get_edge_index(b)}, {DISCOVER, chart.get_vertex_index(v[1])}, {FINISH, chart.get_vertex_index(v[2])},
+	                        {TREE, chart.get_edge_index(a)}, {DISCOVER, chart.get_vertex_index(v[0])}, {FINISH, chart.get_vertex_index(v[1])}, {FINISH, chart.get_vertex_index(v[0])}};
+	BOOST_CHECK(backwards == expected);
+
+	bfs.reset();
+	bfs.breadth_first(v[2], forwards_visitor, FORWARDS);
+	BOOST_CHECK(!bfs.is_discovered(v[0]) && !bfs.is_discovered(v[1]) && bfs.is_discovered(v[3]));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_searches)
+{
+	// Several searches at the same time on one chart, each its own state, same traces as alone
+	typedef graph<BIDIRECTIONAL>::chart_type chart_type;
+	chart_type chart;
+	graph<BIDIRECTIONAL>::make_random(chart, 2000, 6000, 1);
+	const trace forwards = depth_first_forest(chart, FORWARDS);
+	const trace backwards = depth_first_forest(chart, BACKWARDS);
+
+	const unsigned n_threads = 4;
+	std::vector<trace> traces(n_threads);
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < n_threads; ++t)
+	{
+		threads.push_back(std::thread([&chart, &traces, t]()
+		{
+			for (unsigned round = 0; round < 5; ++round)
+			{
+				traces[t] = depth_first_forest(chart, t % 2 ? BACKWARDS : FORWARDS);
+			}
+		}));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	for (unsigned t = 0; t < n_threads; ++t)
+	{
+		BOOST_CHECK(traces[t] == (t % 2 ? backwards : forwards));
+	}
+}
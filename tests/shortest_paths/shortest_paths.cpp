@@ -0,0 +1,221 @@
+#define BOOST_TEST_MODULE shortest_paths
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <limits>
+#include <stdexcept>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/dijkstra_shortest_paths.hpp>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+struct length { unsigned value;};
+
+struct road;
+struct town;
+typedef chart<town, road, BIDIRECTIONAL> road_chart;
+struct town : detail::vertex<road, BIDIRECTIONAL, road_chart> {};
+struct road : detail::edge<town, road, BIDIRECTIONAL, road_chart, length>
+{
+	road(unsigned value) : detail::edge<town, road, BIDIRECTIONAL, road_chart, length>(std::make_shared<length>(length{value})) {};
+};
+
+// Integer weights: distances are exact, whatever the order of the relaxations
+typedef unsigned long distance_type;
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, boost::no_property, boost::property<boost::edge_weight_t, distance_type> > reference_graph;
+
+struct length_of
+{
+	unsigned operator()(const length& l) const { return l.value;};
+};
+
+void add_towns(road_chart& chart, std::size_t n)
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		chart.add_vertex(std::make_shared<town>());
+	}
+}
+
+void add_road(road_chart& chart, std::size_t source, std::size_t target, unsigned value)
+{
+	chart.add_edge(std::make_shared<road>(value), chart.get_vertex_at(source), chart.get_vertex_at(target));
+}
+
+void make_random(road_chart& chart, std::size_t n_vertices, std::size_t n_edges, unsigned max_length, unsigned seed)
+{
+	// Lengths in [0, max_length), zero included
+	std::mt19937 rng(seed);
+	add_towns(chart, n_vertices);
+	for (std::size_t i = 0; i < n_edges; ++i)
+	{
+		add_road(chart, rng() % n_vertices, rng() % n_vertices, rng() % max_length);
+	}
+}
+
+reference_graph copy_of(const road_chart& chart)
+{
+	// Same graph keyed by the dense indices of the chart
+	reference_graph graph(chart.num_vertices());
+	for (std::size_t e = 0; e < chart.num_edges(); ++e)
+	{
+		const road_chart::edge_id edge = chart.get_edge_at(e);
+		boost::add_edge(chart.get_vertex_index(chart.get_source(edge)), chart.get_vertex_index(chart.get_target(edge)),
+		                chart.get_edge(edge)->get_obj().value, graph);
+	}
+	return graph;
+}
+
+std::size_t mismatches(const reference_graph& graph, std::size_t source, const std::vector<distance_type>& distance, const std::vector<std::size_t>& parent, std::size_t reached)
+{
+	// Distances as boost::dijkstra_shortest_paths, every parent linked by an edge that gives the distance
+	const std::size_t n = boost::num_vertices(graph);
+	std::vector<distance_type> expected(n);
+	boost::dijkstra_shortest_paths(graph, source, boost::distance_map(boost::make_iterator_property_map(expected.begin(), boost::get(boost::vertex_index, graph))));
+
+	std::size_t errors = (distance.size() != n) + (parent.size() != n);
+	if (errors)
+	{
+		return errors;
+	}
+	std::size_t n_reached = 0;
+	for (std::size_t v = 0; v < n; ++v)
+	{
+		if (expected[v] == std::numeric_limits<distance_type>::max())
+		{
+			errors += (distance[v] != expected[v]) + (parent[v] != std::size_t(-1));
+			continue;
+		}
+		++n_reached;
+		errors += (distance[v] != expected[v]);
+		if (v == source)
+		{
+			errors += (parent[v] != source);
+			continue;
+		}
+		bool linked = false;
+		if (parent[v] < n)
+		{
+			reference_graph::out_edge_iterator it, it_end;
+			for (boost::tie(it, it_end) = boost::out_edges(parent[v], graph); it != it_end && !linked; ++it)
+			{
+				linked = (boost::target(*it, graph) == v && distance[parent[v]] + boost::get(boost::edge_weight, graph, *it) == distance[v]);
+			}
+		}
+		errors += !linked;
+	}
+	return errors + (reached != n_reached);
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(dijkstra_matches_boost)
+{
+	for (unsigned seed = 0; seed < 10; ++seed)
+	{
+		road_chart chart;
+		make_random(chart, 2000, 8000, 10, seed);
+		const reference_graph graph = copy_of(chart);
+
+		std::vector<distance_type> distance;
+		std::vector<std::size_t> parent;
+		const std::size_t reached = chart.dijkstra_shortest_paths<distance_type>(chart.get_vertex_at(seed), length_of(), distance, parent);
+		BOOST_CHECK_EQUAL(mismatches(graph, seed, distance, parent, reached), 0u);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(delta_stepping_matches_boost)
+{
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		road_chart chart;
+		make_random(chart, 2000, 8000, 10, seed);
+		const reference_graph graph = copy_of(chart);
+
+		for (distance_type delta : {1ul, 3ul, 50ul})
+		{
+			for (unsigned n_threads : {1u, 4u, 0u})
+			{
+				std::vector<distance_type> distance;
+				std::vector<std::size_t> parent;
+				const std::size_t reached = chart.delta_stepping_shortest_paths<distance_type>(chart.get_vertex_at(seed), length_of(), delta, distance, parent, n_threads);
+				BOOST_CHECK_EQUAL(mismatches(graph, seed, distance, parent, reached), 0u);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(long_chain_with_small_delta)
+{
+	// Far more buckets than the ring of every thread holds at a time
+	road_chart chart;
+	add_towns(chart, 5000);
+	for (std::size_t i = 0; i + 1 < chart.num_vertices(); ++i)
+	{
+		add_road(chart, i, i + 1, 1 + i % 7);
+		add_road(chart, i + 1, i, 100);
+	}
+	const reference_graph graph = copy_of(chart);
+
+	std::vector<distance_type> distance;
+	std::vector<std::size_t> parent;
+	std::size_t reached = chart.delta_stepping_shortest_paths<distance_type>(chart.get_vertex_at(0), length_of(), 1ul, distance, parent, 4);
+	BOOST_CHECK_EQUAL(mismatches(graph, 0, distance, parent, reached), 0u);
+	reached = chart.dijkstra_shortest_paths<distance_type>(chart.get_vertex_at(2500), length_of(), distance, parent);
+	BOOST_CHECK_EQUAL(mismatches(graph, 2500, distance, parent, reached), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(tiny_delta_against_large_weights)
+{
+	// Millions of buckets between the lowest one and the furthest reached: most of them wait in the far list
+	road_chart chart;
+	make_random(chart, 1000, 4000, 5000000, 11);
+	const reference_graph graph = copy_of(chart);
+
+	for (unsigned n_threads : {1u, 4u})
+	{
+		std::vector<distance_type> distance;
+		std::vector<std::size_t> parent;
+		const std::size_t reached = chart.delta_stepping_shortest_paths<distance_type>(chart.get_vertex_at(0), length_of(), 1ul, distance, parent, n_threads);
+		BOOST_CHECK_EQUAL(mismatches(graph, 0, distance, parent, reached), 0u);
+	}
+}
+
+struct faulty_length
+{
+	unsigned operator()(const length& l) const
+	{
+		if (l.value == 7)
+		{
+			throw std::invalid_argument("faulty length");
+		}
+		return l.value;
+	};
+};
+
+BOOST_AUTO_TEST_CASE(weight_exceptions_reach_the_caller)
+{
+	road_chart chart;
+	make_random(chart, 2000, 8000, 10, 3);
+	std::vector<distance_type> distance;
+	std::vector<std::size_t> parent;
+	for (unsigned n_threads : {1u, 4u})
+	{
+		BOOST_CHECK_THROW(chart.delta_stepping_shortest_paths<distance_type>(chart.get_vertex_at(0), faulty_length(), 3ul, distance, parent, n_threads), std::invalid_argument);
+	}
+	BOOST_CHECK_THROW(chart.dijkstra_shortest_paths<distance_type>(chart.get_vertex_at(0), faulty_length(), distance, parent), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(delta_must_be_positive)
+{
+	road_chart chart;
+	add_towns(chart, 2);
+	add_road(chart, 0, 1, 1);
+	std::vector<distance_type> distance;
+	std::vector<std::size_t> parent;
+	BOOST_CHECK_THROW(chart.delta_stepping_shortest_paths<distance_type>(chart.get_vertex_at(0), length_of(), 0ul, distance, parent), std::runtime_error);
+}
@@ -0,0 +1,238 @@
+#define BOOST_TEST_MODULE strong_components
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <algorithm>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/strong_components.hpp>
+
+#include "chart_impl.hpp"
+
+using namespace core::graph;
+
+namespace {
+
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS> reference_graph;
+
+template <int Behaviour>
+struct graph
+{
+	struct link;
+	struct node;
+	typedef chart<node, link, Behaviour> chart_type;
+	struct node : detail::vertex<link, Behaviour, chart_type> {};
+	struct link : detail::edge<node, link, Behaviour, chart_type> {};
+
+	static void add_nodes(chart_type& chart, reference_graph& reference, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			chart.add_vertex(std::make_shared<node>());
+			boost::add_vertex(reference);
+		}
+	};
+
+	static void add_link(chart_type& chart, reference_graph& reference, std::size_t source, std::size_t target)
+	{
+		// No removals: dense indices are the order of creation, as in the reference graph
+		chart.create_edge(chart.get_vertex_at(source), chart.get_vertex_at(target));
+		boost::add_edge(source, target, reference);
+	};
+
+	static void make_random(chart_type& chart, reference_graph& reference, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		add_nodes(chart, reference, n_vertices);
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			add_link(chart, reference, rng() % n_vertices, rng() % n_vertices);
+		}
+	};
+
+	static void make_dag(chart_type& chart, reference_graph& reference, std::size_t n_vertices, std::size_t n_edges, unsigned seed)
+	{
+		// Edges go from a lower to a higher rank, ranks shuffled over the indices
+		std::mt19937 rng(seed);
+		std::vector<std::size_t> rank(n_vertices);
+		for (std::size_t v = 0; v < n_vertices; ++v)
+		{
+			rank[v] = v;
+		}
+		std::shuffle(rank.begin(), rank.end(), rng);
+		add_nodes(chart, reference, n_vertices);
+		for (std::size_t i = 0; i < n_edges; ++i)
+		{
+			std::size_t a = rng() % n_vertices, b = rng() % n_vertices;
+			if (a != b)
+			{
+				add_link(chart, reference, rank[std::min(a, b)], rank[std::max(a, b)]);
+			}
+		}
+	};
+};
+
+std::size_t partition_mismatches(const reference_graph& reference, const std::vector<std::size_t>& component, std::size_t n_components)
+{
+	// Same partition as boost::strong_components, whatever the numbering
+	std::vector<std::size_t> expected(boost::num_vertices(reference));
+	const std::size_t n_expected = boost::strong_components(reference, boost::make_iterator_property_map(expected.begin(), boost::get(boost::vertex_index, reference)));
+	if (n_components != n_expected || component.size() != expected.size())
+	{
+		return 1;
+	}
+	std::vector<std::size_t> to_expected(n_components, std::size_t(-1)), from_expected(n_expected, std::size_t(-1));
+	std::size_t errors = 0;
+	for (std::size_t v = 0; v < component.size(); ++v)
+	{
+		if (component[v] >= n_components)
+		{
+			return 1;
+		}
+		if (to_expected[component[v]] == std::size_t(-1) && from_expected[expected[v]] == std::size_t(-1))
+		{
+			to_expected[component[v]] = expected[v];
+			from_expected[expected[v]] = component[v];
+		}
+		errors += (to_expected[component[v]] != expected[v] || from_expected[expected[v]] != component[v]);
+	}
+	return errors;
+}
+
+std::size_t order_mismatches(const reference_graph& reference, const std::vector<std::size_t>& component)
+{
+	// Reverse topological numbering: edges between components go to a lower number
+	std::size_t errors = 0;
+	reference_graph::edge_iterator it, it_end;
+	for (boost::tie(it, it_end) = boost::edges(reference); it != it_end; ++it)
+	{
+		errors += (component[boost::source(*it, reference)] < component[boost::target(*it, reference)]);
+	}
+	return errors;
+}
+
+std::size_t topological_mismatches(const reference_graph& reference, const std::vector<std::size_t>& order)
+{
+	// A permutation of the vertices where every edge goes forwards
+	std::vector<std::size_t> position(boost::num_vertices(reference), std::size_t(-1));
+	if (order.size() != position.size())
+	{
+		return 1;
+	}
+	std::size_t errors = 0;
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		errors += (order[i] >= position.size() || position[order[i]] != std::size_t(-1));
+		if (order[i] < position.size())
+		{
+			position[order[i]] = i;
+		}
+	}
+	reference_graph::edge_iterator it, it_end;
+	for (boost::tie(it, it_end) = boost::edges(reference); it != it_end; ++it)
+	{
+		errors += (position[boost::source(*it, reference)] >= position[boost::target(*it, reference)]);
+	}
+	return errors;
+}
+
+template <int Behaviour>
+void check_random(unsigned seed)
+{
+	// From many small components to a giant one
+	for (std::size_t n_edges : {1000u, 2000u, 4000u})
+	{
+		typename graph<Behaviour>::chart_type chart;
+		reference_graph reference;
+		graph<Behaviour>::make_random(chart, reference, 2000, n_edges, seed);
+
+		std::vector<std::size_t> component;
+		std::size_t n_components = chart.strong_components(component);
+		BOOST_CHECK_EQUAL(partition_mismatches(reference, component, n_components), 0u);
+		BOOST_CHECK_EQUAL(order_mismatches(reference, component), 0u);
+		for (unsigned n_threads : {1u, 4u, 0u})
+		{
+			n_components = chart.strong_components(component, n_threads);
+			BOOST_CHECK_EQUAL(partition_mismatches(reference, component, n_components), 0u);
+		}
+
+		// Acyclic iff every component is a single vertex without a loop
+		bool loops = false;
+		reference_graph::edge_iterator it, it_end;
+		for (boost::tie(it, it_end) = boost::edges(reference); it != it_end; ++it)
+		{
+			loops |= (boost::source(*it, reference) == boost::target(*it, reference));
+		}
+		std::vector<std::size_t> order;
+		BOOST_CHECK_EQUAL(chart.topological_order(order), n_components == chart.num_vertices() && !loops);
+	}
+}
+
+template <int Behaviour>
+void check_dag(unsigned seed)
+{
+	typename graph<Behaviour>::chart_type chart;
+	reference_graph reference;
+	graph<Behaviour>::make_dag(chart, reference, 2000, 6000, seed);
+
+	std::vector<std::size_t> order;
+	BOOST_REQUIRE(chart.topological_order(order));
+	BOOST_CHECK_EQUAL(topological_mismatches(reference, order), 0u);
+
+	// One edge backwards closes a cycle
+	graph<Behaviour>::add_link(chart, reference, order.back(), order.front());
+	graph<Behaviour>::add_link(chart, reference, order.front(), order.back());
+	BOOST_CHECK(!chart.topological_order(order));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(directed_random_graphs)
+{
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		check_random<DIRECTED>(seed);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(bidirectional_random_graphs)
+{
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		check_random<BIDIRECTIONAL>(seed);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(topological_order_of_dags)
+{
+	for (unsigned seed = 0; seed < 5; ++seed)
+	{
+		check_dag<DIRECTED>(seed);
+		check_dag<BIDIRECTIONAL>(seed);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(deep_graphs)
+{
+	// Recursive versions would overflow the stack: a long path closed into a cycle
+	typedef graph<DIRECTED> deep;
+	deep::chart_type chart;
+	reference_graph reference;
+	const std::size_t n = 500000;
+	deep::add_nodes(chart, reference, n);
+	for (std::size_t v = 0; v + 1 < n; ++v)
+	{
+		deep::add_link(chart, reference, v, v + 1);
+	}
+
+	std::vector<std::size_t> order;
+	BOOST_REQUIRE(chart.topological_order(order));
+	BOOST_CHECK_EQUAL(topological_mismatches(reference, order), 0u);
+	std::vector<std::size_t> component;
+	BOOST_CHECK_EQUAL(chart.strong_components(component), n);
+	BOOST_CHECK_EQUAL(order_mismatches(reference, component), 0u);
+
+	deep::add_link(chart, reference, n - 1, 0);
+	BOOST_CHECK_EQUAL(chart.strong_components(component), 1u);
+	BOOST_CHECK_EQUAL(chart.strong_components(component, 4), 1u);
+	BOOST_CHECK(!chart.topological_order(order));
+}